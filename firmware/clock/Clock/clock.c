@@ -16,6 +16,9 @@
 #include "flash_drv.h"
 #include "onewire_bridge_drv.h"
 #include "ext_temp_sens_drv.h"
+#include "i2c_drv.h"
+#include "scheduler.h"
+#include "rtc_sync.h"
 
 #include "../Core/Inc/iwdg.h"
 
@@ -44,16 +47,34 @@ volatile uint32_t	clock_set_inactivity_counter = 0;
 volatile uint8_t	halt_rtc_read = FALSE;
 
 volatile uint8_t	update_flag = FALSE;
-volatile uint32_t	update_counter = 0;
+
+volatile uint8_t	rtc_read_pending = FALSE;
+
+#ifdef DEBUG
+volatile uint32_t	run_loop_time = 0;
+volatile uint32_t	run_loop_time_max = 0;
+#endif
 
 volatile uint8_t	ext_temp_is_present		= FALSE;
-volatile uint8_t	ext_temp_conv_triggered	= FALSE;
+volatile uint8_t	ext_temp_measurement_pending	= FALSE;
 
 volatile uint32_t	int_ext_temp_cycling_counter = 0;
 volatile uint8_t	int_ext_temp_cycling_flag = FALSE;
 
+inline static void Manage_RTC_read(void);
+inline static void Manage_RTC_requests(void);
+inline static void Manage_ext_temp(void);
+inline static void Copy_RTC_data_to_display(void);
+inline static uint8_t Is_RTC_time_equal(volatile struct rtc_data_struct *a, volatile struct rtc_data_struct *b);
 inline static void Manage_periodic_updates(void);
 
+static void LED_data_update_task(void);
+static void LED_cfg_update_task(void);
+static void RTC_temp_conv_trigger_task(void);
+static void RTC_temp_read_task(void);
+static void Ext_temp_conv_trigger_task(void);
+static void Counters_update_task(void);
+
 inline static void Normal_mode(void);
 inline static void Hour_set_mode(void);
 inline static void Minute_set_mode(void);
@@ -76,10 +97,26 @@ inline static void Manage_int_ext_temp_cycling(void);
 
 inline static void Go_to_normal_mode(void);
 
+/* Periodic tasks, run in order of the table when due */
+#define NUM_OF_PERIODIC_TASKS	6
+
+struct task_struct periodic_tasks[NUM_OF_PERIODIC_TASKS] =
+{
+	{LED_data_update_task,			LED_DATA_UPDATE_PERIOD,		LED_DATA_UPDATE_PHASE,			SCHEDULER_US_TO_COUNTS(LED_DATA_UPDATE_DEADLINE), 0, 0, 0},
+	{LED_cfg_update_task,			LED_CFG_UPDATE_PERIOD,		LED_CFG_UPDATE_PHASE,			SCHEDULER_US_TO_COUNTS(LED_CFG_UPDATE_DEADLINE), 0, 0, 0},
+	{RTC_temp_conv_trigger_task,	RTC_TEMP_PERIOD,			RTC_TEMP_CONV_TRIGGER_PHASE,	SCHEDULER_US_TO_COUNTS(RTC_TEMP_DEADLINE), 0, 0, 0},
+	{RTC_temp_read_task,			RTC_TEMP_PERIOD,			RTC_TEMP_DATA_READ_PHASE,		SCHEDULER_US_TO_COUNTS(RTC_TEMP_DEADLINE), 0, 0, 0},
+	{Ext_temp_conv_trigger_task,	EXT_TEMP_PERIOD,			EXT_TEMP_CONV_TRIGGER_PHASE,	SCHEDULER_US_TO_COUNTS(EXT_TEMP_DEADLINE), 0, 0, 0},
+	{Counters_update_task,			COUNTERS_UPDATE_PERIOD,		COUNTERS_UPDATE_PHASE,			SCHEDULER_US_TO_COUNTS(COUNTERS_UPDATE_DEADLINE), 0, 0, 0}
+};
+
 void Set_update_display_flag(void)
 {
 	update_flag = TRUE;
 
+	/* Advance scheduler time */
+	Scheduler_tick();
+
 	LL_TIM_ClearFlag_UPDATE(TIM14);
 
 	NVIC_ClearPendingIRQ(TIM14_IRQn);
@@ -100,6 +137,9 @@ void Init(void)
 	ENABLE_KBD_TIMER;
 	CLEAR_KBD_TIMER;
 
+	/* Initialize I2C transfers in the background */
+	Init_I2C();
+
 	/* Initialize RTC */
 	Init_RTC();
 
@@ -109,6 +149,12 @@ void Init(void)
 	LL_TIM_ClearFlag_UPDATE(TIM14);
 	LL_TIM_EnableIT_UPDATE(TIM14);
 
+	/* Schedule periodic tasks */
+	Init_scheduler(periodic_tasks, NUM_OF_PERIODIC_TASKS);
+
+	/* Start tracking RTC seconds */
+	Init_RTC_sync();
+
 	/* Clear display data structure */
 	display_data.hour = 0;
 	display_data.minute = 0;
@@ -116,9 +162,9 @@ void Init(void)
 
 	display_data.hour_colon = TRUE;
 
-	display_data.date = 1;
-	display_data.month = 1;
-	display_data.year = 0;
+	display_data.date = 0x01;
+	display_data.month = 0x01;
+	display_data.year = 0x00;
 
 	display_data.int_temperature = 0;
 	display_data.ext_temperature = 0;
@@ -131,7 +177,7 @@ void Init(void)
 	if(Init_OneWire_bridge() == TRUE)
 	{
 		/* Update presence flag */
-		ext_temp_is_present = Init_ext_temp_sens();
+		ext_temp_is_present = Init_ext_temp_sens(clock_settings.ext_temp_resolution);
 	}
 
 	Clear_int_ext_temp_cycling_counter();
@@ -148,9 +194,25 @@ void Init(void)
 
 void Run(void)
 {
-	/* Manage RTC, LED display updates */
+#ifdef DEBUG
+	uint32_t run_loop_start = Get_scheduler_time();
+#endif
+
+	/* Check I2C timeout */
+	Manage_I2C();
+
+	/* Manage RTC reads, phase locked to seconds */
+	Manage_RTC_read();
+
+	/* Advance queued RTC temperature and time set transfers */
+	Manage_RTC_requests();
+
+	/* Manage LED display updates */
 	Manage_periodic_updates();
 
+	/* Advance external temperature sequence, yields bus to RTC reads */
+	Manage_ext_temp();
+
 	/* Handle current mode */
 	switch(current_clock_mode)
 	{
@@ -200,107 +262,252 @@ void Run(void)
 
 	/* Poke WDT */
 	LL_IWDG_ReloadCounter(IWDG);
+
+#ifdef DEBUG
+	/* Main loop latency, compare with RTC_READ_ASYNC set to FALSE */
+	run_loop_time = Get_scheduler_time() - run_loop_start;
+
+	if(run_loop_time > run_loop_time_max)
+	{
+		run_loop_time_max = run_loop_time;
+	}
+#endif
 }
 
 inline static void Manage_periodic_updates(void)
 {
-	int8_t ext_temp_data = 0;
-
 	/* Check update flag */
 	if(update_flag == TRUE)
 	{
-		/* Check RTC read match */
-		if((update_counter % RTC_READ_MODULO) == RTC_READ_OFFSET)
+		/* Run tasks due in this tick */
+		Run_scheduler(periodic_tasks, NUM_OF_PERIODIC_TASKS, Get_scheduler_tick());
+
+		/* Clear flag */
+		update_flag = FALSE;
+	}
+}
+
+inline static void Manage_RTC_read(void)
+{
+	/* Advance time on square wave edges or predicted rollovers */
+	uint8_t elapsed_seconds = Take_RTC_elapsed_seconds();
+
+	if(elapsed_seconds > 0)
+	{
+		/* Keep time running also when clock is being set */
+		while(elapsed_seconds > 0)
 		{
-			/* Match. Check if RTC read is not halted */
-			if(halt_rtc_read == FALSE)
-			{
-				/* Not halted */
-
-				/* Get data from RTC */
-				if(Get_RTC_data(&rtc_data) == TRUE)
-				{
-					/* Update only if read was successful */
-
-					/* Copy data from RTC */
-					display_data.second				= rtc_data.second;
-					display_data.minute				= rtc_data.minute;
-					display_data.hour				= rtc_data.hour;
-					display_data.date				= rtc_data.date;
-					display_data.month				= rtc_data.month;
-					display_data.year				= rtc_data.year;
-					display_data.int_temperature	= rtc_data.temperature;
-
-					/* Manage colon */
-					display_data.hour_colon = ((rtc_data.second % 2) == 1) ? FALSE : TRUE;
-				}
-			}
+			Advance_RTC_time(&rtc_data);
+			elapsed_seconds--;
 		}
 
-		/* Check LED data update match */
-		if((update_counter % LED_DATA_UPDATE_MODULO) == LED_DATA_UPDATE_OFFSET)
+		if(halt_rtc_read == FALSE)
 		{
-			/* Perform LED data update */
+			Copy_RTC_data_to_display();
+
+			/* Show new second right away */
 			Update_display_data(&display_data);
+
+			RTC_sync_displayed();
 		}
+	}
 
-		/* Check LED configuration update match */
-		if((update_counter % LED_CFG_UPDATE_MODULO) == LED_CFG_UPDATE_OFFSET)
+	/* Check if it is time to read RTC */
+	if((rtc_read_pending == FALSE) && (Is_RTC_read_due() == TRUE))
+	{
+		/* Check if RTC read is not halted, start reading RTC in the background */
+		if((halt_rtc_read == FALSE) && (Start_RTC_data_read() == TRUE))
 		{
-			/* Perform LED data update */
-			Update_display_config(&display_data);
+			rtc_read_pending = TRUE;
 		}
+		else
+		{
+			RTC_sync_no_data();
+		}
+	}
 
-		/* Check external temperature conversion trigger match */
-		if(update_counter == EXT_TEMP_CONV_TRIGGER_CNT)
+	if(rtc_read_pending == TRUE)
+	{
+		/* DS3231 latches time at the start of the transfer */
+		uint32_t read_time;
+		struct rtc_data_struct read_data;
+
+#if RTC_READ_ASYNC == FALSE
+		/* Wait for data, blocking main loop */
+		while(Is_I2C_idle() == FALSE)
 		{
-			/* Check if external temperature sensor is present */
-			if(ext_temp_is_present == TRUE)
-			{
-				/* Start external temperature conversion */
-				ext_temp_conv_triggered = Ext_temp_start_conversion();
-			}
+			Manage_I2C();
 		}
+#endif
 
-		/* Check external temperature read match */
-		if(update_counter == EXT_TEMP_DATA_READ_CNT)
+		uint8_t read_status = Get_RTC_data_read(&read_data, &read_time);
+
+		if((read_status == I2C_REQ_DONE) && (halt_rtc_read == FALSE))
 		{
-			/* Check if external temperature sensor is present and conversion was triggered */
-			if((ext_temp_is_present == TRUE) && (ext_temp_conv_triggered == TRUE))
+			/* Update only if read was successful */
+			rtc_read_pending = FALSE;
+
+			/* RTC may be at most one second ahead of time kept in RAM */
+			struct rtc_data_struct next_data = rtc_data;
+			Advance_RTC_time(&next_data);
+
+			uint8_t time_matches = ((Is_RTC_time_equal(&read_data, &rtc_data) == TRUE) ||
+					(Is_RTC_time_equal(&read_data, &next_data) == TRUE)) ? TRUE : FALSE;
+
+			/* RTC is the reference */
+			rtc_data = read_data;
+
+			/* Copy data from RTC */
+			Copy_RTC_data_to_display();
+
+			/* Track seconds rollover */
+			if(RTC_sync_update(rtc_data.second, read_time, time_matches) == TRUE)
 			{
-				/* Read external temperature */
-				if(Ext_temp_read_temperature(&ext_temp_data) == TRUE)
-				{
-					/* Update display data */
-					display_data.ext_temperature = ext_temp_data;
-				}
-
-				/* Clear conversion triggered flag */
-				ext_temp_conv_triggered = FALSE;
+				/* New second, show it right away */
+				Update_display_data(&display_data);
+
+				RTC_sync_displayed();
 			}
 		}
+		else if((read_status != I2C_REQ_QUEUED) && (read_status != I2C_REQ_BUSY))
+		{
+			/* Failed, or clock is being set */
+			rtc_read_pending = FALSE;
+
+			RTC_sync_no_data();
+		}
+	}
 
-		/* Store settings if necessary */
-		Manage_store_settings();
+	/* Measure rollover to display latency */
+	Manage_RTC_sync_latency();
+}
 
-		/* Exit clock set mode if no changes were made for 10s */
-		Manage_clock_set_inactivity();
+inline static void Manage_RTC_requests(void)
+{
+	/* One step per pass, new temperature is shown with next second */
+	Manage_RTC(&rtc_data);
 
-		/* Manage internal/external temperature cycling */
-		Manage_int_ext_temp_cycling();
+#if RTC_READ_ASYNC == FALSE
+	/* Wait for remaining steps, blocking main loop */
+	while(Is_RTC_idle() == FALSE)
+	{
+		Manage_I2C();
+		Manage_RTC(&rtc_data);
+	}
+#endif
+}
 
-		/* Clear flag */
-		update_flag = FALSE;
+inline static void Manage_ext_temp(void)
+{
+	uint8_t ext_temp_status;
+	int16_t ext_temp_data = 0;
+
+	if(Is_ext_temp_busy() == FALSE)
+	{
+		/* Nothing to do */
+		return;
+	}
+
+	if(Get_RTC_time_to_read() <= SCHEDULER_US_TO_COUNTS(EXT_TEMP_STEP_BUDGET))
+	{
+		/* DS2482 transfer could delay RTC read, wait until it is done */
+		return;
+	}
+
+	/* One DS2482 state machine step per pass */
+	ext_temp_status = Ext_temp_step();
+
+	if(ext_temp_status == EXT_TEMP_FAILED)
+	{
+		/* Conversion not started or not finished */
+		ext_temp_measurement_pending = FALSE;
+	}
+	else if((ext_temp_status == EXT_TEMP_DONE) && (ext_temp_measurement_pending == TRUE))
+	{
+		/* Read external temperature of displayed sensor, as soon as conversion is done */
+		if(Ext_temp_read_temperature(0, &ext_temp_data) == TRUE)
+		{
+			/* Update display data */
+			display_data.ext_temperature = ext_temp_data;
+		}
+
+		ext_temp_measurement_pending = FALSE;
+	}
+}
 
-		/* Advance update counter */
-		update_counter++;
-		if(update_counter >= UPDATE_FREQUENCY)
+inline static void Copy_RTC_data_to_display(void)
+{
+	display_data.second				= rtc_data.second;
+	display_data.minute				= rtc_data.minute;
+	display_data.hour				= rtc_data.hour;
+	display_data.date				= rtc_data.date;
+	display_data.month				= rtc_data.month;
+	display_data.year				= rtc_data.year;
+	display_data.int_temperature	= rtc_data.temperature;
+
+	/* Manage colon */
+	display_data.hour_colon = (rtc_data.second & 0x01) ? FALSE : TRUE;
+}
+
+inline static uint8_t Is_RTC_time_equal(volatile struct rtc_data_struct *a, volatile struct rtc_data_struct *b)
+{
+	return ((a->second == b->second) && (a->minute == b->minute) && (a->hour == b->hour) &&
+			(a->date == b->date) && (a->month == b->month) && (a->year == b->year)) ? TRUE : FALSE;
+}
+
+static void LED_data_update_task(void)
+{
+	/* Perform LED data update */
+	Update_display_data(&display_data);
+}
+
+static void LED_cfg_update_task(void)
+{
+	/* Perform LED configuration update */
+	Update_display_config(&display_data);
+}
+
+static void RTC_temp_conv_trigger_task(void)
+{
+#if RTC_TEMP_FORCE_CONV == TRUE
+	/* Start RTC temperature conversion, so value read is fresh, sent by Manage_RTC_requests */
+	Start_RTC_temp_conversion();
+#endif
+}
+
+static void RTC_temp_read_task(void)
+{
+	/* Read RTC temperature in the background, shown with next second */
+	Start_RTC_temp_read();
+}
+
+static void Ext_temp_conv_trigger_task(void)
+{
+	/* Check if external temperature sensor is present */
+	if(ext_temp_is_present == TRUE)
+	{
+		/* Start external temperature conversion, sent in steps by Manage_ext_temp */
+		/* and read right after sensors report it is done */
+		/* Busy with previous measurement, keep it pending to show its result */
+		if(Ext_temp_start_measurement() == TRUE)
 		{
- 			update_counter = 0;
+			ext_temp_measurement_pending = TRUE;
 		}
 	}
 }
 
+static void Counters_update_task(void)
+{
+	/* Store settings if necessary */
+	Manage_store_settings();
+
+	/* Exit clock set mode if no changes were made for 10s */
+	Manage_clock_set_inactivity();
+
+	/* Manage internal/external temperature cycling */
+	Manage_int_ext_temp_cycling();
+}
+
 inline static void Normal_mode(void)
 {
 	/* Read RTC */
@@ -421,7 +628,7 @@ inline static void Hour_set_mode(void)
 		else if(PLUS_KEY_IS_PRESSED)
 		{
 			/* Increment hour */
-			Inc_value_with_rewind(&display_data.hour, 0, 23);
+			Inc_BCD_value_with_rewind(&display_data.hour, 0x00, 0x23);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
@@ -431,7 +638,7 @@ inline static void Hour_set_mode(void)
 		else if(MINUS_KEY_IS_PRESSED)
 		{
 			/* Decrement hour */
-			Dec_value_with_rewind(&display_data.hour, 0, 23);
+			Dec_BCD_value_with_rewind(&display_data.hour, 0x00, 0x23);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
@@ -472,7 +679,7 @@ inline static void Minute_set_mode(void)
 		else if(PLUS_KEY_IS_PRESSED)
 		{
 			/* Increment minute */
-			Inc_value_with_rewind(&display_data.minute, 0, 59);
+			Inc_BCD_value_with_rewind(&display_data.minute, 0x00, 0x59);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
@@ -482,7 +689,7 @@ inline static void Minute_set_mode(void)
 		else if(MINUS_KEY_IS_PRESSED)
 		{
 			/* Decrement minute */
-			Dec_value_with_rewind(&display_data.minute, 0, 59);
+			Dec_BCD_value_with_rewind(&display_data.minute, 0x00, 0x59);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
@@ -564,7 +771,7 @@ inline static void Date_set_mode(void)
 		else if(PLUS_KEY_IS_PRESSED)
 		{
 			/* Increment minute */
-			Inc_value_with_rewind(&display_data.date, 1, 31);
+			Inc_BCD_value_with_rewind(&display_data.date, 0x01, 0x31);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
@@ -574,7 +781,7 @@ inline static void Date_set_mode(void)
 		else if(MINUS_KEY_IS_PRESSED)
 		{
 			/* Decrement minute */
-			Dec_value_with_rewind(&display_data.date, 1, 31);
+			Dec_BCD_value_with_rewind(&display_data.date, 0x01, 0x31);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
@@ -615,7 +822,7 @@ inline static void Month_set_mode(void)
 		else if(PLUS_KEY_IS_PRESSED)
 		{
 			/* Increment minute */
-			Inc_value_with_rewind(&display_data.month, 1, 12);
+			Inc_BCD_value_with_rewind(&display_data.month, 0x01, 0x12);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
@@ -625,7 +832,7 @@ inline static void Month_set_mode(void)
 		else if(MINUS_KEY_IS_PRESSED)
 		{
 			/* Decrement minute */
-			Dec_value_with_rewind(&display_data.month, 1, 12);
+			Dec_BCD_value_with_rewind(&display_data.month, 0x01, 0x12);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
@@ -663,9 +870,12 @@ inline static void Year_set_mode(void)
 			rtc_data.month	= display_data.month;
 			rtc_data.year	= display_data.year;
 
-			/* Store data in RTC */
+			/* Store data in RTC, written in the background, time reads wait for it */
 			Set_RTC_time(&rtc_data);
 
+			/* Writing seconds restarts RTC countdown chain */
+			RTC_sync_reset();
+
 			Go_to_normal_mode();
 
 			Lock_keyboard();
@@ -673,7 +883,7 @@ inline static void Year_set_mode(void)
 		else if(PLUS_KEY_IS_PRESSED)
 		{
 			/* Increment minute */
-			Inc_value_with_rewind(&display_data.year, 0, 99);
+			Inc_BCD_value_with_rewind(&display_data.year, 0x00, 0x99);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
@@ -683,7 +893,7 @@ inline static void Year_set_mode(void)
 		else if(MINUS_KEY_IS_PRESSED)
 		{
 			/* Decrement minute */
-			Dec_value_with_rewind(&display_data.year, 0, 99);
+			Dec_BCD_value_with_rewind(&display_data.year, 0x00, 0x99);
 
 			/* Clear inactivity counter */
 			Clear_clock_set_inactivity_counter();
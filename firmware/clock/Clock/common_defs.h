@@ -18,15 +18,78 @@
 #define LED_DATA_UPDATE_FREQUENCY		8	//Hz
 #define LED_CFG_UPDATE_FREQUENCY		8	//Hz
 
-#define RTC_READ_MODULO					(UPDATE_FREQUENCY / RTC_READ_FREQUENCY)
-#define RTC_READ_OFFSET					0
-#define LED_DATA_UPDATE_MODULO			(UPDATE_FREQUENCY / LED_DATA_UPDATE_FREQUENCY)
-#define LED_DATA_UPDATE_OFFSET			1
-#define LED_CFG_UPDATE_MODULO			(UPDATE_FREQUENCY / LED_CFG_UPDATE_FREQUENCY)
-#define LED_CFG_UPDATE_OFFSET			2
-
-#define EXT_TEMP_CONV_TRIGGER_CNT		3
-#define EXT_TEMP_DATA_READ_CNT			31
+/* Periodic tasks, period and phase in ticks of UPDATE_FREQUENCY, deadline from start of the tick */
+#define RTC_READ_PERIOD					(UPDATE_FREQUENCY / RTC_READ_FREQUENCY)
+#define LED_DATA_UPDATE_PERIOD			(UPDATE_FREQUENCY / LED_DATA_UPDATE_FREQUENCY)
+#define LED_DATA_UPDATE_PHASE			1
+#define LED_DATA_UPDATE_DEADLINE		20000	//us
+#define LED_CFG_UPDATE_PERIOD			(UPDATE_FREQUENCY / LED_CFG_UPDATE_FREQUENCY)
+#define LED_CFG_UPDATE_PHASE			2
+#define LED_CFG_UPDATE_DEADLINE			20000	//us
+#define EXT_TEMP_PERIOD					UPDATE_FREQUENCY
+#define EXT_TEMP_CONV_TRIGGER_PHASE		3
+#define EXT_TEMP_DEADLINE				20000	//us
+#define RTC_TEMP_PERIOD					(RTC_TEMP_CONV_PERIOD * UPDATE_FREQUENCY)
+#define RTC_TEMP_CONV_TRIGGER_PHASE		5
+#define RTC_TEMP_DATA_READ_PHASE		13		//conversion takes up to 200ms
+#define RTC_TEMP_DEADLINE				20000	//us
+#define COUNTERS_UPDATE_PERIOD			1
+#define COUNTERS_UPDATE_PHASE			0
+#define COUNTERS_UPDATE_DEADLINE		31250	//us, whole tick
+
+/* RTC time is read, temperature read and time set in the background, by I2C interrupts */
+#define RTC_READ_ASYNC					TRUE
+
+/* Dallas CRC-8 by 256 byte table, or by two 16 byte tables to save flash */
+#define ONEWIRE_CRC8_FULL_TABLE			FALSE
+
+/* DS18B20 sensors found by ROM search at startup, first one is displayed */
+#define EXT_TEMP_MAX_SENSORS			4
+
+/* Overdrive for DS28EA00 sensors that answer at overdrive speed, strong pull-up during conversion of parasite powered sensors */
+/* Overdrive needs short bus with low capacitance, enable only if wiring allows it */
+#define EXT_TEMP_OVERDRIVE_ENABLED		FALSE
+#define EXT_TEMP_STRONG_PULLUP_ENABLED	TRUE
+
+/* DS18B20 resolution in settings, conversion takes 94ms at 9-bit up to 750ms at 12-bit */
+#define EXT_TEMP_MIN_RESOLUTION			9		//bit
+#define EXT_TEMP_MAX_RESOLUTION			12		//bit
+#define EXT_TEMP_DEFAULT_RESOLUTION		12		//bit
+#define EXT_TEMP_READY_POLL_PERIOD		5000	//us, between read slots while converting
+
+/* 1-Wire sequences advance one DS2482 transfer per main loop pass, not closer to RTC read than worst transfer */
+#define EXT_TEMP_STEP_BUDGET			300		//us, DS2482 transfer at standard mode
+
+/* DS3231 converts temperature every 64s, forced conversion keeps cached value at most one period old */
+#define RTC_TEMP_CONV_PERIOD			64		//s
+#define RTC_TEMP_FORCE_CONV				TRUE
+
+/* RTC reads are phase locked to seconds rollover, out of the tick table */
+#define RTC_SYNC_ACQUIRE_MARGIN			10000	//us, covers 1% HSI tolerance
+#define RTC_SYNC_WINDOW_MARGIN			500		//us
+#define RTC_SYNC_TRAIN_WINDOW			25000	//us
+#define RTC_SYNC_LOCK_WINDOW			3000	//us
+#define RTC_SYNC_MAX_BASELINE			120		//s, longest RTC second measurement, restarted to follow HSI drift
+
+/* Without square wave, rollovers are predicted from TIM14 between resyncs */
+#define RTC_INTERP_ENABLED				TRUE
+#define RTC_INTERP_RESYNC_PERIOD		60		//s
+#define RTC_INTERP_LOCKED_SECONDS		8		//s, of lock before RTC second is trusted
+#define RTC_INTERP_DRIFT_MARGIN			50		//us, per predicted second
+
+/* DS3231 1Hz square wave on UNUSED_1 pin, time is advanced on each edge */
+/* Needs DS3231 INT/SQW (pin 3) wired to PA4 (UNUSED_1), open drain, pulled up by PA4 internal pull-up */
+/* Boards without that wire keep polling, enabled there the clock falls back to polling after RTC_SQW_TIMEOUT */
+#define RTC_SQW_ENABLED					FALSE
+#define RTC_SQW_RESYNC_PERIOD			60		//s
+#define RTC_SQW_READ_DELAY				100000	//us, after the edge
+#define RTC_SQW_TIMEOUT					2		//s, then fall back to polling
+
+#define LED_DATA_FULL_REFRESH_PERIOD	10	//s
+#define LED_DATA_FULL_REFRESH_CNTR_MAX	(LED_DATA_FULL_REFRESH_PERIOD * LED_DATA_UPDATE_FREQUENCY)
+
+#define LED_CFG_FULL_REFRESH_PERIOD		5	//s
+#define LED_CFG_FULL_REFRESH_CNTR_MAX	(LED_CFG_FULL_REFRESH_PERIOD * LED_CFG_UPDATE_FREQUENCY)
 
 #define STORE_SETTINGS_DELAY			2	//s
 #define STORE_SETTINGS_CNTR_MAX			(STORE_SETTINGS_DELAY * UPDATE_FREQUENCY)
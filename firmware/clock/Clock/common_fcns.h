@@ -13,9 +13,28 @@
 #define CLEAR_TICK		{volatile uint32_t tmp = SysTick->CTRL; (void)tmp;}				/* Clear the COUNTFLAG */
 #define CHECK_TICK		((SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) != 0U)
 
-#define DEC2BCD(in)		(uint8_t)(((in / 10) << 4) | (in % 10))
+#define GET_CYCLES		(SysTick->VAL)													/* Down-counting, wraps every 1ms */
+#define CYCLES_SINCE(start)	Cycles_since(start)
+#define NS_TO_CYCLES(ns)	((((ns) * (SystemCoreClock / 1000000U)) + 999U) / 1000U)		/* Rounded up, divides at runtime, keep out of hot paths */
+
+/* Division-free, x / 10 == (x * 205) >> 11 holds for x <= 1028 */
+#define DIV10(in)		(((uint32_t)(in) * 205) >> 11)
+
+/* Fixed-point with frac_bits fractional bits to tenths, rounded half away from zero, division-free */
+#define FIXED_TO_TENTHS_ABS(in, frac_bits)	((((uint32_t)(in) * 10) + (1U << ((frac_bits) - 1))) >> (frac_bits))
+#define FIXED_TO_TENTHS(in, frac_bits)		(int16_t)(((in) < 0) ? -(int16_t)FIXED_TO_TENTHS_ABS(-(in), frac_bits) : (int16_t)FIXED_TO_TENTHS_ABS(in, frac_bits))
+
+#define DEC2BCD(in)		(uint8_t)((DIV10(in) << 4) | ((in) - (DIV10(in) * 10)))
 #define BCD2BIN(in)		(uint8_t)((((in & 0xF0) >> 4) * 10) + (in & 0x0F))
 
+/* Counter sampled once, reload between two reads would underflow */
+inline static uint32_t Cycles_since(uint32_t start)
+{
+	uint32_t now = SysTick->VAL;
+
+	return (start >= now) ? (start - now) : (start + SysTick->LOAD + 1 - now);
+}
+
 inline void Inc_value(volatile uint8_t *val, uint8_t max)
 {
 	if((*val) < max)
@@ -44,4 +63,24 @@ inline void Dec_value_with_rewind(volatile uint8_t *val, uint8_t min, uint8_t ma
 		(*val)--;
 }
 
+inline void Inc_BCD_value_with_rewind(volatile uint8_t *val, uint8_t min, uint8_t max)
+{
+	if(*val == max)
+		*val = min;
+	else if((*val & 0x0F) == 0x09)
+		*val += 0x07;	/* 0x09 -> 0x10 */
+	else
+		(*val)++;
+}
+
+inline void Dec_BCD_value_with_rewind(volatile uint8_t *val, uint8_t min, uint8_t max)
+{
+	if(*val == min)
+		*val = max;
+	else if((*val & 0x0F) == 0x00)
+		*val -= 0x07;	/* 0x10 -> 0x09 */
+	else
+		(*val)--;
+}
+
 #endif /* COMMON_FCNS_H_ */
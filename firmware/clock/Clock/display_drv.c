@@ -7,6 +7,12 @@
 
 #include "display_drv.h"
 
+#include "common_fcns.h"
+#include "seg_font.h"
+
+#include <assert.h>
+#include <stddef.h>
+
 #include "../Core/Inc/spi.h"
 
 /* Number of displays in the chain */
@@ -15,7 +21,14 @@
 /* Number of digits in each of the display */
 #define NUM_OF_DIGITS			8
 
+/* Position of the displays in the chain, in order of sending */
+#define TEMP_DISPLAY			0		/* Last in chain */
+#define DATE_DISPLAY			1
+#define HOUR_DISPLAY			2		/* First in chain */
+
 /* MAX7219 registers */
+#define NO_OP_REG_ADDR			0x00
+
 #define DIGIT0_REG_ADDR			0x01
 #define DIGIT_REG_ADDR_STEP		0x01
 #define DIGIT1_REG_ADDR			0x02
@@ -32,58 +45,144 @@
 #define SHUTDOWN_REG_ADDR		0x0C
 #define DISPLAY_TEST_REG_ADDR	0x0F
 
-/* Time display chars */
-#define TIME_COLON_ON			0x60
-#define TIME_COLON_OFF			0x00
+/* Time display chars, colon LEDs are wired as segments a and b */
+#define TIME_COLON_ON			MAP_TO_PABCDEFG(SEG_A | SEG_B)
+#define TIME_COLON_OFF			MAP_TO_PABCDEFG(GLYPH_BLANK)
 
-#define TIME_DP_ON				0x80
-#define TIME_DP_OFF				0x00
+#define TIME_DP_ON				MAP_TO_PABCDEFG(SEG_DP)
+#define TIME_DP_OFF				MAP_TO_PABCDEFG(GLYPH_BLANK)
 
-#define TIME_E_SIGN				0x4F
-#define TIME_r_SIGN				0x05
-#define TIME_o_SIGN				0x1D
+#define TIME_E_SIGN				MAP_TO_PABCDEFG(GLYPH_E)
+#define TIME_r_SIGN				MAP_TO_PABCDEFG(GLYPH_r)
+#define TIME_o_SIGN				MAP_TO_PABCDEFG(GLYPH_o)
 
 /* Date display chars */
-#define DATE_DP_ON				0x20
-#define DATE_DP_OFF				0x00
-
-#define DATE_DEG_SIGN			0x0F
-#define DATE_C_SIGN				0x99
-#define DATE__I_SIGN			0x42
-#define DATE_I_SIGN				0x18
-#define DATE_n_SIGN				0x54
-#define DATE_t_SIGN				0x9C
-#define DATE_E_SIGN				0x9D
-#define DATE_MINUS_SIGN			0x04
+#define DATE_DP_ON				MAP_TO_DCPEFGBA(SEG_DP)
+#define DATE_DP_OFF				MAP_TO_DCPEFGBA(GLYPH_BLANK)
+
+#define DATE_DEG_SIGN			MAP_TO_DCPEFGBA(GLYPH_DEGREE)
+#define DATE_C_SIGN				MAP_TO_DCPEFGBA(GLYPH_C)
+#define DATE__I_SIGN			MAP_TO_DCPEFGBA(GLYPH_I_RIGHT)
+#define DATE_I_SIGN				MAP_TO_DCPEFGBA(GLYPH_I)
+#define DATE_n_SIGN				MAP_TO_DCPEFGBA(GLYPH_n)
+#define DATE_t_SIGN				MAP_TO_DCPEFGBA(GLYPH_t)
+#define DATE_E_SIGN				MAP_TO_DCPEFGBA(GLYPH_E)
+#define DATE_MINUS_SIGN			MAP_TO_DCPEFGBA(GLYPH_MINUS)
+
+/* Temperature limits in tenths of *C, for sign and up to two digits or 1 and two digits */
+#define TEMP_HUNDRED			1000
+#define TEMP_MAX_TWO_DIGITS		999
+#define TEMP_MAX_THREE_DIGITS	1999
 
 /* Common for all */
-#define BLANK_DISP				0x00
+#define BLANK_DISP				GLYPH_BLANK
 
 /* pabcdefg configuration */
-const uint8_t seg_table_hour[10]				= {0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7F, 0x7B};
+const uint8_t seg_table_hour[NUM_OF_FONT_CHARS]				= FONT_TABLE(MAP_TO_PABCDEFG);
 /* dcpefgba configuration */
-const uint8_t seg_table_date_temperature[10]	= {0xDB, 0x42, 0x97, 0xC7, 0x4E, 0xCD, 0xDD, 0x43, 0xDF, 0xCF};
+const uint8_t seg_table_date_temperature[NUM_OF_FONT_CHARS]	= FONT_TABLE(MAP_TO_DCPEFGBA);
+
+/* Generated font must match the wiring of the boards */
+static_assert((MAP_TO_PABCDEFG(GLYPH_0) == 0x7E) && (MAP_TO_PABCDEFG(GLYPH_1) == 0x30) && (MAP_TO_PABCDEFG(GLYPH_2) == 0x6D) &&
+			  (MAP_TO_PABCDEFG(GLYPH_3) == 0x79) && (MAP_TO_PABCDEFG(GLYPH_4) == 0x33) && (MAP_TO_PABCDEFG(GLYPH_5) == 0x5B) &&
+			  (MAP_TO_PABCDEFG(GLYPH_6) == 0x5F) && (MAP_TO_PABCDEFG(GLYPH_7) == 0x70) && (MAP_TO_PABCDEFG(GLYPH_8) == 0x7F) &&
+			  (MAP_TO_PABCDEFG(GLYPH_9) == 0x7B), "Wrong pabcdefg digits");
+static_assert((MAP_TO_DCPEFGBA(GLYPH_0) == 0xDB) && (MAP_TO_DCPEFGBA(GLYPH_1) == 0x42) && (MAP_TO_DCPEFGBA(GLYPH_2) == 0x97) &&
+			  (MAP_TO_DCPEFGBA(GLYPH_3) == 0xC7) && (MAP_TO_DCPEFGBA(GLYPH_4) == 0x4E) && (MAP_TO_DCPEFGBA(GLYPH_5) == 0xCD) &&
+			  (MAP_TO_DCPEFGBA(GLYPH_6) == 0xDD) && (MAP_TO_DCPEFGBA(GLYPH_7) == 0x43) && (MAP_TO_DCPEFGBA(GLYPH_8) == 0xDF) &&
+			  (MAP_TO_DCPEFGBA(GLYPH_9) == 0xCF), "Wrong dcpefgba digits");
+static_assert((TIME_COLON_ON == 0x60) && (TIME_DP_ON == 0x80) &&
+			  (TIME_E_SIGN == 0x4F) && (TIME_r_SIGN == 0x05) && (TIME_o_SIGN == 0x1D), "Wrong pabcdefg signs");
+static_assert((DATE_DP_ON == 0x20) && (DATE_DEG_SIGN == 0x0F) && (DATE_C_SIGN == 0x99) && (DATE__I_SIGN == 0x42) &&
+			  (DATE_I_SIGN == 0x18) && (DATE_n_SIGN == 0x54) && (DATE_t_SIGN == 0x9C) && (DATE_E_SIGN == 0x9D) &&
+			  (DATE_MINUS_SIGN == 0x04), "Wrong dcpefgba signs");
+
+/* MAX7219 CS timing limits */
+#define CS_SETUP_TIME_NS		25		/* tCSS, CS fall to SCLK rise */
+#define CS_HOLD_TIME_NS			0		/* tCSH, SCLK rise to CS rise */
+#define CS_PULSE_HIGH_TIME_NS	50		/* tCSW, CS high between packets */
+
+/* CS is raised right after RX DMA completes, which covers only zero hold time */
+static_assert(CS_HOLD_TIME_NS == 0, "CS hold time has to be enforced");
+
+/* SPI DMA channels, fixed for SPI1, shared with I2C1 */
+#define SPI_RX_DMA_CHANNEL		LL_DMA_CHANNEL_2
+#define SPI_TX_DMA_CHANNEL		LL_DMA_CHANNEL_3
+
+/* Queue of packets, each latched separately into all displays */
+#define DISPLAY_PACKET_SIZE		(NUM_OF_DISPLAYS * 2)
+#define DISPLAY_QUEUE_SIZE		16		/* Has to be a power of 2 */
+#define DISPLAY_QUEUE_MASK		(DISPLAY_QUEUE_SIZE - 1)
+
+static uint8_t display_queue[DISPLAY_QUEUE_SIZE][DISPLAY_PACKET_SIZE];
+static volatile uint8_t display_queue_head = 0;
+static volatile uint8_t display_queue_tail = 0;
+static volatile uint8_t display_transfer_active = FALSE;
+
+/* DMA channels lent to I2C, packets wait in the queue */
+static volatile uint8_t display_dma_claimed = FALSE;
+
+/* Received bytes are dropped here */
+static volatile uint8_t spi_rx_dummy;
+
+/* CS timing in SysTick cycles, no divisions in packet path */
+static uint32_t cs_setup_cycles;
+static uint32_t cs_pulse_high_cycles;
+
+/* Copy of digit registers content of each MAX7219 */
+static uint8_t display_shadow[NUM_OF_DISPLAYS][NUM_OF_DIGITS];
+
+/* Counter of data updates, to rewrite all rows from time to time */
+static uint32_t display_full_refresh_counter = 0;
+
+/* Intensity currently written to MAX7219s */
+static uint8_t display_intensity_shadow;
+
+/* Counter of config updates, to rewrite all config registers from time to time */
+static uint32_t display_cfg_refresh_counter = 0;
+
+#ifdef DEBUG
+/* Number of bytes sent over SPI, read out with debugger */
+volatile uint32_t display_spi_bytes_sent = 0;
+volatile uint32_t display_spi_bytes_last_update = 0;
+
+/* Number of CPU cycles spent on conversion to segments */
+volatile uint32_t display_conversion_cycles = 0;
+#endif
 
 inline static void Convert_display_data_to_segments(volatile struct display_data_struct *data, uint8_t *hour_buffer, uint8_t *date_buffer, uint8_t *temp_buffer);
-inline static void Convert_temperature_data_to_segments(int8_t temperature, uint8_t *temp_buffer);
+inline static void Convert_temperature_data_to_segments(int16_t temperature, uint8_t *temp_buffer);
 inline static void Override_display_data_for_special_mode(volatile struct display_data_struct *data, uint8_t *hour_buffer, uint8_t *date_buffer, uint8_t *temp_buffer);
 inline static void Blank_segments_buffer(uint8_t *digits_data);
 inline static void Blank_DP_in_segments_buffer(uint8_t *digits_data, uint8_t dp);
 
-inline static void Uint8_to_two_7segments_with_blanking(uint8_t val, uint8_t *first_digit, uint8_t *second_digit, const uint8_t *seg_table);
-inline static void Uint8_to_two_7segments_without_blanking(uint8_t val, uint8_t *first_digit, uint8_t *second_digit, const uint8_t *seg_table);
+inline static void BCD_to_two_7segments_with_blanking(uint8_t bcd, uint8_t *first_digit, uint8_t *second_digit, const uint8_t *seg_table);
+inline static void BCD_to_two_7segments_without_blanking(uint8_t bcd, uint8_t *first_digit, uint8_t *second_digit, const uint8_t *seg_table);
+inline static uint8_t Uint8_to_BCD(uint8_t val);
+
+inline static void Send_changed_rows(uint8_t digits_data[NUM_OF_DISPLAYS][NUM_OF_DIGITS]);
 
 inline static void Clear(void);
 inline static void Set_config(uint8_t intensity);
-inline static void Write_CMD_to_all_displays(uint8_t reg, uint8_t val);
+inline static uint8_t Write_CMD_to_all_displays(uint8_t reg, uint8_t val);
 
-inline static void SPI_Flush(void);
-inline static void SPI_Send(uint8_t data);
-inline static void LCD_Delay(void);
+inline static void Init_SPI_DMA(void);
+inline static void Config_SPI_DMA_channels(void);
+inline static uint8_t *Get_free_packet(void);
+inline static void Queue_packet(void);
+static void Start_packet_transfer(void);
+inline static void CS_Delay(uint32_t cycles);
 
 
 void Init_display(uint8_t intensity)
 {
+	/* Convert CS timing for current core clock */
+	cs_setup_cycles = NS_TO_CYCLES(CS_SETUP_TIME_NS);
+	cs_pulse_high_cycles = NS_TO_CYCLES(CS_PULSE_HIGH_TIME_NS);
+
+	/* Prepare DMA for SPI transfers */
+	Init_SPI_DMA();
+
 	/* Enable SPI */
 	LL_SPI_Enable(SPI1);
 
@@ -96,44 +195,76 @@ void Init_display(uint8_t intensity)
 
 void Update_display_config(volatile struct display_data_struct *data)
 {
-	/* Update displays configuration */
-	Set_config(data->intensity);
+	uint8_t intensity = data->intensity & 0x0F;
+
+	/* Rewrite whole configuration from time to time, in case any display lost it */
+	display_cfg_refresh_counter++;
+	if(display_cfg_refresh_counter >= LED_CFG_FULL_REFRESH_CNTR_MAX)
+	{
+		display_cfg_refresh_counter = 0;
+
+		Set_config(intensity);
+	}
+	/* Otherwise send intensity only if changed */
+	else if(intensity != display_intensity_shadow)
+	{
+		/* Shadow is left as it was if queue is full, so it is sent next time */
+		if(Write_CMD_to_all_displays(INTENSITY_REG_ADDR, intensity) == TRUE)
+		{
+			display_intensity_shadow = intensity;
+		}
+	}
 }
 
 void Update_display_data(volatile struct display_data_struct *data)
 {
-	uint8_t hour_digits_data[NUM_OF_DIGITS];
-	uint8_t date_digits_data[NUM_OF_DIGITS];
-	uint8_t temp_digits_data[NUM_OF_DIGITS];
+	uint8_t digits_data[NUM_OF_DISPLAYS][NUM_OF_DIGITS];
+
+#ifdef DEBUG
+	uint32_t bytes_sent_before_update = display_spi_bytes_sent;
+	uint32_t conversion_start = GET_CYCLES;
+#endif
 
 	/* Convert constant fields */
-	Convert_display_data_to_segments(data, hour_digits_data, date_digits_data, temp_digits_data);
+	Convert_display_data_to_segments(data, digits_data[HOUR_DISPLAY], digits_data[DATE_DISPLAY], digits_data[TEMP_DISPLAY]);
 
 	/* Update display for special mode */
-	Override_display_data_for_special_mode(data, hour_digits_data, date_digits_data, temp_digits_data);
+	Override_display_data_for_special_mode(data, digits_data[HOUR_DISPLAY], digits_data[DATE_DISPLAY], digits_data[TEMP_DISPLAY]);
 
-	/* Update display */
-	for(uint8_t i = 0; i < NUM_OF_DIGITS; i++)
+#ifdef DEBUG
+	display_conversion_cycles = CYCLES_SINCE(conversion_start);
+#endif
+
+	/* Rewrite all rows from time to time, in case any display lost its data */
+	display_full_refresh_counter++;
+	if(display_full_refresh_counter >= LED_DATA_FULL_REFRESH_CNTR_MAX)
 	{
-		LL_GPIO_ResetOutputPin(LED_CS_GPIO_Port, LED_CS_Pin);
-		LCD_Delay();
+		display_full_refresh_counter = 0;
+
+		/* Make every row of every display differ from the shadow */
+		for(uint8_t d = 0; d < NUM_OF_DISPLAYS; d++)
+		{
+			for(uint8_t i = 0; i < NUM_OF_DIGITS; i++)
+			{
+				display_shadow[d][i] = ~digits_data[d][i];
+			}
+		}
+	}
 
-		SPI_Send(i+1); SPI_Send(temp_digits_data[i]);		// Temperature display, last in chain
-		SPI_Send(i+1); SPI_Send(date_digits_data[i]);		// Date display
-		SPI_Send(i+1); SPI_Send(hour_digits_data[i]);		// Hour display, first in chain
+	/* Update display */
+	Send_changed_rows(digits_data);
 
-		LCD_Delay();
-		LL_GPIO_SetOutputPin(LED_CS_GPIO_Port, LED_CS_Pin);
-		LCD_Delay();
-	}
+#ifdef DEBUG
+	display_spi_bytes_last_update = display_spi_bytes_sent - bytes_sent_before_update;
+#endif
 }
 
 inline static void Convert_display_data_to_segments(volatile struct display_data_struct *data, uint8_t *hour_buffer, uint8_t *date_buffer, uint8_t *temp_buffer)
 {
 	/* Convert time */
-	Uint8_to_two_7segments_with_blanking(data->hour,		&hour_buffer[0], &hour_buffer[1], seg_table_hour);
-	Uint8_to_two_7segments_without_blanking(data->minute,	&hour_buffer[3], &hour_buffer[4], seg_table_hour);
-	Uint8_to_two_7segments_without_blanking(data->second,	&hour_buffer[6], &hour_buffer[7], seg_table_hour);
+	BCD_to_two_7segments_with_blanking(data->hour,		&hour_buffer[0], &hour_buffer[1], seg_table_hour);
+	BCD_to_two_7segments_without_blanking(data->minute,	&hour_buffer[3], &hour_buffer[4], seg_table_hour);
+	BCD_to_two_7segments_without_blanking(data->second,	&hour_buffer[6], &hour_buffer[7], seg_table_hour);
 
 	/* Manage colon */
 	if(data->hour_colon == TRUE)
@@ -146,14 +277,14 @@ inline static void Convert_display_data_to_segments(volatile struct display_data
 	}
 
 	/* Convert date */
-	Uint8_to_two_7segments_with_blanking(data->date,		&date_buffer[0], &date_buffer[1], seg_table_date_temperature);
+	BCD_to_two_7segments_with_blanking(data->date,		&date_buffer[0], &date_buffer[1], seg_table_date_temperature);
 	date_buffer[1] |= DATE_DP_ON;	/* Set decimal point at the date */
 
-	Uint8_to_two_7segments_without_blanking(data->month,	&date_buffer[2], &date_buffer[3], seg_table_date_temperature);
+	BCD_to_two_7segments_without_blanking(data->month,	&date_buffer[2], &date_buffer[3], seg_table_date_temperature);
 	date_buffer[3] |= DATE_DP_ON;	/* Set decimal point at the month */
 
-	date_buffer[4] = seg_table_date_temperature[2]; date_buffer[5] = seg_table_date_temperature[0]; /* Set year prefix to 20 */
-	Uint8_to_two_7segments_without_blanking(data->year,		&date_buffer[6], &date_buffer[7], seg_table_date_temperature);
+	date_buffer[4] = seg_table_date_temperature[CHAR_2]; date_buffer[5] = seg_table_date_temperature[CHAR_0]; /* Set year prefix to 20 */
+	BCD_to_two_7segments_without_blanking(data->year,		&date_buffer[6], &date_buffer[7], seg_table_date_temperature);
 
 	/* Convert temperature */
 	if(data->special_mode == DISPLAY_EXT_TEMP)
@@ -174,27 +305,58 @@ inline static void Convert_display_data_to_segments(volatile struct display_data
 	}
 }
 
-inline static void Convert_temperature_data_to_segments(int8_t temperature, uint8_t *temp_buffer)
+inline static void Convert_temperature_data_to_segments(int16_t temperature, uint8_t *temp_buffer)
 {
-	uint8_t temp;
+	uint16_t temp;
+	uint8_t units;
 
-	/* Manage negative value */
+	/* Manage negative value, no room for hundreds next to the sign */
 	if(temperature < 0)
 	{
 		temp = -temperature;
 		temp_buffer[1] = DATE_MINUS_SIGN;
+
+		if(temp > TEMP_MAX_TWO_DIGITS)
+		{
+			temp = TEMP_MAX_TWO_DIGITS;
+		}
 	}
 	else
 	{
 		temp = temperature;
 		temp_buffer[1] = BLANK_DISP;
+
+		if(temp > TEMP_MAX_THREE_DIGITS)
+		{
+			temp = TEMP_MAX_THREE_DIGITS;
+		}
+	}
+
+	/* Show hundreds in place of the sign */
+	if(temp >= TEMP_HUNDRED)
+	{
+		temp -= TEMP_HUNDRED;
+		temp_buffer[1] = seg_table_date_temperature[CHAR_1];
+	}
+
+	/* Convert without division, temp is below 1000 here */
+	units = DIV10(temp);
+
+	/* Show temperature, with decimal point before tenths */
+	if(temperature >= TEMP_HUNDRED)
+	{
+		BCD_to_two_7segments_without_blanking(DEC2BCD(units),	&temp_buffer[2], &temp_buffer[3], seg_table_date_temperature);
+	}
+	else
+	{
+		BCD_to_two_7segments_with_blanking(DEC2BCD(units),	&temp_buffer[2], &temp_buffer[3], seg_table_date_temperature);
 	}
 
-	/* Show temperature */
-	Uint8_to_two_7segments_with_blanking(temp,		&temp_buffer[2], &temp_buffer[3], seg_table_date_temperature);
+	temp_buffer[3] |= DATE_DP_ON;
+	temp_buffer[4] = seg_table_date_temperature[temp - (units * 10)];
 
-	/* Add *C sign */
-	temp_buffer[4] = DATE_DEG_SIGN; temp_buffer[5] = DATE_C_SIGN;
+	/* Add * sign, C does not fit with tenths */
+	temp_buffer[5] = DATE_DEG_SIGN;
 
 	/* Blank not mounted displays */
 	temp_buffer[6] = BLANK_DISP; temp_buffer[7] = BLANK_DISP;
@@ -307,7 +469,7 @@ inline static void Override_display_data_for_special_mode(volatile struct displa
 		/* Show intensity */
 		date_buffer[0] = DATE__I_SIGN; date_buffer[1] = DATE_n_SIGN; date_buffer[2] = DATE_t_SIGN;
 		date_buffer[4] = DATE_MINUS_SIGN; date_buffer[7] = DATE_MINUS_SIGN;
-		Uint8_to_two_7segments_with_blanking(data->intensity + 1, &date_buffer[5], &date_buffer[6], seg_table_date_temperature);
+		BCD_to_two_7segments_with_blanking(Uint8_to_BCD(data->intensity + 1), &date_buffer[5], &date_buffer[6], seg_table_date_temperature);
 
 		break;
 
@@ -341,30 +503,44 @@ inline static void Blank_DP_in_segments_buffer(uint8_t *digits_data, uint8_t dp)
 	}
 }
 
-inline static void Uint8_to_two_7segments_with_blanking(uint8_t val, uint8_t *first_digit, uint8_t *second_digit, const uint8_t * seg_table)
+inline static void BCD_to_two_7segments_with_blanking(uint8_t bcd, uint8_t *first_digit, uint8_t *second_digit, const uint8_t * seg_table)
 {
-	/* Limit value to 99 */
-	if(val > 99)
-	{
-		val = 99;
-	}
-
 	/* Are two digits for display ? */
-	if(val >= 10)
+	if(bcd >= 0x10)
 	{
 		/* Yes */
-		*first_digit	= seg_table[val / 10];
-		*second_digit	= seg_table[val % 10];
+		BCD_to_two_7segments_without_blanking(bcd, first_digit, second_digit, seg_table);
 	}
 	else
 	{
 		/* No, blank first display */
 		*first_digit	= BLANK_DISP;
-		*second_digit	= seg_table[val];
+		*second_digit	= seg_table[(bcd > 0x09) ? 0x09 : bcd];
 	}
 }
 
-inline static void Uint8_to_two_7segments_without_blanking(uint8_t val, uint8_t *first_digit, uint8_t *second_digit, const uint8_t * seg_table)
+inline static void BCD_to_two_7segments_without_blanking(uint8_t bcd, uint8_t *first_digit, uint8_t *second_digit, const uint8_t * seg_table)
+{
+	uint8_t high_nibble = bcd >> 4;
+	uint8_t low_nibble = bcd & 0x0F;
+
+	/* Limit each digit to 9 */
+	if(high_nibble > 9)
+	{
+		high_nibble = 9;
+	}
+
+	if(low_nibble > 9)
+	{
+		low_nibble = 9;
+	}
+
+	/* Display always two digits */
+	*first_digit	= seg_table[high_nibble];
+	*second_digit	= seg_table[low_nibble];
+}
+
+inline static uint8_t Uint8_to_BCD(uint8_t val)
 {
 	/* Limit value to 99 */
 	if(val > 99)
@@ -372,75 +548,315 @@ inline static void Uint8_to_two_7segments_without_blanking(uint8_t val, uint8_t
 		val = 99;
 	}
 
-	/* Display always two digits */
-	*first_digit	= seg_table[val / 10];
-	*second_digit	= seg_table[val % 10];
+	/* Convert without division */
+	return DEC2BCD(val);
+}
+
+inline static void Send_changed_rows(uint8_t digits_data[NUM_OF_DISPLAYS][NUM_OF_DIGITS])
+{
+	uint8_t changed_rows[NUM_OF_DISPLAYS][NUM_OF_DIGITS];
+	uint8_t num_of_changed_rows[NUM_OF_DISPLAYS];
+	uint8_t num_of_packets = 0;
+
+	/* Compare each display with its shadow */
+	for(uint8_t d = 0; d < NUM_OF_DISPLAYS; d++)
+	{
+		num_of_changed_rows[d] = 0;
+
+		for(uint8_t i = 0; i < NUM_OF_DIGITS; i++)
+		{
+			if(digits_data[d][i] != display_shadow[d][i])
+			{
+				changed_rows[d][num_of_changed_rows[d]] = i;
+				num_of_changed_rows[d]++;
+			}
+		}
+
+		/* Display with the most changes determines number of packets */
+		if(num_of_changed_rows[d] > num_of_packets)
+		{
+			num_of_packets = num_of_changed_rows[d];
+		}
+	}
+
+	for(uint8_t p = 0; p < num_of_packets; p++)
+	{
+		uint8_t *packet = Get_free_packet();
+
+		/* Queue is full, rows not sent stay different from the shadow until next update */
+		if(packet == NULL)
+		{
+			break;
+		}
+
+		/* Last display in chain goes first */
+		for(uint8_t d = 0; d < NUM_OF_DISPLAYS; d++)
+		{
+			if(p < num_of_changed_rows[d])
+			{
+				uint8_t row = changed_rows[d][p];
+
+				packet[2*d] = DIGIT0_REG_ADDR + row; packet[2*d + 1] = digits_data[d][row];
+
+				/* Update shadow */
+				display_shadow[d][row] = digits_data[d][row];
+			}
+			else
+			{
+				/* Nothing more for this display, shift no-op through it */
+				packet[2*d] = NO_OP_REG_ADDR; packet[2*d + 1] = 0x00;
+			}
+		}
+
+		Queue_packet();
+	}
 }
 
 inline static void Clear(void)
 {
 	for(uint8_t i = 0; i < NUM_OF_DIGITS; i++)
 	{
-		Write_CMD_to_all_displays(i+1,  BLANK_DISP);
+		/* Row not queued differs from any data, so it is sent with the next update */
+		uint8_t row = (Write_CMD_to_all_displays(i+1,  BLANK_DISP) == TRUE) ? BLANK_DISP : (uint8_t)~BLANK_DISP;
+
+		/* Update shadow */
+		for(uint8_t d = 0; d < NUM_OF_DISPLAYS; d++)
+		{
+			display_shadow[d][i] = row;
+		}
 	}
 }
 
 inline static void Set_config(uint8_t intensity)
 {
-	Write_CMD_to_all_displays(SHUTDOWN_REG_ADDR, 0x01);
+	uint8_t queued = TRUE;
+
+	queued &= Write_CMD_to_all_displays(SHUTDOWN_REG_ADDR, 0x01);
+
+	queued &= Write_CMD_to_all_displays(SCAN_LIMIT_REG_ADDR, 0x07);
 
-	Write_CMD_to_all_displays(SCAN_LIMIT_REG_ADDR, 0x07);
+	queued &= Write_CMD_to_all_displays(DISPLAY_TEST_REG_ADDR, 0x00);
+	queued &= Write_CMD_to_all_displays(DECODE_MODE_REG_ADDR, 0x00);
 
-	Write_CMD_to_all_displays(DISPLAY_TEST_REG_ADDR, 0x00);
-	Write_CMD_to_all_displays(DECODE_MODE_REG_ADDR, 0x00);
+	queued &= Write_CMD_to_all_displays(INTENSITY_REG_ADDR, (intensity & 0x0F));
 
-	Write_CMD_to_all_displays(INTENSITY_REG_ADDR, (intensity & 0x0F));
+	/* Update shadow */
+	display_intensity_shadow = intensity & 0x0F;
+
+	/* Queue was full, rewrite whole configuration with next update */
+	if(queued == FALSE)
+	{
+		display_cfg_refresh_counter = LED_CFG_FULL_REFRESH_CNTR_MAX;
+	}
 }
 
-inline static void Write_CMD_to_all_displays(uint8_t reg, uint8_t val)
+inline static uint8_t Write_CMD_to_all_displays(uint8_t reg, uint8_t val)
 {
-	LL_GPIO_ResetOutputPin(LED_CS_GPIO_Port, LED_CS_Pin);
-	LCD_Delay();
+	uint8_t *packet = Get_free_packet();
+
+	if(packet == NULL)
+	{
+		return FALSE;
+	}
 
 	for(uint8_t i = 0; i < NUM_OF_DISPLAYS; i++)
 	{
-		SPI_Send(reg); SPI_Send(val);
+		packet[2*i] = reg; packet[2*i + 1] = val;
 	}
 
-	LCD_Delay();
-	LL_GPIO_SetOutputPin(LED_CS_GPIO_Port, LED_CS_Pin);
-	LCD_Delay();
+	Queue_packet();
+
+	return TRUE;
 }
 
+inline static void Init_SPI_DMA(void)
+{
+	/* Enable DMA clock */
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+
+	Config_SPI_DMA_channels();
+
+	/* Enable SPI DMA requests, RX first */
+	LL_SPI_EnableDMAReq_RX(SPI1);
+	LL_SPI_EnableDMAReq_TX(SPI1);
+
+	/* Enable DMA interrupt, below TIM14 priority */
+	NVIC_SetPriority(DMA1_Channel2_3_IRQn, 1);
+	NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+}
+
+inline static void Config_SPI_DMA_channels(void)
+{
+	/* SPI1 RX, used only to detect the end of the transfer, */
+	/* because TX channel finishes before last byte leaves the shift register */
+	LL_DMA_ConfigTransfer(DMA1, SPI_RX_DMA_CHANNEL,
+			LL_DMA_DIRECTION_PERIPH_TO_MEMORY |
+			LL_DMA_PRIORITY_LOW |
+			LL_DMA_MODE_NORMAL |
+			LL_DMA_PERIPH_NOINCREMENT |
+			LL_DMA_MEMORY_NOINCREMENT |
+			LL_DMA_PDATAALIGN_BYTE |
+			LL_DMA_MDATAALIGN_BYTE);
+
+	LL_DMA_ConfigAddresses(DMA1, SPI_RX_DMA_CHANNEL,
+			LL_SPI_DMA_GetRegAddr(SPI1), (uint32_t)&spi_rx_dummy,
+			LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+
+	LL_DMA_EnableIT_TC(DMA1, SPI_RX_DMA_CHANNEL);
+
+	/* SPI1 TX */
+	LL_DMA_ConfigTransfer(DMA1, SPI_TX_DMA_CHANNEL,
+			LL_DMA_DIRECTION_MEMORY_TO_PERIPH |
+			LL_DMA_PRIORITY_LOW |
+			LL_DMA_MODE_NORMAL |
+			LL_DMA_PERIPH_NOINCREMENT |
+			LL_DMA_MEMORY_INCREMENT |
+			LL_DMA_PDATAALIGN_BYTE |
+			LL_DMA_MDATAALIGN_BYTE);
+
+	LL_DMA_SetPeriphAddress(DMA1, SPI_TX_DMA_CHANNEL, LL_SPI_DMA_GetRegAddr(SPI1));
+}
 
-inline static void SPI_Flush(void)
+inline static uint8_t *Get_free_packet(void)
 {
-	/* Flush buffer */
-	while(LL_SPI_IsActiveFlag_RXNE(SPI1))
+	/* Never wait in main loop, caller keeps data to be sent later */
+	if(((display_queue_head + 1) & DISPLAY_QUEUE_MASK) == display_queue_tail)
 	{
-		LL_SPI_ReceiveData8(SPI1);
+		return NULL;
 	}
+
+	return display_queue[display_queue_head];
 }
 
-inline static void SPI_Send(uint8_t data)
+inline static void Queue_packet(void)
 {
-	/* Wait for not empty */
-	while(!LL_SPI_IsActiveFlag_TXE(SPI1));
+	/* Publish packet */
+	display_queue_head = (display_queue_head + 1) & DISPLAY_QUEUE_MASK;
+
+#ifdef DEBUG
+	display_spi_bytes_sent += DISPLAY_PACKET_SIZE;
+#endif
 
-	/* Send byte */
-	LL_SPI_TransmitData8(SPI1, data);
+	/* Start transfer, if it is not already running, interrupts may be already disabled by caller */
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if((display_transfer_active == FALSE) && (display_dma_claimed == FALSE))
+	{
+		display_transfer_active = TRUE;
 
-	/* Wait while busy */
-	while(LL_SPI_IsActiveFlag_BSY(SPI1));
+		Start_packet_transfer();
+	}
 
-	/* Flush SPI */
-	SPI_Flush();
+	__set_PRIMASK(primask);
 }
 
-inline static void LCD_Delay(void)
+static void Start_packet_transfer(void)
 {
-	for(uint8_t i = 0; i < 150; i++)
+	LL_GPIO_ResetOutputPin(LED_CS_GPIO_Port, LED_CS_Pin);
+	CS_Delay(cs_setup_cycles);
+
+	LL_DMA_DisableChannel(DMA1, SPI_RX_DMA_CHANNEL);
+	LL_DMA_DisableChannel(DMA1, SPI_TX_DMA_CHANNEL);
+
+	LL_DMA_SetMemoryAddress(DMA1, SPI_TX_DMA_CHANNEL, (uint32_t)display_queue[display_queue_tail]);
+
+	LL_DMA_SetDataLength(DMA1, SPI_RX_DMA_CHANNEL, DISPLAY_PACKET_SIZE);
+	LL_DMA_SetDataLength(DMA1, SPI_TX_DMA_CHANNEL, DISPLAY_PACKET_SIZE);
+
+	/* RX first, TX starts the transfer */
+	LL_DMA_EnableChannel(DMA1, SPI_RX_DMA_CHANNEL);
+	LL_DMA_EnableChannel(DMA1, SPI_TX_DMA_CHANNEL);
+}
+
+void Display_DMA_IRQ_handler(void)
+{
+	/* Check if last byte was shifted out */
+	if(LL_DMA_IsActiveFlag_TC2(DMA1))
 	{
-		asm volatile("nop");
+		LL_DMA_ClearFlag_GI2(DMA1);
+		LL_DMA_ClearFlag_GI3(DMA1);
+
+		/* Latch data, tCSH is met as last bit was already received */
+		LL_GPIO_SetOutputPin(LED_CS_GPIO_Port, LED_CS_Pin);
+		CS_Delay(cs_pulse_high_cycles);
+
+		/* Release packet */
+		display_queue_tail = (display_queue_tail + 1) & DISPLAY_QUEUE_MASK;
+
+		/* Send next one, if any */
+		if(display_queue_tail != display_queue_head)
+		{
+			Start_packet_transfer();
+		}
+		else
+		{
+			display_transfer_active = FALSE;
+		}
 	}
 }
+
+uint8_t Is_display_busy(void)
+{
+	return display_transfer_active;
+}
+
+uint8_t Claim_display_DMA(void)
+{
+	uint8_t claimed = FALSE;
+
+	/* Called with interrupts disabled or from interrupt */
+
+	/* Only between display transfers */
+	if((display_transfer_active == FALSE) && (display_dma_claimed == FALSE))
+	{
+		display_dma_claimed = TRUE;
+
+		/* Stop SPI requests, idle TX would trigger the channel right away */
+		LL_SPI_DisableDMAReq_RX(SPI1);
+		LL_SPI_DisableDMAReq_TX(SPI1);
+
+		LL_DMA_DisableIT_TC(DMA1, SPI_RX_DMA_CHANNEL);
+
+		LL_DMA_DisableChannel(DMA1, SPI_RX_DMA_CHANNEL);
+		LL_DMA_DisableChannel(DMA1, SPI_TX_DMA_CHANNEL);
+
+		claimed = TRUE;
+	}
+
+	return claimed;
+}
+
+void Release_display_DMA(void)
+{
+	/* Called with interrupts disabled or from interrupt */
+	LL_DMA_DisableChannel(DMA1, SPI_RX_DMA_CHANNEL);
+	LL_DMA_DisableChannel(DMA1, SPI_TX_DMA_CHANNEL);
+
+	LL_DMA_ClearFlag_GI2(DMA1);
+	LL_DMA_ClearFlag_GI3(DMA1);
+
+	/* Restore SPI configuration */
+	Config_SPI_DMA_channels();
+
+	LL_SPI_EnableDMAReq_RX(SPI1);
+	LL_SPI_EnableDMAReq_TX(SPI1);
+
+	display_dma_claimed = FALSE;
+
+	/* Send packets queued in the meantime */
+	if((display_transfer_active == FALSE) && (display_queue_tail != display_queue_head))
+	{
+		display_transfer_active = TRUE;
+
+		Start_packet_transfer();
+	}
+}
+
+inline static void CS_Delay(uint32_t cycles)
+{
+	uint32_t start = GET_CYCLES;
+
+	/* Count SysTick cycles, independent of optimization level */
+	while(CYCLES_SINCE(start) < cycles);
+}
@@ -13,6 +13,7 @@
 #define MIN_INTENSITY			0x0
 #define MAX_INTENSITY			0xF
 
+/* Date and time are BCD coded */
 struct display_data_struct
 {
 	uint8_t hour;
@@ -25,8 +26,8 @@ struct display_data_struct
 
 	uint8_t hour_colon;
 
-	int8_t int_temperature;
-	int8_t ext_temperature;
+	int16_t int_temperature;	/* Tenths of *C */
+	int16_t ext_temperature;
 
 	uint8_t intensity;
 
@@ -48,4 +49,11 @@ void Update_display_config(volatile struct display_data_struct *data);
 
 void Update_display_data(volatile struct display_data_struct *data);
 
+uint8_t Is_display_busy(void);
+
+uint8_t Claim_display_DMA(void);
+void Release_display_DMA(void);
+
+void Display_DMA_IRQ_handler(void);
+
 #endif /* DISPLAY_DRV_H_ */
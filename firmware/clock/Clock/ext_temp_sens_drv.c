@@ -6,21 +6,37 @@
  */
 
 
+#include "ext_temp_sens_drv.h"
+
+#include <stddef.h>
+#include <assert.h>
+
 #include "common_defs.h"
 #include "common_fcns.h"
 #include "onewire_bridge_drv.h"
+#include "scheduler.h"
 
 
 /* DS18B20 Commands */
+#define DS18B20_MATCH_ROM			0x55
 #define DS18B20_SKIP_ROM			0xCC
+#define DS18B20_OVERDRIVE_MATCH_ROM	0x69	// Overdrive capable devices only, ROM code at overdrive speed
 #define DS18B20_CONVERT_T			0x44
 #define DS18B20_WRITE_SCRATCHPAD	0x4E
 #define DS18B20_READ_SCRATCHPAD		0xBE
+#define DS18B20_READ_POWER_SUPPLY	0xB4	// Parasite powered devices answer 0 in read slot
 
 /* DS18B20 Constants */
+#define DS18B20_FAMILY_CODE			0x28	// First byte of ROM code
+#define DS28EA00_FAMILY_CODE		0x42	// Same scratchpad, supports overdrive
+#define DS18B20_CONFIG_MASK			0x9F	// Fixed bits of Configuration Register
+#define DS18B20_CONFIG_FIXED		0x1F
 #define DS18B20_TH_BYTE				0x7F	// Temperature High Threshold = 127*C (set out of range to not trigger alarm)
 #define DS18B20_TL_BYTE				0x80	// Temperature Low Threshold = -128*C (set out of range to not trigger alarm)
-#define DS18B20_CONFIG_BYTE			0x7F	// Configuration Register (12-bit resolution, default value)
+#define DS18B20_CONFIG_BYTE(res)	((((res) - 9) << 5) | 0x1F)	// Configuration Register, R1 R0 select 9 to 12-bit resolution
+#define DS18B20_CONFIG_RESOLUTION(cfg)	((((cfg) >> 5) & 0x03) + 9)	// Resolution selected by Configuration Register
+#define DS18B20_CONV_TIME_9BIT		93750	//us, doubles with each bit
+#define DS18B20_TEMP_FRAC_BITS		4		// 0.0625*C at 12-bit, lower bits undefined at lower resolution
 
 /* DS18B20 Scratchpad */
 #define DS18B20_SCRATCHPAD_SIZE		9		// Scratchpad size in bytes
@@ -34,82 +50,392 @@
 #define DS18B20_RESERVED3_INDEX		7		// Reserved byte 3 index in scratchpad
 #define DS18B20_CRC_INDEX			8		// CRC index in scratchpad
 
-/* DS18B20 CRC */
-#define DS18B20_CRC_INIT_VALUE		0x00
-#define DS18B20_CRC_MSB_MASK		0x01
-#define DS18B20_CRC_POLYNOMIAL		0x8C	// Polynomial x^8 + x^5 + x^4 + 1 (0x31 reversed)
-
+/* DS18B20 CRC, Dallas CRC-8 */
 #define DS18B20_CRC_SIZE			1											// Size of the CRC in bytes
 #define DS18B20_CRC_CALC_SIZE		(DS18B20_SCRATCHPAD_SIZE - DS18B20_CRC_SIZE)// Number of bytes to use for CRC calculation
 
+/* Bytes written by WRITE SCRATCHPAD: TH, TL, Configuration Register */
+#define DS18B20_CONFIG_DATA_SIZE	3
 
+/* Sequences are run one 1-Wire operation per step, so bus is shared with RTC reads */
+enum ONEWIRE_OPS
+{
+	ONEWIRE_OP_RESET = 0,
+	ONEWIRE_OP_WRITE,			/* Write byte from data */
+	ONEWIRE_OP_WRITE_POWER,		/* Write byte from data, then strong pull-up until next operation */
+	ONEWIRE_OP_SPEED,			/* Overdrive if data is TRUE */
+	ONEWIRE_OP_WRITE_ROM,		/* Write ROM code of current sensor, one byte per step */
+	ONEWIRE_OP_WRITE_CONFIG,	/* Write TH, TL and configuration, one byte per step */
+	ONEWIRE_OP_READ,			/* Read data number of bytes to scratchpad, one per step */
+	ONEWIRE_OP_WAIT_READY		/* Read slots until conversion is done */
+};
+
+struct onewire_op_struct
+{
+	uint8_t op;
+	uint8_t data;
+};
 
-static uint8_t DS18B20_set_configuration(void);
-static uint8_t DS18B20_read_scratchpad(uint8_t *scratch);
-static uint8_t DS18B20_calculate_CRC(const uint8_t *data, uint8_t len);
-
+/* All sensors convert at once, standard reset returns all of them to standard speed */
+static const struct onewire_op_struct conversion_sequence[] =
+{
+	{ONEWIRE_OP_SPEED,		FALSE},
+	{ONEWIRE_OP_RESET,		0},
+	{ONEWIRE_OP_WRITE,		DS18B20_SKIP_ROM},
+	{ONEWIRE_OP_WRITE,		DS18B20_CONVERT_T},
+	{ONEWIRE_OP_WAIT_READY,	0}
+};
+
+/* Parasite powered sensors need strong pull-up while converting, and can not report when done */
+static const struct onewire_op_struct parasite_conversion_sequence[] =
+{
+	{ONEWIRE_OP_SPEED,		FALSE},
+	{ONEWIRE_OP_RESET,		0},
+	{ONEWIRE_OP_WRITE,		DS18B20_SKIP_ROM},
+	{ONEWIRE_OP_WRITE_POWER,	DS18B20_CONVERT_T},
+	{ONEWIRE_OP_WAIT_READY,	0}
+};
+
+/* Sensor lost its configuration, written to all before next conversion */
+static const struct onewire_op_struct config_sequence[] =
+{
+	{ONEWIRE_OP_SPEED,			FALSE},
+	{ONEWIRE_OP_RESET,			0},
+	{ONEWIRE_OP_WRITE,			DS18B20_SKIP_ROM},
+	{ONEWIRE_OP_WRITE,			DS18B20_WRITE_SCRATCHPAD},
+	{ONEWIRE_OP_WRITE_CONFIG,	DS18B20_CONFIG_DATA_SIZE}
+};
+
+/* Repeated for each sensor */
+static const struct onewire_op_struct read_sequence[] =
+{
+	{ONEWIRE_OP_SPEED,		FALSE},
+	{ONEWIRE_OP_RESET,		0},
+	{ONEWIRE_OP_WRITE,		DS18B20_MATCH_ROM},
+	{ONEWIRE_OP_WRITE_ROM,	ONEWIRE_ROM_SIZE},
+	{ONEWIRE_OP_WRITE,		DS18B20_READ_SCRATCHPAD},
+	{ONEWIRE_OP_READ,		DS18B20_SCRATCHPAD_SIZE}
+};
+
+/* Sensor switches to overdrive with the command, the rest runs at overdrive speed */
+static const struct onewire_op_struct overdrive_read_sequence[] =
+{
+	{ONEWIRE_OP_SPEED,		FALSE},
+	{ONEWIRE_OP_RESET,		0},
+	{ONEWIRE_OP_WRITE,		DS18B20_OVERDRIVE_MATCH_ROM},
+	{ONEWIRE_OP_SPEED,		TRUE},
+	{ONEWIRE_OP_WRITE_ROM,	ONEWIRE_ROM_SIZE},
+	{ONEWIRE_OP_WRITE,		DS18B20_READ_SCRATCHPAD},
+	{ONEWIRE_OP_READ,		DS18B20_SCRATCHPAD_SIZE}
+};
+
+/* Datasheet temperature/data relationship, rounded to tenths */
+static_assert((FIXED_TO_TENTHS((int16_t)0x07D0, DS18B20_TEMP_FRAC_BITS) == 1250) && (FIXED_TO_TENTHS((int16_t)0x0550, DS18B20_TEMP_FRAC_BITS) == 850) &&
+			  (FIXED_TO_TENTHS((int16_t)0x0191, DS18B20_TEMP_FRAC_BITS) == 251) && (FIXED_TO_TENTHS((int16_t)0x00A2, DS18B20_TEMP_FRAC_BITS) == 101) &&
+			  (FIXED_TO_TENTHS((int16_t)0x0008, DS18B20_TEMP_FRAC_BITS) == 5) && (FIXED_TO_TENTHS((int16_t)0x0000, DS18B20_TEMP_FRAC_BITS) == 0) &&
+			  (FIXED_TO_TENTHS((int16_t)0xFFF8, DS18B20_TEMP_FRAC_BITS) == -5) && (FIXED_TO_TENTHS((int16_t)0xFF5E, DS18B20_TEMP_FRAC_BITS) == -101) &&
+			  (FIXED_TO_TENTHS((int16_t)0xFE6F, DS18B20_TEMP_FRAC_BITS) == -251) && (FIXED_TO_TENTHS((int16_t)0xFC90, DS18B20_TEMP_FRAC_BITS) == -550),
+			  "Wrong DS18B20 temperature conversion");
+
+#define CONVERSION_SEQUENCE_LEN				(sizeof(conversion_sequence) / sizeof(conversion_sequence[0]))
+#define PARASITE_CONVERSION_SEQUENCE_LEN	(sizeof(parasite_conversion_sequence) / sizeof(parasite_conversion_sequence[0]))
+#define CONFIG_SEQUENCE_LEN					(sizeof(config_sequence) / sizeof(config_sequence[0]))
+#define READ_SEQUENCE_LEN					(sizeof(read_sequence) / sizeof(read_sequence[0]))
+#define OVERDRIVE_READ_SEQUENCE_LEN			(sizeof(overdrive_read_sequence) / sizeof(overdrive_read_sequence[0]))
+
+static const struct onewire_op_struct *current_sequence = NULL;
+static uint8_t current_sequence_len = 0;
+static uint8_t current_op = 0;
+static uint8_t op_started = FALSE;
+static uint8_t reading_sensors = FALSE;
+static uint8_t ext_temp_status = EXT_TEMP_IDLE;
+
+static uint8_t scratch[DS18B20_SCRATCHPAD_SIZE];
+static uint8_t byte_index = 0;
+
+/* Sensors found by ROM search */
+static uint8_t sensor_roms[EXT_TEMP_MAX_SENSORS][ONEWIRE_ROM_SIZE];
+static uint8_t num_of_sensors = 0;
+static uint8_t current_sensor = 0;
+
+/* Found at startup, per sensor */
+static uint8_t sensor_overdrive[EXT_TEMP_MAX_SENSORS];
+static uint8_t ext_temp_parasite = FALSE;
+
+#ifdef DEBUG
+/* CRC load and bus time, read out with debugger */
+volatile uint32_t ext_temp_crc_cycles = 0;			/* SysTick cycles of last scratchpad CRC */
+volatile uint32_t ext_temp_sensor_read_time = 0;	/* TIM14 counts of last sensor read sequence */
+volatile uint32_t ext_temp_reconfigurations = 0;	/* Sensors found with configuration lost */
+static uint32_t sensor_read_start = 0;
+#endif
+
+static int16_t sensor_temperatures[EXT_TEMP_MAX_SENSORS];		/* Tenths of *C */
+static uint8_t sensor_valid[EXT_TEMP_MAX_SENSORS];
+
+/* Sensors hold the bus low while converting */
+static uint8_t ext_temp_resolution = EXT_TEMP_MAX_RESOLUTION;
+static uint8_t config_data[DS18B20_CONFIG_DATA_SIZE];
+static uint8_t reconfigure_pending = FALSE;
+static uint32_t conversion_max;
+static uint32_t conversion_timeout;
+static uint32_t conversion_start;
+static uint32_t ready_poll_time;
+static uint32_t conversion_time = 0;
 
-uint8_t Init_ext_temp_sens(void)
+static uint8_t DS18B20_set_configuration(void);
+static uint8_t DS18B20_is_parasite_powered(void);
+#if EXT_TEMP_OVERDRIVE_ENABLED == TRUE
+static uint8_t DS18B20_probe_overdrive(const uint8_t *rom);
+#endif
+static uint8_t DS18B20_decode_scratchpad(int16_t *temperature);
+inline static uint8_t Start_sequence(const struct onewire_op_struct *sequence, uint8_t sequence_len);
+inline static void Set_sequence(const struct onewire_op_struct *sequence, uint8_t sequence_len);
+inline static void Finish_op(const struct onewire_op_struct *op);
+inline static void Finish_sensor_read(uint8_t read_OK);
+inline static void Set_read_sequence(void);
+inline static void Set_conversion_sequence(void);
+
+
+uint8_t Init_ext_temp_sens(uint8_t resolution)
 {
 	uint8_t init_OK = FALSE;
 
+	uint8_t roms[EXT_TEMP_MAX_SENSORS][ONEWIRE_ROM_SIZE];
+	uint8_t num_of_roms;
+
+	/* Enumerate devices on the bus */
+	num_of_roms = OneWire_search_ROMs(roms, EXT_TEMP_MAX_SENSORS);
+
+	/* Cache temperature sensors only */
+	num_of_sensors = 0;
+
+	for(uint8_t i = 0; i < num_of_roms; i++)
+	{
+		if((roms[i][0] == DS18B20_FAMILY_CODE) || (roms[i][0] == DS28EA00_FAMILY_CODE))
+		{
+			for(uint8_t j = 0; j < ONEWIRE_ROM_SIZE; j++)
+			{
+				sensor_roms[num_of_sensors][j] = roms[i][j];
+			}
+
+			sensor_valid[num_of_sensors] = FALSE;
+			sensor_overdrive[num_of_sensors] = FALSE;
+			num_of_sensors++;
+		}
+	}
+
+	/* Conversion time doubles with each bit of resolution, allow 25% more */
+	ext_temp_resolution = resolution;
+	config_data[0] = DS18B20_TH_BYTE;
+	config_data[1] = DS18B20_TL_BYTE;
+	config_data[2] = DS18B20_CONFIG_BYTE(resolution);
+	conversion_max = SCHEDULER_US_TO_COUNTS(DS18B20_CONV_TIME_9BIT) << (resolution - EXT_TEMP_MIN_RESOLUTION);
+	conversion_timeout = conversion_max + (conversion_max >> 2);
+
 	/* Trigger 1-Wire Reset to check if an external temperature sensor is present */
-	if(OneWire_reset() == TRUE)
+	if((num_of_sensors > 0) && (OneWire_reset() == TRUE))
 	{
+		/* Same configuration for all sensors */
 		init_OK = DS18B20_set_configuration();
 	}
 
+	if(init_OK == TRUE)
+	{
+#if EXT_TEMP_STRONG_PULLUP_ENABLED == TRUE
+		/* Any parasite powered sensor needs strong pull-up for all */
+		ext_temp_parasite = DS18B20_is_parasite_powered();
+#endif
+
+#if EXT_TEMP_OVERDRIVE_ENABLED == TRUE
+		/* Remember speed of each sensor, only DS28EA00 supports overdrive, DS18B20 is not probed */
+		for(uint8_t i = 0; i < num_of_sensors; i++)
+		{
+			if(sensor_roms[i][0] == DS28EA00_FAMILY_CODE)
+			{
+				sensor_overdrive[i] = DS18B20_probe_overdrive(sensor_roms[i]);
+			}
+		}
+#endif
+	}
+
 	return init_OK;
 }
 
-uint8_t Ext_temp_start_conversion(void)
+uint8_t Ext_temp_start_measurement(void)
 {
-	uint8_t conversion_triggered_OK = FALSE;
+	if(num_of_sensors == 0)
+	{
+		return FALSE;
+	}
 
-	if(OneWire_reset() == TRUE)
+	if(reconfigure_pending == TRUE)
 	{
-		if(OneWire_write_byte(DS18B20_SKIP_ROM) == TRUE)
-		{
-			if(OneWire_write_byte(DS18B20_CONVERT_T) == TRUE)
-			{
-				conversion_triggered_OK = TRUE;
-			}
-		}
+		/* Restore configuration first, conversion follows */
+		return Start_sequence(config_sequence, CONFIG_SEQUENCE_LEN);
 	}
 
-	return conversion_triggered_OK;
+	/* Reset, SKIP ROM, CONVERT T, wait until done; then read each sensor */
+	if(ext_temp_parasite == TRUE)
+	{
+		return Start_sequence(parasite_conversion_sequence, PARASITE_CONVERSION_SEQUENCE_LEN);
+	}
+
+	return Start_sequence(conversion_sequence, CONVERSION_SEQUENCE_LEN);
 }
 
-uint8_t Ext_temp_read_temperature(int8_t *temperature)
+uint8_t Get_ext_temp_sensor_count(void)
 {
-	uint8_t read_OK = FALSE;
+	return num_of_sensors;
+}
 
-	uint8_t scratch[DS18B20_SCRATCHPAD_SIZE];
+uint32_t Get_ext_temp_conversion_time(void)
+{
+	/* Last measured, in TIM14 counts */
+	return conversion_time;
+}
 
-	/* Read scratchpad */
-	if(DS18B20_read_scratchpad(scratch) == TRUE)
+uint8_t Is_ext_temp_busy(void)
+{
+	return (ext_temp_status == EXT_TEMP_BUSY) ? TRUE : FALSE;
+}
+
+uint8_t Ext_temp_step(void)
+{
+	uint8_t step_OK = FALSE;
+	uint8_t onewire_status;
+	const struct onewire_op_struct *op;
+
+	if(ext_temp_status != EXT_TEMP_BUSY)
 	{
-		/* Calculate and check CRC */
-		if(DS18B20_calculate_CRC(scratch, DS18B20_CRC_CALC_SIZE) == scratch[DS18B20_CRC_INDEX])
+		/* Nothing to do */
+		return ext_temp_status;
+	}
+
+	op = &current_sequence[current_op];
+
+	if(op_started == TRUE)
+	{
+		/* Advance DS2482 state machine */
+		onewire_status = OneWire_step();
+
+		if(onewire_status == ONEWIRE_BUSY)
 		{
-			/* Combine LSB and MSB to get temperature in Celsius */
-			int16_t raw_temp = (int16_t)((scratch[DS18B20_TEMP_MSB_INDEX] << 8) | scratch[DS18B20_TEMP_LSB_INDEX]);
+			/* Operation in progress */
+			return ext_temp_status;
+		}
 
-			/* Convert raw temperature to integer Celsius (discard fractional part) */
-			*temperature = (int8_t)(raw_temp >> 4);
+		op_started = FALSE;
 
-			read_OK = TRUE;
+		if(onewire_status != ONEWIRE_DONE)
+		{
+			if(reading_sensors == TRUE)
+			{
+				/* Skip to next sensor */
+				Finish_sensor_read(FALSE);
+			}
+			else
+			{
+				/* Bridge failed, or no presence pulse; abandon sequence */
+				ext_temp_status = EXT_TEMP_FAILED;
+			}
 		}
 		else
 		{
-			/* CRC mismatch, data invalid */
-			read_OK = FALSE;
+			Finish_op(op);
+		}
+
+		if(ext_temp_status != EXT_TEMP_BUSY)
+		{
+			return ext_temp_status;
 		}
+
+		op = &current_sequence[current_op];
+	}
+
+	if(op->op == ONEWIRE_OP_WAIT_READY)
+	{
+		if(ext_temp_parasite == TRUE)
+		{
+			/* Read slot would end strong pull-up, wait nominal conversion time */
+			if((Get_scheduler_time() - conversion_start) >= conversion_max)
+			{
+				Finish_op(op);
+			}
+
+			return ext_temp_status;
+		}
+
+		if((Get_scheduler_time() - ready_poll_time) < SCHEDULER_US_TO_COUNTS(EXT_TEMP_READY_POLL_PERIOD))
+		{
+			/* Leave bus alone between read slots */
+			return ext_temp_status;
+		}
+	}
+
+	/* Start next operation */
+	switch(op->op)
+	{
+		case ONEWIRE_OP_RESET:
+			step_OK = OneWire_start_reset();
+			break;
+
+		case ONEWIRE_OP_WRITE:
+			step_OK = OneWire_start_write_byte(op->data);
+			break;
+
+		case ONEWIRE_OP_WRITE_POWER:
+			step_OK = OneWire_start_write_byte_power(op->data);
+			break;
+
+		case ONEWIRE_OP_SPEED:
+			step_OK = OneWire_start_set_speed(op->data);
+			break;
+
+		case ONEWIRE_OP_WRITE_ROM:
+			step_OK = OneWire_start_write_byte(sensor_roms[current_sensor][byte_index]);
+			break;
+
+		case ONEWIRE_OP_WRITE_CONFIG:
+			step_OK = OneWire_start_write_byte(config_data[byte_index]);
+			break;
+
+		case ONEWIRE_OP_READ:
+			step_OK = OneWire_start_read_byte();
+			break;
+
+		case ONEWIRE_OP_WAIT_READY:
+			ready_poll_time = Get_scheduler_time();
+			step_OK = OneWire_start_read_bit();
+			break;
+
+		default:
+			break;
+	}
+
+	if(step_OK == TRUE)
+	{
+		op_started = TRUE;
 	}
 	else
 	{
-		/* Failed to read scratchpad */
-		read_OK = FALSE;
+		/* Abandon sequence */
+		ext_temp_status = EXT_TEMP_FAILED;
+	}
+
+	return ext_temp_status;
+}
+
+uint8_t Ext_temp_read_temperature(uint8_t sensor, int16_t *temperature)
+{
+	uint8_t read_OK = FALSE;
+
+	/* Last read of this sensor passed CRC check */
+	if((sensor < num_of_sensors) && (sensor_valid[sensor] == TRUE))
+	{
+		*temperature = sensor_temperatures[sensor];
+
+		read_OK = TRUE;
 	}
 
 	return read_OK;
@@ -127,7 +453,7 @@ static uint8_t DS18B20_set_configuration(void)
 			{
 				if(OneWire_write_byte(DS18B20_TL_BYTE) == TRUE)
 				{
-					if(OneWire_write_byte(DS18B20_CONFIG_BYTE) == TRUE)
+					if(OneWire_write_byte(DS18B20_CONFIG_BYTE(ext_temp_resolution)) == TRUE)
 					{
 						configured_OK = TRUE;
 					}
@@ -139,77 +465,276 @@ static uint8_t DS18B20_set_configuration(void)
 	return configured_OK;
 }
 
-static uint8_t DS18B20_read_scratchpad(uint8_t *scratch)
+static uint8_t DS18B20_is_parasite_powered(void)
 {
-	uint8_t read_OK = TRUE;
+	uint8_t power_supply = 1;
 
+	/* Read slot is held low by any parasite powered sensor */
 	if(OneWire_reset() == TRUE)
 	{
 		if(OneWire_write_byte(DS18B20_SKIP_ROM) == TRUE)
 		{
-			if(OneWire_write_byte(DS18B20_READ_SCRATCHPAD) == TRUE)
+			if(OneWire_write_byte(DS18B20_READ_POWER_SUPPLY) == TRUE)
 			{
-				for(uint8_t i = 0; i < DS18B20_SCRATCHPAD_SIZE; i++)
+				if(OneWire_read_bit(&power_supply) == FALSE)
 				{
-					if(OneWire_read_byte(&scratch[i]) == TRUE)
-					{
-						/* Byte read successfully, continue */
-						continue;
-					}
-					else
-					{
-						/* Failed to read byte */
-						read_OK = FALSE;
-
-						/* Quit */
-						break;
-					}
+					/* Unknown, assume external supply */
+					power_supply = 1;
 				}
 			}
-			else
+		}
+	}
+
+	return (power_supply == 0) ? TRUE : FALSE;
+}
+
+#if EXT_TEMP_OVERDRIVE_ENABLED == TRUE
+static uint8_t DS18B20_probe_overdrive(const uint8_t *rom)
+{
+	uint8_t overdrive_OK = FALSE;
+
+	/* Devices without overdrive ignore the command, and wait for reset */
+	if((OneWire_reset() == TRUE) && (OneWire_write_byte(DS18B20_OVERDRIVE_MATCH_ROM) == TRUE) && (OneWire_set_speed(TRUE) == TRUE))
+	{
+		overdrive_OK = TRUE;
+
+		for(uint8_t i = 0; (i < ONEWIRE_ROM_SIZE) && (overdrive_OK == TRUE); i++)
+		{
+			overdrive_OK = OneWire_write_byte(rom[i]);
+		}
+
+		if(overdrive_OK == TRUE)
+		{
+			overdrive_OK = OneWire_write_byte(DS18B20_READ_SCRATCHPAD);
+		}
+
+		for(uint8_t i = 0; (i < DS18B20_SCRATCHPAD_SIZE) && (overdrive_OK == TRUE); i++)
+		{
+			overdrive_OK = OneWire_read_byte(&scratch[i]);
+		}
+
+		/* Sensor answered at overdrive speed, if scratchpad is consistent */
+		if((overdrive_OK == TRUE) &&
+		   ((OneWire_CRC8(scratch, DS18B20_CRC_CALC_SIZE) != scratch[DS18B20_CRC_INDEX]) ||
+			((scratch[DS18B20_CONFIG_INDEX] & DS18B20_CONFIG_MASK) != DS18B20_CONFIG_FIXED)))
+		{
+			overdrive_OK = FALSE;
+		}
+	}
+
+	/* Standard reset returns all devices to standard speed */
+	(void)OneWire_set_speed(FALSE);
+	(void)OneWire_reset();
+
+	return overdrive_OK;
+}
+#endif
+
+static uint8_t DS18B20_decode_scratchpad(int16_t *temperature)
+{
+	uint8_t decode_OK = FALSE;
+	uint8_t crc;
+	uint8_t resolution;
+
+#ifdef DEBUG
+	uint32_t crc_start = GET_CYCLES;
+#endif
+
+	/* Calculate CRC */
+	crc = OneWire_CRC8(scratch, DS18B20_CRC_CALC_SIZE);
+
+#ifdef DEBUG
+	ext_temp_crc_cycles = CYCLES_SINCE(crc_start);
+#endif
+
+	/* Check CRC */
+	if((crc == scratch[DS18B20_CRC_INDEX]) &&
+	   ((scratch[DS18B20_CONFIG_INDEX] & DS18B20_CONFIG_MASK) == DS18B20_CONFIG_FIXED))
+	{
+		/* Combine LSB and MSB to get temperature in 1/16 *C */
+		int16_t raw_temp = (int16_t)((scratch[DS18B20_TEMP_MSB_INDEX] << 8) | scratch[DS18B20_TEMP_LSB_INDEX]);
+
+		/* Sensor converted at resolution it reports */
+		resolution = DS18B20_CONFIG_RESOLUTION(scratch[DS18B20_CONFIG_INDEX]);
+
+		if(resolution != ext_temp_resolution)
+		{
+			/* Power cycled back to EEPROM resolution, restore with next measurement */
+			reconfigure_pending = TRUE;
+
+#ifdef DEBUG
+			ext_temp_reconfigurations++;
+#endif
+		}
+
+		/* Clear bits undefined at lower resolution */
+		raw_temp &= (int16_t)(0xFFFF << (EXT_TEMP_MAX_RESOLUTION - resolution));
+
+		/* Convert raw temperature to tenths of *C */
+		*temperature = FIXED_TO_TENTHS(raw_temp, DS18B20_TEMP_FRAC_BITS);
+
+		decode_OK = TRUE;
+	}
+	else
+	{
+		/* CRC mismatch, data invalid */
+		decode_OK = FALSE;
+	}
+
+	return decode_OK;
+}
+
+inline static uint8_t Start_sequence(const struct onewire_op_struct *sequence, uint8_t sequence_len)
+{
+	if(ext_temp_status == EXT_TEMP_BUSY)
+	{
+		/* Previous sequence did not finish yet */
+		return FALSE;
+	}
+
+	Set_sequence(sequence, sequence_len);
+
+	ext_temp_status = EXT_TEMP_BUSY;
+
+	return TRUE;
+}
+
+inline static void Set_sequence(const struct onewire_op_struct *sequence, uint8_t sequence_len)
+{
+	current_sequence = sequence;
+	current_sequence_len = sequence_len;
+	current_op = 0;
+	op_started = FALSE;
+	byte_index = 0;
+	reading_sensors = FALSE;
+}
+
+inline static void Finish_op(const struct onewire_op_struct *op)
+{
+	switch(op->op)
+	{
+		case ONEWIRE_OP_READ:
+		case ONEWIRE_OP_WRITE_ROM:
+		case ONEWIRE_OP_WRITE_CONFIG:
+			if(op->op == ONEWIRE_OP_READ)
 			{
-				/* Failed to read scratchpad */
-				read_OK = FALSE;
+				scratch[byte_index] = Get_OneWire_data();
 			}
+
+			byte_index++;
+
+			/* Stay on this operation, until all bytes are done */
+			if(byte_index >= op->data)
+			{
+				byte_index = 0;
+				current_op++;
+			}
+			break;
+
+		case ONEWIRE_OP_WAIT_READY:
+			if((ext_temp_parasite == TRUE) || (Get_OneWire_data() != 0))
+			{
+				/* All sensors released the bus, or nominal time elapsed */
+				conversion_time = Get_scheduler_time() - conversion_start;
+				current_op++;
+			}
+			else if((Get_scheduler_time() - conversion_start) > conversion_timeout)
+			{
+				/* Bus held low */
+				ext_temp_status = EXT_TEMP_FAILED;
+			}
+			break;
+
+		default:
+			current_op++;
+			break;
+	}
+
+	if((ext_temp_status == EXT_TEMP_BUSY) && (current_op < current_sequence_len) &&
+	   (current_sequence[current_op].op == ONEWIRE_OP_WAIT_READY) && (op->op != ONEWIRE_OP_WAIT_READY))
+	{
+		/* Conversion started now, first read slot after one poll period */
+		conversion_start = Get_scheduler_time();
+		ready_poll_time = conversion_start;
+	}
+
+	if((ext_temp_status == EXT_TEMP_BUSY) && (current_op >= current_sequence_len))
+	{
+		if(reading_sensors == TRUE)
+		{
+			/* Scratchpad of current sensor is complete */
+			Finish_sensor_read(TRUE);
+		}
+		else if(current_sequence == config_sequence)
+		{
+			/* Configuration restored, convert with it */
+			reconfigure_pending = FALSE;
+			Set_conversion_sequence();
 		}
 		else
 		{
-			/* Failed to write SKIP ROM */
-			read_OK = FALSE;
+			/* Conversion done, read each sensor: reset, MATCH ROM, ROM code, READ SCRATCHPAD, 9 bytes */
+			current_sensor = 0;
+			Set_read_sequence();
 		}
 	}
+}
+
+inline static void Finish_sensor_read(uint8_t read_OK)
+{
+#ifdef DEBUG
+	ext_temp_sensor_read_time = Get_scheduler_time() - sensor_read_start;
+#endif
+
+	if(read_OK == TRUE)
+	{
+		sensor_valid[current_sensor] = DS18B20_decode_scratchpad(&sensor_temperatures[current_sensor]);
+	}
 	else
 	{
-		/* 1-Wire reset failed */
-		read_OK = FALSE;
+		sensor_valid[current_sensor] = FALSE;
 	}
 
-	return read_OK;
+	current_sensor++;
+
+	if(current_sensor < num_of_sensors)
+	{
+		/* Addressed to next sensor, at its speed */
+		Set_read_sequence();
+	}
+	else
+	{
+		/* Validity is kept per sensor */
+		ext_temp_status = EXT_TEMP_DONE;
+	}
 }
 
-/* Maxim/Dallas 8-bit CRC calculation for DS18B20 */
-static uint8_t DS18B20_calculate_CRC(const uint8_t *data, uint8_t len)
+inline static void Set_read_sequence(void)
 {
-    uint8_t crc = DS18B20_CRC_INIT_VALUE;
-
-    for(uint8_t i = 0; i < len; i++)
+	if(sensor_overdrive[current_sensor] == TRUE)
+	{
+		Set_sequence(overdrive_read_sequence, OVERDRIVE_READ_SEQUENCE_LEN);
+	}
+	else
 	{
-        uint8_t inbyte = data[i];
+		Set_sequence(read_sequence, READ_SEQUENCE_LEN);
+	}
 
-        for(uint8_t j = 0; j < 8; j++)
-		{
-            if((crc ^ inbyte) & DS18B20_CRC_MSB_MASK)
-            {
-        		crc = (crc >> 1) ^ DS18B20_CRC_POLYNOMIAL;
-            }
-            else
-            {
-                crc >>= 1;
-            }
+	reading_sensors = TRUE;
 
-            inbyte >>= 1;
-        }
-    }
+#ifdef DEBUG
+	sensor_read_start = Get_scheduler_time();
+#endif
+}
 
-    return crc;
+inline static void Set_conversion_sequence(void)
+{
+	if(ext_temp_parasite == TRUE)
+	{
+		Set_sequence(parasite_conversion_sequence, PARASITE_CONVERSION_SEQUENCE_LEN);
+	}
+	else
+	{
+		Set_sequence(conversion_sequence, CONVERSION_SEQUENCE_LEN);
+	}
 }
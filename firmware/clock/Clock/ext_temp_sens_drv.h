@@ -10,10 +10,23 @@
 
 #include <stdint.h>
 
+enum EXT_TEMP_STATUSES
+{
+	EXT_TEMP_IDLE = 0,
+	EXT_TEMP_BUSY,
+	EXT_TEMP_DONE,
+	EXT_TEMP_FAILED
+};
 
-uint8_t Init_ext_temp_sens(void);
+uint8_t Init_ext_temp_sens(uint8_t resolution);
 
-uint8_t Ext_temp_start_conversion(void);
-uint8_t Ext_temp_read_temperature(int8_t *temperature);
+uint8_t Ext_temp_start_measurement(void);
+uint32_t Get_ext_temp_conversion_time(void);
+
+uint8_t Is_ext_temp_busy(void);
+uint8_t Ext_temp_step(void);
+
+uint8_t Get_ext_temp_sensor_count(void);
+uint8_t Ext_temp_read_temperature(uint8_t sensor, int16_t *temperature);
 
 #endif /* EXT_TEMP_SENS_DRV_H_ */
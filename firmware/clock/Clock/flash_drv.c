@@ -65,9 +65,6 @@ void Write_settings(volatile struct settings_struct *s)
 	/* Write ID */
 	s->ID = FLASH_SETTINGS_ID;
 
-	/* Clear unused field */
-	s->unused = 0;
-
 	/* Update CRC */
 	s->crc = Calculate_CRC32((uint8_t *)s, sizeof(struct settings_struct) - sizeof(uint32_t));
 
@@ -98,8 +95,15 @@ uint8_t Verify_settings(struct settings_struct *s)
 
 			/* Check data validity */
 
-			/* Check intensity setting */
-			if((s->intensity < MAX_INTENSITY) && (s->intensity > MIN_INTENSITY))
+			/* Settings stored before resolution was added keep 0 there */
+			if(s->ext_temp_resolution == 0)
+			{
+				s->ext_temp_resolution = EXT_TEMP_DEFAULT_RESOLUTION;
+			}
+
+			/* Check intensity and external temperature resolution settings */
+			if((s->intensity < MAX_INTENSITY) && (s->intensity > MIN_INTENSITY) &&
+			   (s->ext_temp_resolution >= EXT_TEMP_MIN_RESOLUTION) && (s->ext_temp_resolution <= EXT_TEMP_MAX_RESOLUTION))
 			{
 				/* Settings OK */
 				settings_OK = TRUE;
@@ -114,6 +118,7 @@ void Restore_settings_to_default(struct settings_struct *s)
 {
 	/* Assign default value */
 	s->intensity = (MAX_INTENSITY + MIN_INTENSITY) / 2;
+	s->ext_temp_resolution = EXT_TEMP_DEFAULT_RESOLUTION;
 }
 
 void Flash_read(volatile struct settings_struct *s)
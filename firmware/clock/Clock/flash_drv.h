@@ -16,7 +16,7 @@ struct settings_struct
 
 	uint8_t intensity;
 
-	uint8_t unused;
+	uint8_t ext_temp_resolution;
 
 	uint32_t crc;
 };
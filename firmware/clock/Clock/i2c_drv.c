@@ -12,192 +12,490 @@
 #include "common_defs.h"
 #include "common_fcns.h"
 
+#include "scheduler.h"
+#include "display_drv.h"
+
 #define I2C_TIMEOUT				5		//ms
 
 #define I2C_READ_ADDR_BIT		0x01
 
+#define I2C_QUEUE_LEN			4
+
+/* I2C1 DMA channels, shared with SPI1 of the display */
+#define I2C_TX_DMA_CHANNEL		LL_DMA_CHANNEL_2
+#define I2C_RX_DMA_CHANNEL		LL_DMA_CHANNEL_3
+
+/* Shorter transfers are cheaper by interrupts */
+#define I2C_DMA_MIN_LEN			4
+
+/* I2C1 pins, driven as GPIO during bus recovery */
+#define I2C_GPIO_PORT			GPIOA
+#define I2C_SCL_PIN				LL_GPIO_PIN_9
+#define I2C_SDA_PIN				LL_GPIO_PIN_10
+
+/* Enough to finish any byte a slave was sending, at 100kHz */
+#define I2C_RECOVERY_PULSES		9
+#define I2C_RECOVERY_HALF_PERIOD_NS	5000
+
+/* Retries of a stuck bus, doubled after each failure */
+#define I2C_BACKOFF_MIN			8		//ms
+#define I2C_BACKOFF_MAX			4096	//ms
+
+enum I2C_BUS_STATES
+{
+	I2C_BUS_OK = 0,
+	I2C_BUS_RECOVERY,		/* Recover, before next transfer */
+	I2C_BUS_DEGRADED		/* Recovery failed, wait for backoff */
+};
+
+/* TIMINGR for 16MHz SYSCLK as I2CCLK, standard mode as generated by CubeMX */
+static const uint32_t i2c_timings[NUM_OF_I2C_SPEEDS] =
+{
+	0x00503D58,		/* 100kHz */
+	0x10320309,		/* 400kHz */
+	0x00200204		/* 1MHz, needs FM+ drive on pins */
+};
+
+/* Devices with own speed, others use standard mode */
+#define I2C_NUM_OF_SPEEDS		4
+
+/* Drop to slower speed after errors in a row, go back after good transfers in a row */
+#define I2C_SPEED_FALLBACK_ERRORS	3
+#define I2C_SPEED_RESTORE_TRANSFERS	1000
+
+struct i2c_speed_struct
+{
+	uint8_t device_addr;
+	uint8_t max_speed;
+	uint8_t speed;
+	uint8_t errors;
+	uint16_t good_transfers;
+};
+
+/* Devices profiled separately, the rest share the last entry */
+#define I2C_NUM_OF_STATS		4
+
+/* Requests waiting for the bus, circular buffer */
+static struct i2c_request_struct * volatile i2c_queue[I2C_QUEUE_LEN];
+static volatile uint8_t i2c_queue_head = 0;
+static volatile uint8_t i2c_queue_count = 0;
+
+/* Request being transferred */
+static struct i2c_request_struct * volatile current_request = NULL;
+static volatile uint8_t current_index = 0;
+static volatile uint8_t current_nack = FALSE;
+static volatile uint8_t current_dma = FALSE;
+
+static volatile uint32_t i2c_timeout_counter = 0;
+
+static volatile uint8_t i2c_bus_state = I2C_BUS_OK;
+static uint32_t i2c_backoff_counter = 0;
+
+static struct i2c_recovery_stats_struct i2c_recovery_stats;
+
+static struct i2c_speed_struct i2c_speeds[I2C_NUM_OF_SPEEDS];
+static struct i2c_speed_struct *current_speed;
+static uint8_t i2c_bus_speed = I2C_STANDARD_MODE;
+
+/* Per device statistics, entries are taken on first use */
+static struct i2c_device_stats_struct i2c_stats[I2C_NUM_OF_STATS];
+static struct i2c_device_stats_struct *current_stats;
+
+#ifdef DEBUG
+/* CPU occupancy, read out with debugger */
+volatile uint32_t i2c_irq_cycles = 0;			/* SysTick cycles spent in I2C interrupt */
+volatile uint32_t i2c_irq_count = 0;
+volatile uint32_t i2c_dma_transfers = 0;
+volatile uint32_t i2c_irq_transfers = 0;
+#endif
+
+inline static void Start_next_request(uint8_t speed_change_allowed);
+inline static void I2C_Handle_event(void);
+inline static uint8_t Start_DMA(struct i2c_request_struct *request);
+inline static void Stop_DMA(void);
+inline static void Finish_request(uint8_t status);
+inline static struct i2c_device_stats_struct *Get_device_stats(uint8_t device_addr);
+inline static struct i2c_speed_struct *Get_device_speed(uint8_t device_addr);
+inline static void Set_bus_speed(uint8_t speed);
+inline static void Update_device_speed(uint8_t status);
+inline static void Manage_bus_recovery(void);
+inline static uint8_t Recover_bus(void);
+inline static void Fail_queued_requests(void);
+inline static void Bus_Delay(uint32_t cycles);
 static void Clear_I2C(void);
 static void Reset_I2C(void);
-static void Wait_for_NACK_or_TXIS(void);
-static void Wait_for_STOP(void);
-static void Wait_for_NACK_or_TC(void);
-static void Wait_for_NACK_or_RXNE(void);
-static void Wait_for_RXNE(void);
-static void Wait_for_TXE(void);
 
-uint8_t I2C_Check_Addr(uint8_t device_addr)
+void Init_I2C(void)
 {
-	uint8_t device_present = FALSE;
-
 	/* Clear flags */
 	Clear_I2C();
 
-	/* Try given address */
-	LL_I2C_HandleTransfer(I2C1,
-			device_addr,
-			LL_I2C_ADDRSLAVE_7BIT,
-			0,
-			LL_I2C_MODE_AUTOEND,
-			LL_I2C_GENERATE_START_WRITE);
+	/* Transfer is driven by events, errors and NACK end it */
+	LL_I2C_EnableIT_TX(I2C1);
+	LL_I2C_EnableIT_RX(I2C1);
+	LL_I2C_EnableIT_TC(I2C1);
+	LL_I2C_EnableIT_STOP(I2C1);
+	LL_I2C_EnableIT_NACK(I2C1);
+	LL_I2C_EnableIT_ERR(I2C1);
 
-	/* Wait for end of transfer */
-	Wait_for_STOP();
+	NVIC_SetPriority(I2C1_IRQn, 2);
+	NVIC_EnableIRQ(I2C1_IRQn);
+}
 
-	/* Is STOP flag set ? */
-	if(LL_I2C_IsActiveFlag_STOP(I2C1))
+uint8_t I2C_Submit(struct i2c_request_struct *request)
+{
+	uint8_t submit_OK = FALSE;
+
+	/* Check if data length > 0 and device address not equal to 0 */
+	if((request->device_addr == 0) || ((request->type != I2C_REQ_CHECK_ADDR) && (request->data_len == 0)))
+	{
+		/* Wrong input arguments */
+		request->status = I2C_REQ_FAILED;
+
+		return FALSE;
+	}
+
+	/* Fail fast, while bus is stuck */
+	if(i2c_bus_state == I2C_BUS_DEGRADED)
 	{
-		/* It is, transfer ended OK */
+		i2c_recovery_stats.rejected_requests++;
+
+		request->status = I2C_REQ_FAILED;
+
+		return FALSE;
+	}
 
-		/* Is NACK flag set ? */
-		if(LL_I2C_IsActiveFlag_NACK(I2C1))
+	__disable_irq();
+
+	if(i2c_queue_count < I2C_QUEUE_LEN)
+	{
+		request->status = I2C_REQ_QUEUED;
+		request->submit_time = Get_scheduler_time();
+
+		if(request->priority == I2C_PRIORITY_HIGH)
 		{
-			/* Yes, no device of given address is not present on the bus */
-			device_present = FALSE;
+			/* Add to the front of the queue, waits only for transfer in progress */
+			i2c_queue_head = (i2c_queue_head + I2C_QUEUE_LEN - 1) % I2C_QUEUE_LEN;
+			i2c_queue[i2c_queue_head] = request;
 		}
 		else
 		{
-			/* No, the device acknowledged */
-			device_present = TRUE;
+			/* Add to the end of the queue */
+			i2c_queue[(i2c_queue_head + i2c_queue_count) % I2C_QUEUE_LEN] = request;
+		}
+
+		i2c_queue_count++;
+
+		/* Start right away, if bus is free */
+		if((current_request == NULL) && (i2c_bus_state == I2C_BUS_OK))
+		{
+			Start_next_request(TRUE);
 		}
+
+		submit_OK = TRUE;
 	}
-	else
+
+	__enable_irq();
+
+	return submit_OK;
+}
+
+uint8_t I2C_Transfer(struct i2c_request_struct *request)
+{
+	/* Wait for space in the queue */
+	while(I2C_Submit(request) == FALSE)
 	{
-		/* Arbitration lost or SDA/SCL line stuck */
-		device_present = FALSE;
+		if(request->status == I2C_REQ_FAILED)
+		{
+			return FALSE;
+		}
+
+		Manage_I2C();
 	}
 
-	/* Clear flags */
-	Clear_I2C();
+	/* Wait for transfer to end */
+	while((request->status == I2C_REQ_QUEUED) || (request->status == I2C_REQ_BUSY))
+	{
+		Manage_I2C();
+	}
 
-	return device_present;
+	return (request->status == I2C_REQ_DONE) ? TRUE : FALSE;
 }
 
-uint8_t I2C_Write_Command(uint8_t device_addr, uint8_t command)
+uint8_t Is_I2C_idle(void)
 {
-	volatile uint8_t transaction_OK = FALSE;
+	return ((current_request == NULL) && (i2c_queue_count == 0)) ? TRUE : FALSE;
+}
 
-	/* Check if device address not equal to 0 */
-	if(device_addr != 0)
+void Manage_I2C(void)
+{
+	/* Count milliseconds of current transfer */
+	if(CHECK_TICK)
 	{
-		/* Clear flags, Flush TXDR */
-		Clear_I2C();
+		i2c_timeout_counter++;
+
+		if(i2c_bus_state == I2C_BUS_DEGRADED)
+		{
+			i2c_backoff_counter++;
+			i2c_recovery_stats.degraded_time++;
+		}
+	}
 
-		/* Wait for TXDR to be empty */
-		Wait_for_TXE();
+	/* Timeout can occur when SDA or SCL is stuck @ low */
+	if((current_request != NULL) && (i2c_timeout_counter >= I2C_TIMEOUT))
+	{
+		__disable_irq();
 
-		/* Verify that TXDR is empty */
-		if(LL_I2C_IsActiveFlag_TXE(I2C1))
+		/* Check again, transfer may have just ended */
+		if((current_request != NULL) && (i2c_timeout_counter >= I2C_TIMEOUT))
 		{
-			/* Write command */
-			/* Write the first data in I2C_TXDR before the transmission starts, */
-			/* due to HW bug "Transmission stalled after first byte transfer" */
-			LL_I2C_TransmitData8(I2C1, command);
+			current_stats->timeouts++;
+			current_stats->resets++;
 
-			/* Start transaction for 1 byte */
-			/* A STOP would be automatically generated after the last received byte */
-			LL_I2C_HandleTransfer(I2C1,
-					device_addr,
-					LL_I2C_ADDRSLAVE_7BIT,
-					1,
-					LL_I2C_MODE_AUTOEND,
-					LL_I2C_GENERATE_START_WRITE);
+			/* All flags will be cleared afterwards */
+			Reset_I2C();
 
-			/* Wait for transaction to end */
-			Wait_for_STOP();
+			/* Release the bus, before next transfer */
+			i2c_bus_state = I2C_BUS_RECOVERY;
 
-			/* Check STOP flag and NACK flag */
-			if(LL_I2C_IsActiveFlag_STOP(I2C1) && (!LL_I2C_IsActiveFlag_NACK(I2C1)))
-			{
-				/* If it is set, transaction was OK */
-				transaction_OK = TRUE;
-			}
+			Finish_request(I2C_REQ_FAILED);
 		}
-		else
+
+		__enable_irq();
+	}
+
+	/* Start transfer left waiting for a speed change */
+	if((current_request == NULL) && (i2c_queue_count > 0) && (i2c_bus_state == I2C_BUS_OK))
+	{
+		__disable_irq();
+
+		/* Check again, Submit may have just started it */
+		if((current_request == NULL) && (i2c_queue_count > 0) && (i2c_bus_state == I2C_BUS_OK))
 		{
-			/* TXDR unavailable */
-			transaction_OK = FALSE;
+			Start_next_request(TRUE);
 		}
 
-		/* End */
-		Clear_I2C();
+		__enable_irq();
 	}
-	else
+
+	Manage_bus_recovery();
+}
+
+void I2C_Set_device_speed(uint8_t device_addr, uint8_t max_speed)
+{
+	if(max_speed >= NUM_OF_I2C_SPEEDS)
 	{
-		/* Wrong input arguments */
-		transaction_OK = FALSE;
+		max_speed = I2C_STANDARD_MODE;
 	}
 
-	return transaction_OK;
+	__disable_irq();
+
+	struct i2c_speed_struct *entry = Get_device_speed(device_addr);
+
+	if(entry == NULL)
+	{
+		/* Take free entry */
+		for(uint8_t i = 0; i < I2C_NUM_OF_SPEEDS; i++)
+		{
+			if(i2c_speeds[i].device_addr == 0)
+			{
+				entry = &i2c_speeds[i];
+				entry->device_addr = device_addr;
+
+				break;
+			}
+		}
+	}
+
+	if(entry != NULL)
+	{
+		/* Start at the highest speed */
+		entry->max_speed = max_speed;
+		entry->speed = max_speed;
+		entry->errors = 0;
+		entry->good_transfers = 0;
+	}
+
+	__enable_irq();
 }
 
-uint8_t I2C_Read_Command(uint8_t device_addr, uint8_t *command)
+uint8_t Get_I2C_device_speed(uint8_t device_addr)
+{
+	struct i2c_speed_struct *entry = Get_device_speed(device_addr);
+
+	return (entry != NULL) ? entry->speed : I2C_STANDARD_MODE;
+}
+
+void Get_I2C_recovery_stats(struct i2c_recovery_stats_struct *stats)
+{
+	*stats = i2c_recovery_stats;
+}
+
+void I2C_IRQ_handler(void)
+{
+#ifdef DEBUG
+	uint32_t irq_start = GET_CYCLES;
+#endif
+
+	I2C_Handle_event();
+
+#ifdef DEBUG
+	i2c_irq_cycles += CYCLES_SINCE(irq_start);
+	i2c_irq_count++;
+#endif
+}
+
+inline static void I2C_Handle_event(void)
 {
-	volatile uint8_t transaction_OK = FALSE;
+	struct i2c_request_struct *request = current_request;
 
-	/* Check if device address not equal to 0 */
-	if(device_addr != 0)
+	if(request == NULL)
 	{
-		/* Clear flags, Flush TXDR */
+		/* Nothing expected */
 		Clear_I2C();
 
-		/* Wait for TXDR to be empty */
-		Wait_for_TXE();
+		return;
+	}
+
+	/* Arbitration lost, bus error or overrun, STOP may never come */
+	if(LL_I2C_IsActiveFlag_ARLO(I2C1) || LL_I2C_IsActiveFlag_BERR(I2C1) || LL_I2C_IsActiveFlag_OVR(I2C1))
+	{
+		current_stats->bus_errors++;
+		current_stats->resets++;
+
+		/* All flags will be cleared afterwards */
+		Reset_I2C();
+
+		/* Recovery takes too long for interrupt, done in main loop */
+		i2c_bus_state = I2C_BUS_RECOVERY;
 
-		/* Verify that TXDR is empty */
-		if(LL_I2C_IsActiveFlag_TXE(I2C1))
+		Finish_request(I2C_REQ_FAILED);
+
+		return;
+	}
+
+	/* Not acknowledged, STOP is generated automatically */
+	if(LL_I2C_IsActiveFlag_NACK(I2C1))
+	{
+		LL_I2C_ClearFlag_NACK(I2C1);
+
+		current_nack = TRUE;
+
+		current_stats->nacks++;
+	}
+
+	/* TXDR empty, write next data byte, flag is also set when DMA serves it */
+	if((current_dma == FALSE) && LL_I2C_IsActiveFlag_TXIS(I2C1))
+	{
+		LL_I2C_TransmitData8(I2C1, (current_index < request->data_len) ? request->data[current_index] : 0xFF);
+
+		current_index++;
+	}
+
+	/* Data byte received */
+	if((current_dma == FALSE) && LL_I2C_IsActiveFlag_RXNE(I2C1))
+	{
+		uint8_t data = LL_I2C_ReceiveData8(I2C1);
+
+		if(current_index < request->data_len)
 		{
-			/* Start transaction for 1 byte, write address for read */
-			/* A NACK and a STOP would be automatically generated after the last received byte */
-			LL_I2C_HandleTransfer(I2C1,
-					device_addr | I2C_READ_ADDR_BIT,
-					LL_I2C_ADDRSLAVE_7BIT,
-					1,
-					LL_I2C_MODE_AUTOEND,
-					LL_I2C_GENERATE_START_READ);
+			request->data[current_index] = data;
+		}
 
-			/* Wait for either NACK or RXNE flag */
-			Wait_for_NACK_or_RXNE();
+		current_index++;
+	}
 
-			/* Check if device acknowledged */
-			if(LL_I2C_IsActiveFlag_RXNE(I2C1))
-			{
-				/* Yes */
+	/* Register address sent */
+	if(LL_I2C_IsActiveFlag_TC(I2C1))
+	{
+		/* Invoke repeated start on the bus, write address for read */
+		/* A NACK and a STOP would be automatically generated after the last received byte */
+		LL_I2C_HandleTransfer(I2C1,
+				request->device_addr | I2C_READ_ADDR_BIT,
+				LL_I2C_ADDRSLAVE_7BIT,
+				request->data_len,
+				LL_I2C_MODE_AUTOEND,
+				LL_I2C_GENERATE_START_READ);
+	}
 
-				/* Get command */
-				*command = LL_I2C_ReceiveData8(I2C1);
+	/* Transaction ended */
+	if(LL_I2C_IsActiveFlag_STOP(I2C1))
+	{
+		LL_I2C_ClearFlag_STOP(I2C1);
 
-				/* Wait for transaction to end */
-				Wait_for_STOP();
+		if(current_dma == TRUE)
+		{
+			/* Data moved by DMA, register address byte was preloaded */
+			uint32_t channel = (request->type == I2C_REQ_WRITE_DATA) ? I2C_TX_DMA_CHANNEL : I2C_RX_DMA_CHANNEL;
 
-				/* Check STOP flag */
-				if(LL_I2C_IsActiveFlag_STOP(I2C1))
-				{
-					/* If it is set, transaction was OK */
-					transaction_OK = TRUE;
-				}
-			}
-			else
-			{
-				/* Not acknowledged */
-				transaction_OK = FALSE;
-			}
+			current_index = request->data_len - LL_DMA_GetDataLength(DMA1, channel);
+		}
+
+		/* OK, if acknowledged and all data transferred */
+		if((current_nack == FALSE) && (current_index == request->data_len))
+		{
+			Finish_request(I2C_REQ_DONE);
 		}
 		else
 		{
-			/* TXDR unavailable */
-			transaction_OK = FALSE;
+			Finish_request(I2C_REQ_FAILED);
+		}
+	}
+}
+
+void I2C_Dump_stats(void (*dump)(const struct i2c_device_stats_struct *stats))
+{
+	struct i2c_device_stats_struct stats;
+
+	for(uint8_t i = 0; i < I2C_NUM_OF_STATS; i++)
+	{
+		if(i2c_stats[i].device_addr == 0)
+		{
+			continue;
 		}
 
-		/* End */
-		Clear_I2C();
+		/* Consistent copy */
+		__disable_irq();
+		stats = i2c_stats[i];
+		__enable_irq();
+
+		dump(&stats);
 	}
-	else
+}
+
+void I2C_Clear_stats(void)
+{
+	__disable_irq();
+
+	/* Entries are taken again on next transfer */
+	for(uint8_t i = 0; i < I2C_NUM_OF_STATS; i++)
 	{
-		/* Wrong input arguments */
-		transaction_OK = FALSE;
+		i2c_stats[i] = (struct i2c_device_stats_struct){0};
 	}
 
-	return transaction_OK;
+	__enable_irq();
+}
+
+uint8_t I2C_Check_Addr(uint8_t device_addr)
+{
+	struct i2c_request_struct request = {I2C_REQ_CHECK_ADDR, device_addr, 0, NULL, 0, I2C_PRIORITY_NORMAL, I2C_REQ_IDLE, 0, 0, NULL};
+
+	/* Device present, if address acknowledged */
+	return I2C_Transfer(&request);
+}
+
+uint8_t I2C_Write_Command(uint8_t device_addr, uint8_t command)
+{
+	struct i2c_request_struct request = {I2C_REQ_WRITE_COMMAND, device_addr, 0, &command, 1, I2C_PRIORITY_NORMAL, I2C_REQ_IDLE, 0, 0, NULL};
+
+	return I2C_Transfer(&request);
+}
+
+uint8_t I2C_Read_Command(uint8_t device_addr, uint8_t *command)
+{
+	struct i2c_request_struct request = {I2C_REQ_READ_COMMAND, device_addr, 0, command, 1, I2C_PRIORITY_NORMAL, I2C_REQ_IDLE, 0, 0, NULL};
+
+	return I2C_Transfer(&request);
 }
 
 uint8_t I2C_Read_Register(uint8_t device_addr, uint8_t reg_addr, uint8_t *reg_data)
@@ -212,377 +510,554 @@ uint8_t I2C_Write_Register(uint8_t device_addr, uint8_t reg_addr, uint8_t reg_da
 
 uint8_t I2C_Read_Data(uint8_t device_addr, uint8_t reg_addr, uint8_t *data, uint8_t data_len)
 {
-	volatile uint8_t transaction_OK = FALSE;
+	struct i2c_request_struct request = {I2C_REQ_READ_DATA, device_addr, reg_addr, data, data_len, I2C_PRIORITY_NORMAL, I2C_REQ_IDLE, 0, 0, NULL};
 
-	/* Check if data length > 0 and device address not equal to 0 */
-	if((data_len > 0) && (device_addr != 0))
+	return I2C_Transfer(&request);
+}
+
+uint8_t I2C_Write_Data(uint8_t device_addr, uint8_t reg_addr, uint8_t *data, uint8_t data_len)
+{
+	struct i2c_request_struct request = {I2C_REQ_WRITE_DATA, device_addr, reg_addr, data, data_len, I2C_PRIORITY_NORMAL, I2C_REQ_IDLE, 0, 0, NULL};
+
+	return I2C_Transfer(&request);
+}
+
+inline static void Start_next_request(uint8_t speed_change_allowed)
+{
+	/* Called with interrupts disabled or from I2C interrupt */
+	if((i2c_queue_count == 0) || (i2c_bus_state != I2C_BUS_OK))
 	{
-		/* Clear flags, Flush TXDR */
-		Clear_I2C();
+		current_request = NULL;
 
-		/* Wait for TXDR to be empty */
-		Wait_for_TXE();
+		return;
+	}
 
-		/* Verify that TXDR is empty */
-		if(LL_I2C_IsActiveFlag_TXE(I2C1))
-		{
-			/* Write register address */
+	/* Fastest speed device is known to work with */
+	struct i2c_speed_struct *speed = Get_device_speed(i2c_queue[i2c_queue_head]->device_addr);
+	uint8_t bus_speed = (speed != NULL) ? speed->speed : I2C_STANDARD_MODE;
+
+	/* Changing speed toggles PE and FM+ drive, not done from interrupt, Manage_I2C starts it */
+	if((bus_speed != i2c_bus_speed) && (speed_change_allowed == FALSE))
+	{
+		current_request = NULL;
+
+		return;
+	}
+
+	/* Take first request from the queue */
+	struct i2c_request_struct *request = i2c_queue[i2c_queue_head];
+
+	i2c_queue_head = (i2c_queue_head + 1) % I2C_QUEUE_LEN;
+	i2c_queue_count--;
+
+	current_request = request;
+	current_index = 0;
+	current_nack = FALSE;
+
+	i2c_timeout_counter = 0;
+
+	request->status = I2C_REQ_BUSY;
+
+	/* DS3231 latches time at the start of the transfer */
+	request->start_time = Get_scheduler_time();
+
+	current_stats = Get_device_stats(request->device_addr);
+
+	if((request->start_time - request->submit_time) > current_stats->wait_max)
+	{
+		current_stats->wait_max = request->start_time - request->submit_time;
+	}
+
+	current_speed = speed;
+	Set_bus_speed(bus_speed);
+
+	/* Clear flags, Flush TXDR */
+	Clear_I2C();
+
+	/* Data by DMA, if display does not use the channels */
+	current_dma = Start_DMA(request);
+
+#ifdef DEBUG
+	if(current_dma == TRUE)
+	{
+		i2c_dma_transfers++;
+	}
+	else
+	{
+		i2c_irq_transfers++;
+	}
+#endif
+
+	switch(request->type)
+	{
+		case I2C_REQ_CHECK_ADDR:
+			/* Try given address */
+			LL_I2C_HandleTransfer(I2C1,
+					request->device_addr,
+					LL_I2C_ADDRSLAVE_7BIT,
+					0,
+					LL_I2C_MODE_AUTOEND,
+					LL_I2C_GENERATE_START_WRITE);
+			break;
+
+		case I2C_REQ_WRITE_COMMAND:
 			/* Write the first data in I2C_TXDR before the transmission starts, */
 			/* due to HW bug "Transmission stalled after first byte transfer" */
-			LL_I2C_TransmitData8(I2C1, reg_addr);
+			LL_I2C_TransmitData8(I2C1, request->data[0]);
+			current_index = 1;
+
+			/* A STOP would be automatically generated after the last byte */
+			LL_I2C_HandleTransfer(I2C1,
+					request->device_addr,
+					LL_I2C_ADDRSLAVE_7BIT,
+					request->data_len,
+					LL_I2C_MODE_AUTOEND,
+					LL_I2C_GENERATE_START_WRITE);
+			break;
 
-			/* Start transaction for 1 byte - register address write */
+		case I2C_REQ_READ_COMMAND:
+			/* A NACK and a STOP would be automatically generated after the last received byte */
 			LL_I2C_HandleTransfer(I2C1,
-					device_addr,
+					request->device_addr | I2C_READ_ADDR_BIT,
+					LL_I2C_ADDRSLAVE_7BIT,
+					request->data_len,
+					LL_I2C_MODE_AUTOEND,
+					LL_I2C_GENERATE_START_READ);
+			break;
+
+		case I2C_REQ_READ_DATA:
+			/* Write register address first, same HW bug workaround */
+			LL_I2C_TransmitData8(I2C1, request->reg_addr);
+
+			/* Repeated start follows on TC */
+			LL_I2C_HandleTransfer(I2C1,
+					request->device_addr,
 					LL_I2C_ADDRSLAVE_7BIT,
 					1,
 					LL_I2C_MODE_SOFTEND,
 					LL_I2C_GENERATE_START_WRITE);
+			break;
 
-			/* Wait for register address to be sent */
-			Wait_for_NACK_or_TC();
+		case I2C_REQ_WRITE_DATA:
+		default:
+			/* Register address plus data bytes, same HW bug workaround */
+			LL_I2C_TransmitData8(I2C1, request->reg_addr);
 
-			/* Check if device acknowledged */
-			/* TC would be set if NACK was not received */
-			if(LL_I2C_IsActiveFlag_TC(I2C1))
-			{
-				/* Yes */
-
-				/* Invoke repeated start on the bus, write address for read */
-				/* A NACK and a STOP would be automatically generated after the last received byte */
-				LL_I2C_HandleTransfer(I2C1,
-						device_addr | I2C_READ_ADDR_BIT,
-						LL_I2C_ADDRSLAVE_7BIT,
-						data_len,
-						LL_I2C_MODE_AUTOEND,
-						LL_I2C_GENERATE_START_READ);
-
-				/* Wait for either NACK or RXNE flag */
-				Wait_for_NACK_or_RXNE();
-
-				/* Check if device acknowledged */
-				if(LL_I2C_IsActiveFlag_RXNE(I2C1))
-				{
-					/* Yes */
-
-					/* Process each byte */
-					for(uint32_t i = 0; i < data_len; i++)
-					{
-						/* Wait for data */
-						Wait_for_RXNE();
-
-						/* Check if device acknowledged */
-						if(LL_I2C_IsActiveFlag_RXNE(I2C1))
-						{
-							/* Get data */
-							data[i] = LL_I2C_ReceiveData8(I2C1);
-						}
-						else
-						{
-							/* Not acknowledged */
-							transaction_OK = FALSE;
-
-							break;
-						}
-					}
-
-					/* Wait for transaction to end */
-					Wait_for_STOP();
-
-					/* Check STOP flag */
-					if(LL_I2C_IsActiveFlag_STOP(I2C1))
-					{
-						/* If it is set, transaction was OK */
-						transaction_OK = TRUE;
-					}
-				}
-				else
-				{
-					/* Not acknowledged */
-					transaction_OK = FALSE;
-				}
-			}
-			else
-			{
-				/* Not acknowledged */
-				transaction_OK = FALSE;
-			}
-		}
-		else
-		{
-			/* TXDR unavailable */
-			transaction_OK = FALSE;
-		}
-
-		/* End */
-		Clear_I2C();
+			/* A STOP would be automatically generated after the last byte */
+			LL_I2C_HandleTransfer(I2C1,
+					request->device_addr,
+					LL_I2C_ADDRSLAVE_7BIT,
+					request->data_len + 1,
+					LL_I2C_MODE_AUTOEND,
+					LL_I2C_GENERATE_START_WRITE);
+			break;
 	}
-	else
+}
+
+inline static void Finish_request(uint8_t status)
+{
+	/* Called with interrupts disabled or from I2C interrupt */
+	struct i2c_request_struct *request = current_request;
+
+	/* End */
+	Clear_I2C();
+
+	if(current_dma == TRUE)
 	{
-		/* Wrong input arguments */
-		transaction_OK = FALSE;
+		Stop_DMA();
 	}
 
-	return transaction_OK;
-}
+	/* Update statistics, duration in TIM14 counts */
+	uint32_t duration = Get_scheduler_time() - request->start_time;
 
-uint8_t I2C_Write_Data(uint8_t device_addr, uint8_t reg_addr, uint8_t *data, uint8_t data_len)
-{
-	volatile uint8_t transaction_OK = FALSE;
+	current_stats->transactions++;
+	current_stats->bytes += (current_index < request->data_len) ? current_index : request->data_len;
+	current_stats->duration_total += duration;
 
-	/* Check if data length > 0 and device address not equal to 0 */
-	if((data_len > 0) && (device_addr != 0))
+	if(duration < current_stats->duration_min)
 	{
-		/* Clear flags, Flush TXDR */
-		Clear_I2C();
+		current_stats->duration_min = duration;
+	}
 
-		/* Wait for TXDR to be empty */
-		Wait_for_TXE();
+	if(duration > current_stats->duration_max)
+	{
+		current_stats->duration_max = duration;
+	}
 
-		/* Verify that TXDR is empty */
-		if(LL_I2C_IsActiveFlag_TXE(I2C1))
-		{
-			/* Write register address */
-			/* Write the first data in I2C_TXDR before the transmission starts, */
-			/* due to HW bug "Transmission stalled after first byte transfer" */
-			LL_I2C_TransmitData8(I2C1, reg_addr);
+	/* Absent device is not a speed problem */
+	if(request->type != I2C_REQ_CHECK_ADDR)
+	{
+		Update_device_speed(status);
+	}
 
-			/* Start transaction for N+1 byte - register address plus data bytes */
-			/* A STOP would be automatically generated after the last received byte */
-			LL_I2C_HandleTransfer(I2C1,
-					device_addr,
-					LL_I2C_ADDRSLAVE_7BIT,
-					data_len + 1,
-					LL_I2C_MODE_AUTOEND,
-					LL_I2C_GENERATE_START_WRITE);
+	request->status = status;
 
-			/* Wait for either NACK or TXIS flag */
-			Wait_for_NACK_or_TXIS();
+	/* Notify, callback must be short */
+	if(request->callback != NULL)
+	{
+		request->callback(request);
+	}
 
-			/* Check if device acknowledged */
-			/* TXIS flag is not set when a NACK was received */
-			if(LL_I2C_IsActiveFlag_TXIS(I2C1))
-			{
-				/* Yes, continue */
-
-				/* Process each byte */
-				for(uint32_t i = 0; i < data_len; i++)
-				{
-					/* Wait for TXDR to be empty */
-					Wait_for_NACK_or_TXIS();
-
-					/* Check if device acknowledged */
-					/* TXIS flag is not set when a NACK was received */
-					if(LL_I2C_IsActiveFlag_TXIS(I2C1))
-					{
-						/* Write data byte */
-						LL_I2C_TransmitData8(I2C1, data[i]);
-					}
-					else
-					{
-						/* NACK received */
-						transaction_OK = FALSE;
-
-						break;
-					}
-				}
-
-				/* Wait for transaction to end */
-				Wait_for_STOP();
-
-				/* Check STOP flag and NACK flag */
-				if(LL_I2C_IsActiveFlag_STOP(I2C1) && (!LL_I2C_IsActiveFlag_NACK(I2C1)))
-				{
-					/* If it is set, transaction was OK */
-					transaction_OK = TRUE;
-				}
-			}
-			else
-			{
-				/* Not acknowledged */
-				transaction_OK = FALSE;
-			}
-		}
-		else
+	/* Continue with the queue, at the same speed */
+	Start_next_request(FALSE);
+}
+
+inline static struct i2c_device_stats_struct *Get_device_stats(uint8_t device_addr)
+{
+	uint8_t i;
+
+	/* Find entry of the device, or take a free one */
+	for(i = 0; i < (I2C_NUM_OF_STATS - 1); i++)
+	{
+		if(i2c_stats[i].device_addr == device_addr)
 		{
-			/* TXDR unavailable */
-			transaction_OK = FALSE;
+			break;
 		}
 
-		/* End */
-		Clear_I2C();
+		if(i2c_stats[i].device_addr == 0)
+		{
+			i2c_stats[i].device_addr = device_addr;
+			i2c_stats[i].duration_min = 0xFFFFFFFF;
+
+			break;
+		}
 	}
-	else
+
+	if((i == (I2C_NUM_OF_STATS - 1)) && (i2c_stats[i].device_addr == 0))
 	{
-		/* Wrong input arguments */
-		transaction_OK = FALSE;
+		/* Shared by all other devices */
+		i2c_stats[i].device_addr = I2C_STATS_OTHER_DEVICES;
+		i2c_stats[i].duration_min = 0xFFFFFFFF;
 	}
 
-	return transaction_OK;
+	return &i2c_stats[i];
 }
 
-static void Clear_I2C(void)
+inline static struct i2c_speed_struct *Get_device_speed(uint8_t device_addr)
 {
-	/* Clear flags */
-	LL_I2C_ClearFlag_STOP(I2C1);
-	LL_I2C_ClearFlag_NACK(I2C1);
-	LL_I2C_ClearFlag_BERR(I2C1);
-	LL_I2C_ClearFlag_ARLO(I2C1);
-	LL_I2C_ClearFlag_OVR(I2C1);
+	for(uint8_t i = 0; i < I2C_NUM_OF_SPEEDS; i++)
+	{
+		if(i2c_speeds[i].device_addr == device_addr)
+		{
+			return &i2c_speeds[i];
+		}
+	}
 
-	/* Flush TXDR */
-	LL_I2C_ClearFlag_TXE(I2C1);
+	return NULL;
 }
 
-static void Reset_I2C(void)
+inline static void Set_bus_speed(uint8_t speed)
 {
-	/* 1. Write PE = 0 */
+	/* Not from interrupt, only main loop with interrupts disabled */
+	if(speed == i2c_bus_speed)
+	{
+		return;
+	}
+
+	/* TIMINGR can be written only when I2C1 is disabled */
 	LL_I2C_Disable(I2C1);
 
-	/* 2. Check PE = 0 */
 	while(LL_I2C_IsEnabled(I2C1))
 	{
 		LL_I2C_Disable(I2C1);
 	}
 
-	/* 3. Write PE = 1 */
+	LL_I2C_SetTiming(I2C1, i2c_timings[speed]);
+
+	/* Stronger pin drive for 1MHz */
+	if(speed == I2C_FAST_MODE_PLUS)
+	{
+		LL_SYSCFG_EnableFastModePlus(LL_SYSCFG_I2C_FASTMODEPLUS_PA9 | LL_SYSCFG_I2C_FASTMODEPLUS_PA10);
+	}
+	else
+	{
+		LL_SYSCFG_DisableFastModePlus(LL_SYSCFG_I2C_FASTMODEPLUS_PA9 | LL_SYSCFG_I2C_FASTMODEPLUS_PA10);
+	}
+
 	LL_I2C_Enable(I2C1);
+
+	i2c_bus_speed = speed;
 }
 
-static void Wait_for_NACK_or_TXIS(void)
+inline static void Update_device_speed(uint8_t status)
 {
-	volatile uint32_t timeout = 0;
-	CLEAR_TICK;
+	struct i2c_speed_struct *entry = current_speed;
+
+	if(entry == NULL)
+	{
+		return;
+	}
 
-	/* Wait for either NACK or TXIS flag */
-	while(	!LL_I2C_IsActiveFlag_ARLO(I2C1) &&
-			!LL_I2C_IsActiveFlag_TXIS(I2C1) &&
-			!LL_I2C_IsActiveFlag_NACK(I2C1))
+	if(status == I2C_REQ_DONE)
 	{
-		if(CHECK_TICK)
-			timeout++;
+		entry->errors = 0;
 
-		/* Timeout can occur when SDA or SCL is stuck @ low */
-		if(timeout >= I2C_TIMEOUT)
+		/* Try faster again, after a long run without errors */
+		if((entry->speed < entry->max_speed) && (++entry->good_transfers >= I2C_SPEED_RESTORE_TRANSFERS))
 		{
-			/* All flags will be cleared afterwards */
-			Reset_I2C();
+			entry->speed++;
+			entry->good_transfers = 0;
+		}
+	}
+	else
+	{
+		entry->good_transfers = 0;
 
-			break;
+		/* NACK, arbitration lost or timeout, repeatedly */
+		if((++entry->errors >= I2C_SPEED_FALLBACK_ERRORS) && (entry->speed > I2C_STANDARD_MODE))
+		{
+			entry->speed--;
+			entry->errors = 0;
+
+			current_stats->speed_fallbacks++;
 		}
 	}
 }
 
-static void Wait_for_STOP(void)
+inline static void Manage_bus_recovery(void)
 {
-	uint32_t timeout = 0;
-	CLEAR_TICK;
+	/* Only between transfers */
+	if((i2c_bus_state == I2C_BUS_OK) || (current_request != NULL))
+	{
+		return;
+	}
 
-	/* Wait for either NACK, STOP or TXIS flag */
-	while(!LL_I2C_IsActiveFlag_STOP(I2C1))
+	/* Wait, if previous recovery failed */
+	if((i2c_bus_state == I2C_BUS_DEGRADED) && (i2c_backoff_counter < i2c_recovery_stats.backoff))
 	{
-		if(CHECK_TICK)
-			timeout++;
+		return;
+	}
 
-		/* Timeout can occur when SDA or SCL is stuck @ low */
-		if(timeout >= I2C_TIMEOUT)
-		{
-			/* All flags will be cleared afterwards */
-			Reset_I2C();
+	if(Recover_bus() == TRUE)
+	{
+		/* Bus free, back to normal */
+		i2c_recovery_stats.recoveries++;
+		i2c_recovery_stats.backoff = 0;
 
-			break;
+		__disable_irq();
+
+		i2c_bus_state = I2C_BUS_OK;
+
+		/* Continue with the queue */
+		Start_next_request(TRUE);
+
+		__enable_irq();
+	}
+	else
+	{
+		/* Still stuck, try again later, doubling the wait */
+		i2c_recovery_stats.recovery_failures++;
+
+		if(i2c_recovery_stats.backoff == 0)
+		{
+			i2c_recovery_stats.backoff = I2C_BACKOFF_MIN;
 		}
+		else if(i2c_recovery_stats.backoff < I2C_BACKOFF_MAX)
+		{
+			i2c_recovery_stats.backoff <<= 1;
+		}
+
+		i2c_backoff_counter = 0;
+
+		__disable_irq();
+
+		i2c_bus_state = I2C_BUS_DEGRADED;
+
+		/* Nobody waits for the bus meanwhile */
+		Fail_queued_requests();
+
+		__enable_irq();
 	}
 }
 
-static void Wait_for_NACK_or_TC(void)
+inline static uint8_t Recover_bus(void)
 {
-	uint32_t timeout = 0;
-	CLEAR_TICK;
+	uint32_t half_period = NS_TO_CYCLES(I2C_RECOVERY_HALF_PERIOD_NS);
 
-	/* Wait for either NACK or TC flag */
-	while(	!LL_I2C_IsActiveFlag_ARLO(I2C1) &&
-			!LL_I2C_IsActiveFlag_TC(I2C1) &&
-			!LL_I2C_IsActiveFlag_NACK(I2C1))
-	{
-		if(CHECK_TICK)
-			timeout++;
+	/* Take pins from I2C1, both released high, open-drain */
+	LL_I2C_Disable(I2C1);
 
-		/* Timeout can occur when SDA or SCL is stuck @ low */
-		if(timeout >= I2C_TIMEOUT)
-		{
-			/* All flags will be cleared afterwards */
-			Reset_I2C();
+	LL_GPIO_SetOutputPin(I2C_GPIO_PORT, I2C_SCL_PIN | I2C_SDA_PIN);
+	LL_GPIO_SetPinMode(I2C_GPIO_PORT, I2C_SCL_PIN, LL_GPIO_MODE_OUTPUT);
+	LL_GPIO_SetPinMode(I2C_GPIO_PORT, I2C_SDA_PIN, LL_GPIO_MODE_OUTPUT);
 
-			break;
-		}
+	Bus_Delay(half_period);
+
+	/* Clock out the byte slave is stuck in, until it releases SDA */
+	for(uint8_t i = 0; (i < I2C_RECOVERY_PULSES) && !LL_GPIO_IsInputPinSet(I2C_GPIO_PORT, I2C_SDA_PIN); i++)
+	{
+		LL_GPIO_ResetOutputPin(I2C_GPIO_PORT, I2C_SCL_PIN);
+		Bus_Delay(half_period);
+
+		LL_GPIO_SetOutputPin(I2C_GPIO_PORT, I2C_SCL_PIN);
+		Bus_Delay(half_period);
 	}
+
+	/* Generate STOP, SDA rising while SCL is high */
+	LL_GPIO_ResetOutputPin(I2C_GPIO_PORT, I2C_SCL_PIN);
+	Bus_Delay(half_period);
+	LL_GPIO_ResetOutputPin(I2C_GPIO_PORT, I2C_SDA_PIN);
+	Bus_Delay(half_period);
+	LL_GPIO_SetOutputPin(I2C_GPIO_PORT, I2C_SCL_PIN);
+	Bus_Delay(half_period);
+	LL_GPIO_SetOutputPin(I2C_GPIO_PORT, I2C_SDA_PIN);
+	Bus_Delay(half_period);
+
+	/* Bus is free, if both lines are high */
+	uint8_t bus_free = (LL_GPIO_IsInputPinSet(I2C_GPIO_PORT, I2C_SCL_PIN) && LL_GPIO_IsInputPinSet(I2C_GPIO_PORT, I2C_SDA_PIN)) ? TRUE : FALSE;
+
+	/* Give pins back to I2C1 */
+	LL_GPIO_SetPinMode(I2C_GPIO_PORT, I2C_SCL_PIN, LL_GPIO_MODE_ALTERNATE);
+	LL_GPIO_SetPinMode(I2C_GPIO_PORT, I2C_SDA_PIN, LL_GPIO_MODE_ALTERNATE);
+
+	LL_I2C_Enable(I2C1);
+
+	/* Clear flags */
+	Clear_I2C();
+
+	return bus_free;
 }
 
-static void Wait_for_NACK_or_RXNE(void)
+inline static void Fail_queued_requests(void)
 {
-	uint32_t timeout = 0;
-	CLEAR_TICK;
-
-	/* Wait for either NACK or RXNE flag */
-	while(	!LL_I2C_IsActiveFlag_ARLO(I2C1) &&
-			!LL_I2C_IsActiveFlag_RXNE(I2C1) &&
-			!LL_I2C_IsActiveFlag_NACK(I2C1))
+	/* Called with interrupts disabled */
+	while(i2c_queue_count > 0)
 	{
-		if(CHECK_TICK)
-			timeout++;
+		struct i2c_request_struct *request = i2c_queue[i2c_queue_head];
 
-		/* Timeout can occur when SDA or SCL is stuck @ low */
-		if(timeout >= I2C_TIMEOUT)
-		{
-			/* All flags will be cleared afterwards */
-			Reset_I2C();
+		i2c_queue_head = (i2c_queue_head + 1) % I2C_QUEUE_LEN;
+		i2c_queue_count--;
 
-			break;
+		request->status = I2C_REQ_FAILED;
+
+		if(request->callback != NULL)
+		{
+			request->callback(request);
 		}
 	}
 }
 
-static void Wait_for_RXNE(void)
+inline static void Bus_Delay(uint32_t cycles)
+{
+	uint32_t start = GET_CYCLES;
+
+	/* Count SysTick cycles, independent of optimization level */
+	while(CYCLES_SINCE(start) < cycles);
+}
+
+inline static uint8_t Start_DMA(struct i2c_request_struct *request)
 {
-	uint32_t timeout = 0;
-	CLEAR_TICK;
+	uint32_t channel;
+	uint32_t direction;
 
-	/* Wait for RXNE flag */
-	while(!LL_I2C_IsActiveFlag_RXNE(I2C1))
+	/* Register address or command preloaded to TXDR is not included */
+	if((request->data_len < I2C_DMA_MIN_LEN) ||
+			((request->type != I2C_REQ_READ_DATA) && (request->type != I2C_REQ_WRITE_DATA) && (request->type != I2C_REQ_READ_COMMAND)))
 	{
-		if(CHECK_TICK)
-			timeout++;
+		return FALSE;
+	}
 
-		/* Timeout can occur when SDA or SCL is stuck @ low */
-		if(timeout >= I2C_TIMEOUT)
-		{
-			/* All flags will be cleared afterwards */
-			Reset_I2C();
+	/* Channels are shared with display SPI */
+	if(Claim_display_DMA() == FALSE)
+	{
+		return FALSE;
+	}
 
-			break;
-		}
+	if(request->type == I2C_REQ_WRITE_DATA)
+	{
+		channel = I2C_TX_DMA_CHANNEL;
+		direction = LL_DMA_DIRECTION_MEMORY_TO_PERIPH;
+	}
+	else
+	{
+		channel = I2C_RX_DMA_CHANNEL;
+		direction = LL_DMA_DIRECTION_PERIPH_TO_MEMORY;
+	}
+
+	LL_DMA_ConfigTransfer(DMA1, channel,
+			direction |
+			LL_DMA_PRIORITY_LOW |
+			LL_DMA_MODE_NORMAL |
+			LL_DMA_PERIPH_NOINCREMENT |
+			LL_DMA_MEMORY_INCREMENT |
+			LL_DMA_PDATAALIGN_BYTE |
+			LL_DMA_MDATAALIGN_BYTE);
+
+	/* Straight to or from caller buffer, source first */
+	if(channel == I2C_TX_DMA_CHANNEL)
+	{
+		LL_DMA_ConfigAddresses(DMA1, channel,
+				(uint32_t)request->data,
+				LL_I2C_DMA_GetRegAddr(I2C1, LL_I2C_DMA_REG_DATA_TRANSMIT),
+				direction);
+	}
+	else
+	{
+		LL_DMA_ConfigAddresses(DMA1, channel,
+				LL_I2C_DMA_GetRegAddr(I2C1, LL_I2C_DMA_REG_DATA_RECEIVE),
+				(uint32_t)request->data,
+				direction);
+	}
+
+	LL_DMA_SetDataLength(DMA1, channel, request->data_len);
+
+	/* End of transfer is signaled by STOP, no DMA interrupt */
+	LL_DMA_DisableIT_TC(DMA1, channel);
+	LL_DMA_EnableChannel(DMA1, channel);
+
+	/* DMA requests instead of data interrupts */
+	if(channel == I2C_TX_DMA_CHANNEL)
+	{
+		LL_I2C_DisableIT_TX(I2C1);
+		LL_I2C_EnableDMAReq_TX(I2C1);
+	}
+	else
+	{
+		LL_I2C_DisableIT_RX(I2C1);
+		LL_I2C_EnableDMAReq_RX(I2C1);
 	}
+
+	return TRUE;
 }
 
-static void Wait_for_TXE(void)
+inline static void Stop_DMA(void)
 {
-	uint32_t timeout = 0;
-	CLEAR_TICK;
+	LL_I2C_DisableDMAReq_TX(I2C1);
+	LL_I2C_DisableDMAReq_RX(I2C1);
 
-	/* Wait for RXNE flag */
-	while(!LL_I2C_IsActiveFlag_TXE(I2C1))
-	{
-		if(CHECK_TICK)
-			timeout++;
+	LL_I2C_EnableIT_TX(I2C1);
+	LL_I2C_EnableIT_RX(I2C1);
 
-		if(timeout >= I2C_TIMEOUT)
-		{
-			/* All flags will be cleared afterwards */
-			Reset_I2C();
+	current_dma = FALSE;
 
-			break;
-		}
-	}
+	/* Give channels back to display */
+	Release_display_DMA();
+}
+
+static void Clear_I2C(void)
+{
+	/* Clear flags */
+	LL_I2C_ClearFlag_STOP(I2C1);
+	LL_I2C_ClearFlag_NACK(I2C1);
+	LL_I2C_ClearFlag_BERR(I2C1);
+	LL_I2C_ClearFlag_ARLO(I2C1);
+	LL_I2C_ClearFlag_OVR(I2C1);
+
+	/* Flush TXDR */
+	LL_I2C_ClearFlag_TXE(I2C1);
 }
 
+static void Reset_I2C(void)
+{
+	/* 1. Write PE = 0 */
+	LL_I2C_Disable(I2C1);
+
+	/* 2. Check PE = 0 */
+	while(LL_I2C_IsEnabled(I2C1))
+	{
+		LL_I2C_Disable(I2C1);
+	}
+
+	/* 3. Write PE = 1 */
+	LL_I2C_Enable(I2C1);
+}
@@ -9,6 +9,106 @@
 #define I2C_DRV_H_
 
 #include <stdint.h>
+#include <stddef.h>
+
+enum I2C_REQ_TYPES
+{
+	I2C_REQ_CHECK_ADDR = 0,
+	I2C_REQ_WRITE_COMMAND,		/* Data only */
+	I2C_REQ_READ_COMMAND,		/* Data only */
+	I2C_REQ_READ_DATA,			/* Register address, repeated start, data */
+	I2C_REQ_WRITE_DATA			/* Register address, data */
+};
+
+enum I2C_SPEEDS
+{
+	I2C_STANDARD_MODE = 0,		/* 100kHz */
+	I2C_FAST_MODE,				/* 400kHz */
+	I2C_FAST_MODE_PLUS,			/* 1MHz */
+	NUM_OF_I2C_SPEEDS
+};
+
+enum I2C_REQ_PRIORITIES
+{
+	I2C_PRIORITY_NORMAL = 0,
+	I2C_PRIORITY_HIGH			/* Ahead of normal requests in the queue */
+};
+
+enum I2C_REQ_STATUSES
+{
+	I2C_REQ_IDLE = 0,
+	I2C_REQ_QUEUED,
+	I2C_REQ_BUSY,
+	I2C_REQ_DONE,
+	I2C_REQ_FAILED
+};
+
+/* Owned by caller, has to stay valid until done or failed */
+struct i2c_request_struct
+{
+	uint8_t type;
+	uint8_t device_addr;
+	uint8_t reg_addr;
+	uint8_t *data;
+	uint8_t data_len;
+	uint8_t priority;
+
+	volatile uint8_t status;
+	volatile uint32_t submit_time;		/* Scheduler time, when submitted */
+	volatile uint32_t start_time;		/* Scheduler time, when transfer started */
+
+	/* Called from interrupt, when done or failed */
+	void (*callback)(struct i2c_request_struct *request);
+};
+
+/* Entry of devices, which did not get their own */
+#define I2C_STATS_OTHER_DEVICES		0xFF
+
+/* Durations in TIM14 counts (10us), average is total divided by transactions */
+struct i2c_device_stats_struct
+{
+	uint8_t device_addr;
+
+	uint32_t transactions;
+	uint32_t bytes;				/* Data bytes only */
+	uint32_t nacks;
+	uint32_t bus_errors;		/* Arbitration lost, bus error, overrun */
+	uint32_t timeouts;
+	uint32_t resets;
+	uint32_t speed_fallbacks;	/* Drops to slower speed after errors */
+
+	uint32_t duration_min;
+	uint32_t duration_max;
+	uint32_t duration_total;
+
+	uint32_t wait_max;			/* Longest time from submit to start */
+};
+
+/* Bus recovery, after timeouts and bus errors */
+struct i2c_recovery_stats_struct
+{
+	uint32_t recoveries;			/* Bus released by recovery */
+	uint32_t recovery_failures;
+	uint32_t rejected_requests;		/* Failed fast, while bus was stuck */
+	uint32_t degraded_time;			/* ms */
+	uint32_t backoff;				/* ms, until next recovery attempt */
+};
+
+void Init_I2C(void);
+
+void I2C_Set_device_speed(uint8_t device_addr, uint8_t max_speed);
+uint8_t Get_I2C_device_speed(uint8_t device_addr);
+
+uint8_t I2C_Submit(struct i2c_request_struct *request);
+uint8_t I2C_Transfer(struct i2c_request_struct *request);
+uint8_t Is_I2C_idle(void);
+void Manage_I2C(void);
+
+void I2C_IRQ_handler(void);
+
+void I2C_Dump_stats(void (*dump)(const struct i2c_device_stats_struct *stats));
+void I2C_Clear_stats(void);
+void Get_I2C_recovery_stats(struct i2c_recovery_stats_struct *stats);
 
 uint8_t I2C_Check_Addr(uint8_t device_addr);
 
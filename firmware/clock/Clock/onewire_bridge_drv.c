@@ -9,6 +9,7 @@
 #include "common_defs.h"
 #include "common_fcns.h"
 #include "i2c_drv.h"
+#include "scheduler.h"
 
 #define DS2482_ADDR					0x30
 
@@ -19,7 +20,8 @@
 #define DS2482_CMD_1WRS				0xB4	// Execute 1-Wire Reset
 #define DS2482_CMD_1WWB				0xA5	// Execute 1-Wire Write Byte
 #define DS2482_CMD_1WRB				0x96	// Execute 1-Wire Read Byte
-#define DS2482_CMD_1WSB				0x87	// Execute 1-Wire Search Byte
+#define DS2482_CMD_1WSB				0x87	// Execute 1-Wire Single Bit
+#define DS2482_CMD_1WT				0x78	// Execute 1-Wire Triplet
 
 /* DS2482 Pointers to Registers */
 #define DS2482_PTR_STATUS_REG		0xF0
@@ -36,10 +38,122 @@
 #define DS2482_STATUS_TSB			0x40	// Triplet Second Bit
 #define DS2482_STATUS_DIR			0x80	// Branch Direction Taken
 
+/* DS2482 Configuration Register Bits, upper nibble is written as complement */
+#define DS2482_CFG_APU				0x01	// Active Pull-Up
+#define DS2482_CFG_SPU				0x04	// Strong Pull-Up, after next byte or bit, cleared when it ends
+#define DS2482_CFG_1WS				0x08	// 1-Wire Speed, overdrive
+#define DS2482_CONFIG_BYTE(cfg)		(uint8_t)(((~(cfg) & 0x0F) << 4) | (cfg))
+
 /* DS2482 Configuration */
-#define DS2482_CONFIGURATION		0xE1	// Active pull-up enabled, Strong pull-up disabled, 1-Wire speed standard
+#define DS2482_CONFIGURATION		DS2482_CFG_APU	// Active pull-up enabled, Strong pull-up disabled, 1-Wire speed standard
+
+/* DS2482 1-Wire timing, standard and overdrive speed */
+#define DS2482_RESET_TIME			1150	//us, tRSTL + tRSTH
+#define DS2482_RESET_TIME_OD		150		//us
+#define DS2482_BYTE_TIME			560		//us, 8 time slots
+#define DS2482_BYTE_TIME_OD			90		//us
+#define DS2482_TRIPLET_TIME			210		//us, 3 time slots
+#define DS2482_TRIPLET_TIME_OD		40		//us
+#define DS2482_POLL_INTERVAL		70		//us, one time slot
+#define DS2482_POLL_INTERVAL_OD		10		//us
+#define DS2482_BUSY_RETRIES			10		// Status polls after expected time, then bridge is reset
+
+/* Bit byte of single bit and triplet commands */
+#define DS2482_BIT_1				0x80
+
+/* 1-Wire ROM commands */
+#define ONEWIRE_CMD_SEARCH_ROM		0xF0
+#define ONEWIRE_ROM_BITS			(ONEWIRE_ROM_SIZE * 8)
+
+/* Dallas/Maxim CRC-8, x^8 + x^5 + x^4 + 1, LSB first */
+#define ONEWIRE_CRC8_INIT_VALUE		0x00
+
+#if ONEWIRE_CRC8_FULL_TABLE == TRUE
+static const uint8_t crc8_table[256] =
+{
+	0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+	0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E, 0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
+	0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0, 0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
+	0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D, 0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
+	0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5, 0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
+	0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58, 0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
+	0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6, 0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
+	0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B, 0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
+	0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F, 0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
+	0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92, 0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
+	0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C, 0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
+	0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1, 0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
+	0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49, 0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
+	0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4, 0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
+	0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A, 0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
+	0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7, 0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35
+};
+#else
+/* Table entry of a byte is XOR of entries of its nibbles */
+static const uint8_t crc8_table_low[16] =
+{
+	0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41
+};
+
+static const uint8_t crc8_table_high[16] =
+{
+	0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8, 0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74
+};
+#endif
 
-inline static uint8_t DS2482_read_data_register(uint8_t *data_reg);
+/* Each state waits for one I2C transfer, except slot wait */
+enum ONEWIRE_STATES
+{
+	OW_IDLE = 0,
+	OW_COMMAND,				/* 1-Wire command sent to DS2482 */
+	OW_SLOT_WAIT,			/* 1-Wire bus is busy for known time */
+	OW_STATUS_READ,			/* 1-Wire Busy polled */
+	OW_POINTER_SET,			/* Read pointer moved to data register */
+	OW_DATA_READ,
+	OW_BRIDGE_RESET,		/* 1-Wire Busy got stuck */
+	OW_BRIDGE_CONFIG
+};
+
+static struct i2c_request_struct ow_request;
+
+static uint8_t ow_state = OW_IDLE;
+static uint8_t ow_status = ONEWIRE_IDLE;
+static uint8_t ow_command;
+static uint8_t ow_tx_byte;
+static uint8_t ow_status_reg;
+static uint8_t ow_data;
+static uint8_t ow_retries;
+
+/* Bridge speed, changed by configuration writes */
+static uint8_t ow_overdrive = FALSE;
+static uint8_t ow_requested_overdrive = FALSE;
+
+/* Byte written after strong pull-up is configured */
+static uint8_t ow_power_byte;
+static uint8_t ow_power_byte_pending = FALSE;
+
+static uint32_t ow_wait_start;
+static uint32_t ow_wait_time;
+
+static struct onewire_stats_struct onewire_stats;
+
+#ifdef DEBUG
+/* CPU occupancy, read out with debugger */
+volatile uint32_t onewire_tick_cycles = 0;			/* SysTick cycles spent in state machine, during last tick */
+volatile uint32_t onewire_tick_cycles_max = 0;
+static uint32_t onewire_cycles = 0;
+static uint32_t onewire_cycles_tick = 0;
+#endif
+
+inline static uint8_t Start_operation(uint8_t command, uint8_t type, uint8_t reg_addr, uint32_t slot_time);
+inline static void Advance_operation(void);
+inline static void Submit_request(uint8_t type, uint8_t reg_addr, uint8_t *data, uint8_t next_state);
+inline static void Start_slot_wait(uint32_t wait_time);
+inline static void Finish_operation(uint8_t status);
+inline static uint8_t Wait_for_operation(void);
+inline static uint8_t OneWire_triplet(uint8_t direction, uint8_t *status);
+inline static uint32_t Slot_time(uint32_t standard_time, uint32_t overdrive_time);
+inline static uint8_t Config_byte(uint8_t strong_pullup);
 inline static void DS2482_Delay(void);
 
 
@@ -49,6 +163,9 @@ uint8_t Init_OneWire_bridge(void)
 
 	uint8_t config_reg = 0x00;
 
+	/* DS2482 supports fast mode */
+	I2C_Set_device_speed(DS2482_ADDR, I2C_FAST_MODE);
+
 	/* Trigger DS2482 device reset */
     if(I2C_Write_Command(DS2482_ADDR, DS2482_CMD_DRST) == TRUE)
 	{
@@ -58,7 +175,7 @@ uint8_t Init_OneWire_bridge(void)
 		DS2482_Delay();
 
 		/* Write configuration register: Active pull-up, 1-Wire speed standard */
-		if(I2C_Write_Register(DS2482_ADDR, DS2482_CMD_WCFG, DS2482_CONFIGURATION) == TRUE)
+		if(I2C_Write_Register(DS2482_ADDR, DS2482_CMD_WCFG, DS2482_CONFIG_BYTE(DS2482_CONFIGURATION)) == TRUE)
 		{
 			/* Configuration written successfully */
 			/* Register pointer is set to configuration register */
@@ -68,7 +185,7 @@ uint8_t Init_OneWire_bridge(void)
 				/* Configuration read successfully */
 
 				/* Check if configuration is correct (upper nibble of read is always 0) */
-				if(config_reg == (DS2482_CONFIGURATION & 0x0F))
+				if(config_reg == DS2482_CONFIGURATION)
 				{
 					/* Configuration is correct */
 					init_OK = TRUE;
@@ -100,60 +217,151 @@ uint8_t Init_OneWire_bridge(void)
 	return init_OK;
 }
 
-uint8_t OneWire_reset(void)
+uint8_t OneWire_start_reset(void)
 {
-	uint8_t any_device_present = FALSE;
+	/* Register pointer would be set to status register */
+	return Start_operation(DS2482_CMD_1WRS, I2C_REQ_WRITE_COMMAND, 0, Slot_time(DS2482_RESET_TIME, DS2482_RESET_TIME_OD));
+}
+
+uint8_t OneWire_start_write_byte(uint8_t data)
+{
+	if(ow_status == ONEWIRE_BUSY)
+	{
+		/* Byte of operation in progress is still in use */
+		return FALSE;
+	}
+
+	ow_tx_byte = data;
+
+	return Start_operation(DS2482_CMD_1WWB, I2C_REQ_WRITE_DATA, DS2482_CMD_1WWB, Slot_time(DS2482_BYTE_TIME, DS2482_BYTE_TIME_OD));
+}
+
+uint8_t OneWire_start_write_byte_power(uint8_t data)
+{
+	if(ow_status == ONEWIRE_BUSY)
+	{
+		/* Pending byte and speed of operation in progress are still in use */
+		return FALSE;
+	}
+
+	/* Strong pull-up is enabled first, byte is written after configuration */
+	ow_power_byte = data;
+	ow_power_byte_pending = TRUE;
+	ow_requested_overdrive = ow_overdrive;
+
+	ow_tx_byte = Config_byte(TRUE);
+
+	return Start_operation(DS2482_CMD_WCFG, I2C_REQ_WRITE_DATA, DS2482_CMD_WCFG, 0);
+}
+
+uint8_t OneWire_start_set_speed(uint8_t overdrive)
+{
+	if(ow_status == ONEWIRE_BUSY)
+	{
+		/* Pending byte and speed of operation in progress are still in use */
+		return FALSE;
+	}
+
+	if(overdrive == ow_overdrive)
+	{
+		/* Already there, no transfer needed */
+		ow_status = ONEWIRE_DONE;
+
+		return TRUE;
+	}
+
+	ow_power_byte_pending = FALSE;
+	ow_requested_overdrive = overdrive;
+
+	ow_tx_byte = Config_byte(FALSE);
 
-	uint8_t further_polling_needed = TRUE;
-	uint8_t status_reg = 0x00;
+	return Start_operation(DS2482_CMD_WCFG, I2C_REQ_WRITE_DATA, DS2482_CMD_WCFG, 0);
+}
+
+uint8_t OneWire_start_read_byte(void)
+{
+	return Start_operation(DS2482_CMD_1WRB, I2C_REQ_WRITE_COMMAND, 0, Slot_time(DS2482_BYTE_TIME, DS2482_BYTE_TIME_OD));
+}
+
+uint8_t OneWire_start_read_bit(void)
+{
+	if(ow_status == ONEWIRE_BUSY)
+	{
+		/* Byte of operation in progress is still in use */
+		return FALSE;
+	}
+
+	/* Write 1 time slot, samples what devices return */
+	ow_tx_byte = DS2482_BIT_1;
 
-	/* Trigger DS2482 1 Wire Reset, register pointer would be set to status register */
-    if(I2C_Write_Command(DS2482_ADDR, DS2482_CMD_1WRS) == TRUE)
+	return Start_operation(DS2482_CMD_1WSB, I2C_REQ_WRITE_DATA, DS2482_CMD_1WSB, Slot_time(DS2482_POLL_INTERVAL, DS2482_POLL_INTERVAL_OD));
+}
+
+uint8_t OneWire_start_triplet(uint8_t direction)
+{
+	if(ow_status == ONEWIRE_BUSY)
 	{
-		/* Keep polling status register until 1-Wire Busy bit is cleared */
-		do
+		/* Byte of operation in progress is still in use */
+		return FALSE;
+	}
+
+	/* Read bit, read complement, write chosen direction */
+	ow_tx_byte = (direction != 0) ? DS2482_BIT_1 : 0x00;
+
+	return Start_operation(DS2482_CMD_1WT, I2C_REQ_WRITE_DATA, DS2482_CMD_1WT, Slot_time(DS2482_TRIPLET_TIME, DS2482_TRIPLET_TIME_OD));
+}
+
+uint8_t OneWire_step(void)
+{
+#ifdef DEBUG
+	uint32_t step_start = GET_CYCLES;
+#endif
+
+	if(ow_state != OW_IDLE)
+	{
+		Advance_operation();
+	}
+
+#ifdef DEBUG
+	/* Sum per tick, publish when tick changes */
+	if(Get_scheduler_tick() != onewire_cycles_tick)
+	{
+		onewire_tick_cycles = onewire_cycles;
+
+		if(onewire_tick_cycles > onewire_tick_cycles_max)
 		{
-			/* Read status register */
-			if(I2C_Read_Command(DS2482_ADDR, &status_reg) == TRUE)
-			{
-				/* Check if 1-Wire Busy bit is cleared */
-				if(!(status_reg & DS2482_STATUS_1WB))
-				{
-					/* 1-Wire Busy bit cleared, further polling not needed */
-					further_polling_needed = FALSE;
-
-					/* Check if presence pulse was detected, and there is not a short on the bus */
-					if((status_reg & DS2482_STATUS_PPD) && !(status_reg & DS2482_STATUS_SD))
-					{
-						/* Presence pulse detected, and there is not a short on the bus */
-						/* Return at least one device is present */
-						any_device_present = TRUE;
-					}
-					else
-					{
-						/* No presence pulse detected or there is a short on the bus */
-						/* Return no devices present on the bus */
-						any_device_present = FALSE;
-					}
-				}
-				else
-				{
-					/* 1-Wire Busy bit still set, further polling needed */
-					further_polling_needed = TRUE;
-				}
-			}
-			else
-			{
-				/* Failed to read status register, quit */
-				further_polling_needed = FALSE;
-			}
+			onewire_tick_cycles_max = onewire_tick_cycles;
 		}
-		while(further_polling_needed == TRUE);
+
+		onewire_cycles = 0;
+		onewire_cycles_tick = Get_scheduler_tick();
 	}
-	else
+
+	onewire_cycles += CYCLES_SINCE(step_start);
+#endif
+
+	return ow_status;
+}
+
+uint8_t Get_OneWire_data(void)
+{
+	/* Byte of last read, bit of last single bit, or status after triplet */
+	return ow_data;
+}
+
+void Get_OneWire_stats(struct onewire_stats_struct *stats)
+{
+	*stats = onewire_stats;
+}
+
+uint8_t OneWire_reset(void)
+{
+	uint8_t any_device_present = FALSE;
+
+	/* Done only if presence pulse was detected, and there is not a short on the bus */
+	if(OneWire_start_reset() == TRUE)
 	{
-		/* Failed to trigger 1-Wire Reset */
-		any_device_present = FALSE;
+		any_device_present = Wait_for_operation();
 	}
 
 	return any_device_present;
@@ -163,123 +371,436 @@ uint8_t OneWire_write_byte(uint8_t data)
 {
 	uint8_t written_OK = FALSE;
 
-	uint8_t further_polling_needed = TRUE;
-	uint8_t status_reg = 0x00;
+	if(OneWire_start_write_byte(data) == TRUE)
+	{
+		written_OK = Wait_for_operation();
+	}
 
-	/* Trigger DS2482 1-Wire Write Byte */
-	if(I2C_Write_Register(DS2482_ADDR, DS2482_CMD_1WWB, data) == TRUE)
+	return written_OK;
+}
+
+uint8_t OneWire_read_byte(uint8_t *data)
+{
+	uint8_t read_OK = FALSE;
+
+	if(OneWire_start_read_byte() == TRUE)
 	{
-		/* Keep polling status register until 1-Wire Busy bit is cleared */
-		do
+		read_OK = Wait_for_operation();
+
+		if(read_OK == TRUE)
 		{
-			/* Read status register */
-			if(I2C_Read_Command(DS2482_ADDR, &status_reg) == TRUE)
+			*data = ow_data;
+		}
+	}
+
+	return read_OK;
+}
+
+uint8_t OneWire_read_bit(uint8_t *bit)
+{
+	uint8_t read_OK = FALSE;
+
+	if(OneWire_start_read_bit() == TRUE)
+	{
+		read_OK = Wait_for_operation();
+
+		if(read_OK == TRUE)
+		{
+			*bit = ow_data;
+		}
+	}
+
+	return read_OK;
+}
+
+uint8_t OneWire_set_speed(uint8_t overdrive)
+{
+	uint8_t set_OK = FALSE;
+
+	if(OneWire_start_set_speed(overdrive) == TRUE)
+	{
+		set_OK = Wait_for_operation();
+	}
+
+	return set_OK;
+}
+
+uint8_t Is_OneWire_overdrive(void)
+{
+	return ow_overdrive;
+}
+
+uint8_t OneWire_search_ROMs(uint8_t roms[][ONEWIRE_ROM_SIZE], uint8_t max_roms)
+{
+	uint8_t num_of_roms = 0;
+
+	uint8_t rom[ONEWIRE_ROM_SIZE] = {0};
+	uint8_t last_discrepancy = 0;
+	uint8_t last_zero;
+	uint8_t last_device = FALSE;
+	uint8_t status = 0x00;
+
+	while((last_device == FALSE) && (num_of_roms < max_roms))
+	{
+		/* Every pass finds one device */
+		if(OneWire_reset() == FALSE)
+		{
+			break;
+		}
+
+		if(OneWire_write_byte(ONEWIRE_CMD_SEARCH_ROM) == FALSE)
+		{
+			break;
+		}
+
+		last_zero = 0;
+
+		for(uint8_t bit = 1; bit <= ONEWIRE_ROM_BITS; bit++)
+		{
+			uint8_t byte_index = (bit - 1) >> 3;
+			uint8_t bit_mask = 1 << ((bit - 1) & 0x07);
+			uint8_t direction;
+
+			/* Repeat previous path, take 1 at last discrepancy, then 0 */
+			if(bit < last_discrepancy)
 			{
-				/* Check if 1-Wire Busy bit is cleared */
-				if(!(status_reg & DS2482_STATUS_1WB))
-				{
-					/* 1-Wire Busy bit cleared, further polling not needed */
-					further_polling_needed = FALSE;
+				direction = (rom[byte_index] & bit_mask) ? 1 : 0;
+			}
+			else
+			{
+				direction = (bit == last_discrepancy) ? 1 : 0;
+			}
 
-					/* Byte written successfully */
-					written_OK = TRUE;
-				}
-				else
-				{
-					/* 1-Wire Busy bit still set, further polling needed */
-					further_polling_needed = TRUE;
-				}
+			if(OneWire_triplet(direction, &status) == FALSE)
+			{
+				return num_of_roms;
+			}
+
+			if((status & DS2482_STATUS_SBR) && (status & DS2482_STATUS_TSB))
+			{
+				/* Nobody answered, devices left the bus */
+				return num_of_roms;
+			}
+
+			if(!(status & DS2482_STATUS_SBR) && !(status & DS2482_STATUS_TSB) && !(status & DS2482_STATUS_DIR))
+			{
+				/* Both values present, 0 taken */
+				last_zero = bit;
+			}
+
+			if(status & DS2482_STATUS_DIR)
+			{
+				rom[byte_index] |= bit_mask;
 			}
 			else
 			{
-				/* Failed to read status register, quit */
-				further_polling_needed = FALSE;
+				rom[byte_index] &= ~bit_mask;
 			}
 		}
-		while(further_polling_needed == TRUE);
+
+		if(Is_OneWire_ROM_valid(rom) == TRUE)
+		{
+			for(uint8_t i = 0; i < ONEWIRE_ROM_SIZE; i++)
+			{
+				roms[num_of_roms][i] = rom[i];
+			}
+
+			num_of_roms++;
+		}
+		else
+		{
+			/* Corrupted by noise, search goes on with next branch */
+			onewire_stats.rom_crc_errors++;
+		}
+
+		last_discrepancy = last_zero;
+
+		if(last_discrepancy == 0)
+		{
+			/* No branches left */
+			last_device = TRUE;
+		}
 	}
-	else
+
+	return num_of_roms;
+}
+
+uint8_t OneWire_CRC8(const uint8_t *data, uint8_t len)
+{
+	uint8_t crc = ONEWIRE_CRC8_INIT_VALUE;
+
+	for(uint8_t i = 0; i < len; i++)
 	{
-		/* Failed to trigger 1-Wire Write Byte */
-		written_OK = FALSE;
+		uint8_t index = crc ^ data[i];
+
+#if ONEWIRE_CRC8_FULL_TABLE == TRUE
+		crc = crc8_table[index];
+#else
+		crc = crc8_table_low[index & 0x0F] ^ crc8_table_high[index >> 4];
+#endif
 	}
 
-	return written_OK;
+	return crc;
 }
 
-uint8_t OneWire_read_byte(uint8_t *data)
+uint8_t Is_OneWire_ROM_valid(const uint8_t *rom)
 {
-	uint8_t read_OK = FALSE;
+	/* Last byte is CRC of family code and serial number, all zeros is a shorted bus */
+	return ((OneWire_CRC8(rom, ONEWIRE_ROM_SIZE - 1) == rom[ONEWIRE_ROM_SIZE - 1]) && (rom[0] != 0x00)) ? TRUE : FALSE;
+}
+
+inline static uint8_t Start_operation(uint8_t command, uint8_t type, uint8_t reg_addr, uint32_t slot_time)
+{
+	if(ow_status == ONEWIRE_BUSY)
+	{
+		/* Previous operation did not finish yet */
+		return FALSE;
+	}
 
-	uint8_t further_polling_needed = TRUE;
-	uint8_t status_reg = 0x00;
+	ow_command = command;
+	ow_wait_time = slot_time;
+	ow_retries = 0;
 
-	/* Trigger DS2482 1-Wire Read Byte */
-	if(I2C_Write_Command(DS2482_ADDR, DS2482_CMD_1WRB) == TRUE)
+	ow_status = ONEWIRE_BUSY;
+	onewire_stats.operations++;
+
+	/* Trigger DS2482 1-Wire command */
+	Submit_request(type, reg_addr, (type == I2C_REQ_WRITE_DATA) ? &ow_tx_byte : &ow_command, OW_COMMAND);
+
+	return TRUE;
+}
+
+inline static void Advance_operation(void)
+{
+	if(ow_state == OW_SLOT_WAIT)
 	{
-		/* Keep polling status register until 1-Wire Busy bit is cleared */
-		do
+		/* Do not hammer status register, while 1-Wire bus is known to be busy */
+		if((Get_scheduler_time() - ow_wait_start) >= ow_wait_time)
 		{
-			/* Read status register */
-			if(I2C_Read_Command(DS2482_ADDR, &status_reg) == TRUE)
+			onewire_stats.status_polls++;
+
+			Submit_request(I2C_REQ_READ_COMMAND, 0, &ow_status_reg, OW_STATUS_READ);
+		}
+
+		return;
+	}
+
+	if((ow_request.status == I2C_REQ_QUEUED) || (ow_request.status == I2C_REQ_BUSY))
+	{
+		/* Wait for I2C transfer */
+		return;
+	}
+
+	if(ow_request.status != I2C_REQ_DONE)
+	{
+		/* Bridge did not respond */
+		Finish_operation(ONEWIRE_FAILED);
+
+		return;
+	}
+
+	switch(ow_state)
+	{
+		case OW_COMMAND:
+			if(ow_command != DS2482_CMD_WCFG)
+			{
+				/* Wait out slot times */
+				Start_slot_wait(ow_wait_time);
+			}
+			else if(ow_power_byte_pending == TRUE)
+			{
+				/* Strong pull-up armed, write byte; pull-up stays on until next 1-Wire command */
+				ow_power_byte_pending = FALSE;
+
+				ow_command = DS2482_CMD_1WWB;
+				ow_wait_time = Slot_time(DS2482_BYTE_TIME, DS2482_BYTE_TIME_OD);
+
+				ow_tx_byte = ow_power_byte;
+				Submit_request(I2C_REQ_WRITE_DATA, DS2482_CMD_1WWB, &ow_tx_byte, OW_COMMAND);
+			}
+			else
 			{
-				/* Check if 1-Wire Busy bit is cleared */
-				if(!(status_reg & DS2482_STATUS_1WB))
+				/* New speed in effect */
+				ow_overdrive = ow_requested_overdrive;
+
+				Finish_operation(ONEWIRE_DONE);
+			}
+			break;
+
+		case OW_STATUS_READ:
+			if(ow_status_reg & DS2482_STATUS_1WB)
+			{
+				if(ow_retries < DS2482_BUSY_RETRIES)
 				{
-					/* 1-Wire Busy bit cleared, further polling not needed */
-					further_polling_needed = FALSE;
+					/* Check again after one time slot */
+					ow_retries++;
 
-					/* Read data register */
-					read_OK = DS2482_read_data_register(data);
+					Start_slot_wait(Slot_time(DS2482_POLL_INTERVAL, DS2482_POLL_INTERVAL_OD));
+				}
+				else
+				{
+					/* 1-Wire Busy stuck, abort by bridge reset */
+					onewire_stats.busy_timeouts++;
+
+					ow_tx_byte = DS2482_CMD_DRST;
+					Submit_request(I2C_REQ_WRITE_COMMAND, 0, &ow_tx_byte, OW_BRIDGE_RESET);
+				}
+			}
+			else if(ow_command == DS2482_CMD_1WRS)
+			{
+				/* Check if presence pulse was detected, and there is not a short on the bus */
+				if((ow_status_reg & DS2482_STATUS_PPD) && !(ow_status_reg & DS2482_STATUS_SD))
+				{
+					Finish_operation(ONEWIRE_DONE);
 				}
 				else
 				{
-					/* 1-Wire Busy bit still set, further polling needed */
-					further_polling_needed = TRUE;
+					Finish_operation(ONEWIRE_FAILED);
 				}
 			}
+			else if(ow_command == DS2482_CMD_1WSB)
+			{
+				/* Result is in Single Bit Result */
+				ow_data = (ow_status_reg & DS2482_STATUS_SBR) ? 1 : 0;
+
+				Finish_operation(ONEWIRE_DONE);
+			}
+			else if(ow_command == DS2482_CMD_1WT)
+			{
+				/* Result is in status */
+				ow_data = ow_status_reg;
+
+				Finish_operation(ONEWIRE_DONE);
+			}
+			else if(ow_command == DS2482_CMD_1WRB)
+			{
+				/* Set pointer to data register */
+				ow_tx_byte = DS2482_PTR_READ_DATA_REG;
+				Submit_request(I2C_REQ_WRITE_DATA, DS2482_CMD_SRP, &ow_tx_byte, OW_POINTER_SET);
+			}
 			else
 			{
-				/* Failed to read status register, quit */
-				further_polling_needed = FALSE;
+				/* Byte written */
+				Finish_operation(ONEWIRE_DONE);
 			}
-		}
-		while(further_polling_needed == TRUE);
+			break;
+
+		case OW_POINTER_SET:
+			/* Read data register */
+			Submit_request(I2C_REQ_READ_COMMAND, 0, &ow_data, OW_DATA_READ);
+			break;
+
+		case OW_DATA_READ:
+			Finish_operation(ONEWIRE_DONE);
+			break;
+
+		case OW_BRIDGE_RESET:
+			onewire_stats.bridge_resets++;
+
+			/* Reset cleared configuration, back at standard speed */
+			ow_overdrive = FALSE;
+			ow_power_byte_pending = FALSE;
+
+			ow_tx_byte = DS2482_CONFIG_BYTE(DS2482_CONFIGURATION);
+			Submit_request(I2C_REQ_WRITE_DATA, DS2482_CMD_WCFG, &ow_tx_byte, OW_BRIDGE_CONFIG);
+			break;
+
+		default:
+			/* Operation was aborted */
+			Finish_operation(ONEWIRE_FAILED);
+			break;
 	}
-	else
+}
+
+inline static void Submit_request(uint8_t type, uint8_t reg_addr, uint8_t *data, uint8_t next_state)
+{
+	ow_request.type			= type;
+	ow_request.device_addr	= DS2482_ADDR;
+	ow_request.reg_addr		= reg_addr;
+	ow_request.data			= data;
+	ow_request.data_len		= 1;
+	ow_request.priority		= I2C_PRIORITY_NORMAL;
+	ow_request.callback		= NULL;
+
+	ow_state = next_state;
+
+	if(I2C_Submit(&ow_request) == FALSE)
 	{
-		/* Failed to trigger 1-Wire Read Byte */
-		read_OK = FALSE;
+		/* Queue full or bus stuck */
+		Finish_operation(ONEWIRE_FAILED);
 	}
+}
 
-	return read_OK;
+inline static void Start_slot_wait(uint32_t wait_time)
+{
+	ow_wait_start = Get_scheduler_time();
+	ow_wait_time = wait_time;
+
+	ow_state = OW_SLOT_WAIT;
 }
 
-inline static uint8_t DS2482_read_data_register(uint8_t *data_reg)
+inline static void Finish_operation(uint8_t status)
 {
-	uint8_t read_OK = FALSE;
+	if(status == ONEWIRE_FAILED)
+	{
+		onewire_stats.failures++;
+	}
 
-	/* Set pointer to data register */
-	if(I2C_Write_Register(DS2482_ADDR, DS2482_CMD_SRP, DS2482_PTR_READ_DATA_REG) == TRUE)
+	ow_state = OW_IDLE;
+	ow_status = status;
+}
+
+inline static uint8_t Wait_for_operation(void)
+{
+	/* Bounded by retries and I2C timeout */
+	while(OneWire_step() == ONEWIRE_BUSY)
 	{
-		/* Read data register */
-		if(I2C_Read_Command(DS2482_ADDR, data_reg) == TRUE)
-		{
-			read_OK = TRUE;
-		}
-		else
+		Manage_I2C();
+	}
+
+	return (ow_status == ONEWIRE_DONE) ? TRUE : FALSE;
+}
+
+inline static uint8_t OneWire_triplet(uint8_t direction, uint8_t *status)
+{
+	uint8_t triplet_OK = FALSE;
+
+	if(OneWire_start_triplet(direction) == TRUE)
+	{
+		triplet_OK = Wait_for_operation();
+
+		if(triplet_OK == TRUE)
 		{
-			/* Failed to read data register */
-			read_OK = FALSE;
+			*status = ow_data;
 		}
 	}
-	else
+
+	return triplet_OK;
+}
+
+inline static uint32_t Slot_time(uint32_t standard_time, uint32_t overdrive_time)
+{
+	/* Expected 1-Wire bus time in TIM14 counts, at least one count */
+	uint32_t slot_time = SCHEDULER_US_TO_COUNTS((ow_overdrive == TRUE) ? overdrive_time : standard_time);
+
+	return (slot_time > 0) ? slot_time : 1;
+}
+
+inline static uint8_t Config_byte(uint8_t strong_pullup)
+{
+	uint8_t config = DS2482_CONFIGURATION;
+
+	if(ow_requested_overdrive == TRUE)
 	{
-		/* Failed to set pointer to data register */
-		read_OK = FALSE;
+		config |= DS2482_CFG_1WS;
 	}
-    
-	return read_OK;
+
+	if(strong_pullup == TRUE)
+	{
+		config |= DS2482_CFG_SPU;
+	}
+
+	return DS2482_CONFIG_BYTE(config);
 }
 
 inline static void DS2482_Delay(void)
@@ -10,11 +10,54 @@
 
 #include <stdint.h>
 
+/* 64-bit ROM code: family code, serial number, CRC */
+#define ONEWIRE_ROM_SIZE		8
+
+enum ONEWIRE_STATUSES
+{
+	ONEWIRE_IDLE = 0,
+	ONEWIRE_BUSY,
+	ONEWIRE_DONE,
+	ONEWIRE_FAILED
+};
+
+struct onewire_stats_struct
+{
+	uint32_t operations;
+	uint32_t failures;
+	uint32_t status_polls;
+	uint32_t busy_timeouts;		/* 1-Wire Busy still set after retries */
+	uint32_t bridge_resets;
+	uint32_t rom_crc_errors;	/* ROM codes dropped by search */
+};
 
 uint8_t Init_OneWire_bridge(void);
 
+/* Non-blocking, advanced by OneWire_step until not busy */
+uint8_t OneWire_start_reset(void);
+uint8_t OneWire_start_write_byte(uint8_t data);
+uint8_t OneWire_start_write_byte_power(uint8_t data);
+uint8_t OneWire_start_set_speed(uint8_t overdrive);
+uint8_t OneWire_start_read_byte(void);
+uint8_t OneWire_start_read_bit(void);
+uint8_t OneWire_start_triplet(uint8_t direction);
+uint8_t OneWire_step(void);
+uint8_t Get_OneWire_data(void);
+
+void Get_OneWire_stats(struct onewire_stats_struct *stats);
+
+/* Blocking, for initialization */
 uint8_t OneWire_reset(void);
 uint8_t OneWire_write_byte(uint8_t data);
 uint8_t OneWire_read_byte(uint8_t *data);
+uint8_t OneWire_read_bit(uint8_t *bit);
+uint8_t OneWire_set_speed(uint8_t overdrive);
+
+uint8_t Is_OneWire_overdrive(void);
+
+uint8_t OneWire_search_ROMs(uint8_t roms[][ONEWIRE_ROM_SIZE], uint8_t max_roms);
+
+uint8_t OneWire_CRC8(const uint8_t *data, uint8_t len);
+uint8_t Is_OneWire_ROM_valid(const uint8_t *rom);
 
 #endif /* ONEWIRE_BRIDGE_DRV_H_ */
@@ -7,10 +7,13 @@
 
 #include "rtc_drv.h"
 
+#include <assert.h>
+
 #include "common_defs.h"
 #include "common_fcns.h"
 
 #include "i2c_drv.h"
+#include "scheduler.h"
 
 #define DS3231_ADDR				0xD0
 
@@ -41,27 +44,98 @@
 #define DS3231_TEMP_DATA_LEN	2
 #define DS3231_TEMP_MSB_ADDR	0x11
 #define DS3231_TEMP_LSB_ADDR	0x12
+#define DS3231_TEMP_FRAC_BITS	2		/* 0.25*C resolution, left aligned in 16 bits */
+#define DS3231_TEMP_SHIFT		6
+
+#define DS3231_NUM_OF_REGS		19
+
+#define DS3231_TIME_REGS_MASK	(((1UL << DS3231_TIME_DATA_LEN) - 1) << DS3231_SECONDS_ADDR)
 
 #define DS3231_OSF_BIT			0x80
+#define DS3231_BSY_BIT			0x04
+#define DS3231_CONV_BIT			0x20
+
+#if RTC_SQW_ENABLED == TRUE
+/* Oscillator enabled, battery-backed square-wave disabled */
+/* do not force temperature conversion, 1Hz SQW output, disable alarms */
+#define DS3231_CONTROL_VALUE	0x00
+#else
+/* Oscillator enabled, battery-backed square-wave disabled */
+/* do not force temperature conversion, INT output (not SQW), disable alarms */
+#define DS3231_CONTROL_VALUE	0x04
+#endif
+
+/* Number of days in each month, BCD coded, February in non-leap year */
+static const uint8_t days_in_month[12] = {0x31, 0x28, 0x31, 0x30, 0x31, 0x30, 0x31, 0x31, 0x30, 0x31, 0x30, 0x31};
+
+/* Copy of DS3231 registers, dirty ones are waiting to be written */
+static uint8_t ds3231_shadow[DS3231_NUM_OF_REGS];
+static uint32_t ds3231_dirty = 0;
+
+static_assert(DS3231_NUM_OF_REGS == (DS3231_TEMP_LSB_ADDR + 1), "Shadow has to cover all DS3231 registers");
+static_assert(DS3231_NUM_OF_REGS <= 32, "Dirty mask too short");
+
+static struct rtc_bus_stats_struct rtc_bus_stats;
+
+/* Time read in the background */
+static struct i2c_request_struct rtc_time_request;
+static uint8_t rtc_time_buffer[DS3231_TIME_DATA_LEN];
+
+/* Temperature and register writes, one transfer at a time, stepped by Manage_RTC */
+enum RTC_STEPS
+{
+	RTC_STEP_IDLE = 0,
+	RTC_STEP_STATUS_READ,		/* Conversion is forced, unless one is running */
+	RTC_STEP_TEMP_READ,
+	RTC_STEP_FLUSH				/* One run of dirty registers */
+};
+
+static struct i2c_request_struct rtc_reg_request;
+static uint8_t rtc_reg_buffer[DS3231_NUM_OF_REGS];
+static uint8_t rtc_step = RTC_STEP_IDLE;
+
+static uint8_t rtc_conv_pending = FALSE;
+static uint8_t rtc_temp_read_pending = FALSE;
+static uint8_t rtc_flush_pending = FALSE;
+
+/* Temperature registers change only after conversion, keep last value */
+static int16_t rtc_temperature = 0;		/* Tenths of *C */
+static uint32_t rtc_temperature_tick = 0;		/* Scheduler tick of last read */
+static uint8_t rtc_temperature_valid = FALSE;
 
 uint8_t Get_RTC_time(volatile struct rtc_data_struct *rtc_data);
-uint8_t Get_RTC_temp(volatile struct rtc_data_struct *rtc_data);
 
-uint8_t Set_RTC_config(void);
+inline static void Write_RTC_time(volatile struct rtc_data_struct *rtc_data);
+inline static void Write_RTC_config(void);
+inline static void Start_RTC_step(void);
+inline static void Submit_RTC_step(uint8_t step, uint8_t type, uint8_t first_addr, uint8_t len);
+inline static void Finish_RTC_step(uint8_t status, volatile struct rtc_data_struct *rtc_data);
+inline static void Update_RTC_temp(void);
+
+inline static void Copy_RTC_time(volatile struct rtc_data_struct *rtc_data);
+inline static uint8_t Read_RTC_registers(uint8_t first_addr, uint8_t len);
+inline static void Store_RTC_registers(uint8_t first_addr, uint8_t *data, uint8_t len);
+inline static void Write_RTC_register(uint8_t addr, uint8_t value);
+inline static uint8_t Find_RTC_dirty_run(uint8_t *first_addr);
+inline static void Clear_RTC_dirty(uint8_t first_addr, const uint8_t *written, uint8_t len);
+inline static uint8_t Flush_RTC_registers(void);
+
+inline static uint8_t Inc_BCD_with_carry(volatile uint8_t *val, uint8_t min, uint8_t max);
 
 uint8_t Init_RTC(void)
 {
 	uint8_t init_OK = TRUE;
 
-	uint8_t reg;
+	/* DS3231 supports fast mode */
+	I2C_Set_device_speed(DS3231_ADDR, I2C_FAST_MODE);
 
 	/* Try to read status register */
-	if(I2C_Read_Register(DS3231_ADDR, DS3231_STATUS_ADDR, &reg) == TRUE)
+	if(Read_RTC_registers(DS3231_STATUS_ADDR, 1) == TRUE)
 	{
 		/* DS3231 acknowledged */
 
 		/* Check power-fail flag */
-		if(reg & DS3231_OSF_BIT)
+		if(ds3231_shadow[DS3231_STATUS_ADDR] & DS3231_OSF_BIT)
 		{
 			/* Power-fail flag is set, reset time to default */
 			struct rtc_data_struct initial_time;
@@ -70,13 +144,26 @@ uint8_t Init_RTC(void)
 			initial_time.minute = 0;
 			initial_time.second = 0;
 
-			initial_time.date = 1;
-			initial_time.month = 1;
-			initial_time.year = 25;
+			initial_time.date = 0x01;
+			initial_time.month = 0x01;
+			initial_time.year = 0x25;
+
+			/* Set default time, reset configuration to default */
+			Write_RTC_time(&initial_time);
+			Write_RTC_config();
+
+			/* Registers are contiguous, so this is a single transaction */
+			init_OK &= Flush_RTC_registers();
+		}
+#if RTC_SQW_ENABLED == TRUE
+		else
+		{
+			/* Enable 1Hz square wave, time was set by older firmware */
+			Write_RTC_register(DS3231_CONTROL_ADDR, DS3231_CONTROL_VALUE);
 
-			/* Set default time */
-			init_OK &= Set_RTC_time(&initial_time);
+			init_OK &= Flush_RTC_registers();
 		}
+#endif
 	}
 	else
 	{
@@ -94,52 +181,70 @@ uint8_t Get_RTC_data(volatile struct rtc_data_struct *rtc_data)
 	/* Get time */
 	get_OK &= Get_RTC_time(rtc_data);
 
-	/* Get temperature */
-	get_OK &= Get_RTC_temp(rtc_data);
+	/* Temperature is read on its own schedule, use cached value */
+	rtc_data->temperature = rtc_temperature;
 
 	return get_OK;
 }
 
 uint8_t Set_RTC_time(volatile struct rtc_data_struct *rtc_data)
 {
-	uint8_t set_OK = TRUE;
+	Write_RTC_time(rtc_data);
+
+	/* Reset configuration to default, written together with time */
+	Write_RTC_config();
 
-	uint8_t buffer[DS3231_TIME_DATA_LEN];
+	/* Sent by Manage_RTC, registers are contiguous, so this is a single transaction */
+	rtc_flush_pending = TRUE;
 
-	/* Reset configuration to default */
-	set_OK &= Set_RTC_config();
+	return TRUE;
+}
 
-	buffer[DS3231_SECONDS_ADDR]	= DEC2BCD(rtc_data->second) & 0x7F;
-	buffer[DS3231_MINUTES_ADDR]	= DEC2BCD(rtc_data->minute) & 0x7F;
-	buffer[DS3231_HOURS_ADDR] 	= DEC2BCD(rtc_data->hour) & 0x3F;		/* Select 24h mode */
-	buffer[DS3231_DAY_ADDR] 	= 0x01;									/* Set day to 1st */
-	buffer[DS3231_DATE_ADDR] 	= DEC2BCD(rtc_data->date) & 0x3F;
-	buffer[DS3231_MONTH_ADDR] 	= DEC2BCD(rtc_data->month) & 0x1F;
-	buffer[DS3231_YEAR_ADDR] 	= DEC2BCD(rtc_data->year) & 0xFF;
+void Advance_RTC_time(volatile struct rtc_data_struct *rtc_data)
+{
+	uint8_t month_index = BCD2BIN(rtc_data->month) - 1;
 
-	set_OK &= I2C_Write_Data(DS3231_ADDR, DS3231_SECONDS_ADDR, buffer, DS3231_TIME_DATA_LEN);
+	/* Invalid month, treat as January */
+	if(month_index > 11)
+	{
+		month_index = 0;
+	}
 
-	return set_OK;
+	uint8_t last_date = days_in_month[month_index];
+
+	/* February in leap year, 2000 - 2099 */
+	if((rtc_data->month == 0x02) && ((BCD2BIN(rtc_data->year) & 0x03) == 0))
+	{
+		last_date = 0x29;
+	}
+
+	/* Propagate carry, as DS3231 does */
+	if(Inc_BCD_with_carry(&rtc_data->second, 0x00, 0x59) == FALSE)
+		return;
+
+	if(Inc_BCD_with_carry(&rtc_data->minute, 0x00, 0x59) == FALSE)
+		return;
+
+	if(Inc_BCD_with_carry(&rtc_data->hour, 0x00, 0x23) == FALSE)
+		return;
+
+	if(Inc_BCD_with_carry(&rtc_data->date, 0x01, last_date) == FALSE)
+		return;
+
+	if(Inc_BCD_with_carry(&rtc_data->month, 0x01, 0x12) == FALSE)
+		return;
+
+	Inc_BCD_with_carry(&rtc_data->year, 0x00, 0x99);
 }
 
 uint8_t Get_RTC_time(volatile struct rtc_data_struct *rtc_data)
 {
 	uint8_t get_OK = FALSE;
 
-	uint8_t buffer[DS3231_TIME_DATA_LEN];
-
 	/* Get data */
-	if(I2C_Read_Data(DS3231_ADDR, DS3231_SECONDS_ADDR, buffer, DS3231_TIME_DATA_LEN) == TRUE)
+	if(Read_RTC_registers(DS3231_SECONDS_ADDR, DS3231_TIME_DATA_LEN) == TRUE)
 	{
-		/* Convert time */
-		rtc_data->second = BCD2BIN(buffer[DS3231_SECONDS_ADDR] & 0x7F);
-		rtc_data->minute = BCD2BIN(buffer[DS3231_MINUTES_ADDR] & 0x7F);
-		rtc_data->hour = BCD2BIN(buffer[DS3231_HOURS_ADDR] & 0x3F);
-
-		/* Convert date */
-		rtc_data->date = BCD2BIN(buffer[DS3231_DATE_ADDR] & 0x3F);
-		rtc_data->month = BCD2BIN(buffer[DS3231_MONTH_ADDR] & 0x1F);
-		rtc_data->year = BCD2BIN(buffer[DS3231_YEAR_ADDR] & 0xFF);
+		Copy_RTC_time(rtc_data);
 
 		/* Collected OK */
 		get_OK = TRUE;
@@ -148,55 +253,422 @@ uint8_t Get_RTC_time(volatile struct rtc_data_struct *rtc_data)
 	return get_OK;
 }
 
-uint8_t Get_RTC_temp(volatile struct rtc_data_struct *rtc_data)
+uint8_t Start_RTC_data_read(void)
 {
-	uint8_t get_OK = FALSE;
+	/* Previous read still in progress */
+	if((rtc_time_request.status == I2C_REQ_QUEUED) || (rtc_time_request.status == I2C_REQ_BUSY))
+	{
+		return FALSE;
+	}
+
+	/* New time not written yet, read would overtake it */
+	if((rtc_flush_pending == TRUE) && (ds3231_dirty & DS3231_TIME_REGS_MASK))
+	{
+		return FALSE;
+	}
 
-	uint8_t buffer[DS3231_TEMP_DATA_LEN];
+	rtc_time_request.type			= I2C_REQ_READ_DATA;
+	rtc_time_request.device_addr	= DS3231_ADDR;
+	rtc_time_request.reg_addr		= DS3231_SECONDS_ADDR;
+	rtc_time_request.data			= rtc_time_buffer;
+	rtc_time_request.data_len		= DS3231_TIME_DATA_LEN;
+	rtc_time_request.callback		= NULL;
 
-	/* Get data */
-	if(I2C_Read_Data(DS3231_ADDR, DS3231_TEMP_MSB_ADDR, buffer, DS3231_TEMP_DATA_LEN) == TRUE)
+	/* Phase tracking depends on reading in time */
+	rtc_time_request.priority		= I2C_PRIORITY_HIGH;
+
+	/* Transfer runs in the background */
+	return I2C_Submit(&rtc_time_request);
+}
+
+uint8_t Get_RTC_data_read(volatile struct rtc_data_struct *rtc_data, uint32_t *read_time)
+{
+	uint8_t status = rtc_time_request.status;
+
+	if(status == I2C_REQ_DONE)
 	{
-		/* Convert temperature */
-		rtc_data->temperature = buffer[DS3231_TEMP_MSB_ADDR - DS3231_TEMP_MSB_ADDR];	/* Reg addr minus base addr (set during write */
+		Store_RTC_registers(DS3231_SECONDS_ADDR, rtc_time_buffer, DS3231_TIME_DATA_LEN);
 
-		/* Collected OK */
-		get_OK = TRUE;
+		Copy_RTC_time(rtc_data);
+
+		/* Temperature is read on its own schedule, use cached value */
+		rtc_data->temperature = rtc_temperature;
+
+		/* DS3231 latches time at the start of the transfer */
+		*read_time = rtc_time_request.start_time;
 	}
 
-	return get_OK;
+	if((status == I2C_REQ_DONE) || (status == I2C_REQ_FAILED))
+	{
+		/* Result taken */
+		rtc_time_request.status = I2C_REQ_IDLE;
+	}
+
+	return status;
+}
+
+uint8_t Start_RTC_temp_conversion(void)
+{
+	if(rtc_conv_pending == TRUE)
+	{
+		return FALSE;
+	}
+
+	/* Status is read first by Manage_RTC, conversion is forced unless one is running */
+	rtc_conv_pending = TRUE;
+
+	return TRUE;
+}
+
+uint8_t Start_RTC_temp_read(void)
+{
+	if(rtc_temp_read_pending == TRUE)
+	{
+		return FALSE;
+	}
+
+	/* Read by Manage_RTC, result goes to cache */
+	rtc_temp_read_pending = TRUE;
+
+	return TRUE;
+}
+
+void Manage_RTC(volatile struct rtc_data_struct *rtc_data)
+{
+	uint8_t status = rtc_reg_request.status;
+
+	/* Transfer runs in the background */
+	if((status == I2C_REQ_QUEUED) || (status == I2C_REQ_BUSY))
+	{
+		return;
+	}
+
+	if((status == I2C_REQ_DONE) || (status == I2C_REQ_FAILED))
+	{
+		Finish_RTC_step(status, rtc_data);
+
+		/* Result taken */
+		rtc_reg_request.status = I2C_REQ_IDLE;
+	}
+
+	Start_RTC_step();
+}
+
+uint8_t Is_RTC_idle(void)
+{
+	/* Failed writes stay dirty, but wait for next flush */
+	return ((rtc_step == RTC_STEP_IDLE) && (rtc_conv_pending == FALSE) &&
+			(rtc_temp_read_pending == FALSE) && (rtc_flush_pending == FALSE)) ? TRUE : FALSE;
+}
+
+uint32_t Get_RTC_temp_age(void)
+{
+	/* In scheduler ticks, maximum if never read */
+	return (rtc_temperature_valid == TRUE) ? (Get_scheduler_tick() - rtc_temperature_tick) : 0xFFFFFFFF;
+}
+
+void Get_RTC_bus_stats(struct rtc_bus_stats_struct *stats)
+{
+	*stats = rtc_bus_stats;
+}
+
+inline static void Write_RTC_time(volatile struct rtc_data_struct *rtc_data)
+{
+	Write_RTC_register(DS3231_SECONDS_ADDR,	rtc_data->second & 0x7F);
+	Write_RTC_register(DS3231_MINUTES_ADDR,	rtc_data->minute & 0x7F);
+	Write_RTC_register(DS3231_HOURS_ADDR,	rtc_data->hour & 0x3F);		/* Select 24h mode */
+	Write_RTC_register(DS3231_DAY_ADDR,		0x01);						/* Set day to 1st */
+	Write_RTC_register(DS3231_DATE_ADDR,	rtc_data->date & 0x3F);
+	Write_RTC_register(DS3231_MONTH_ADDR,	rtc_data->month & 0x1F);
+	Write_RTC_register(DS3231_YEAR_ADDR,	rtc_data->year & 0xFF);
 }
 
-uint8_t Set_RTC_config(void)
+inline static void Write_RTC_config(void)
 {
-	uint8_t set_OK = TRUE;
+	/* Disable alarm 1 */
+	Write_RTC_register(DS3231_ALARM1_SEC,		0x00);
+	Write_RTC_register(DS3231_ALARM1_MIN,		0x00);
+	Write_RTC_register(DS3231_ALARM1_HOURS,		0x00);
+	Write_RTC_register(DS3231_ALARM1_DAY_DATE,	0x01);
 
-	/* Oscillator enabled, battery-backed square-wave disabled */
-	/* do not force temperature conversion, INT output (not SQW), disable alarms */
-	set_OK &= I2C_Write_Register(DS3231_ADDR, DS3231_CONTROL_ADDR, 0x04);
+	/* Disable alarm 2 */
+	Write_RTC_register(DS3231_ALARM2_MIN,		0x00);
+	Write_RTC_register(DS3231_ALARM2_HOURS,		0x00);
+	Write_RTC_register(DS3231_ALARM2_DAY_DATE,	0x01);
+
+	/* Set control register */
+	Write_RTC_register(DS3231_CONTROL_ADDR, DS3231_CONTROL_VALUE);
 
 	/* Clear power-fail flag, disable 32kHz output, clear alarm flags */
-	set_OK &= I2C_Write_Register(DS3231_ADDR, DS3231_STATUS_ADDR, 0x00);
+	Write_RTC_register(DS3231_STATUS_ADDR, 0x00);
 
 	/* Clear aging offset */
-	set_OK &= I2C_Write_Register(DS3231_ADDR, DS3231_AGING_ADDR, 0x00);
+	Write_RTC_register(DS3231_AGING_ADDR, 0x00);
+}
 
-	uint8_t alarm1_buffer[DS3231_ALARM1_DATA_LEN], alarm2_buffer[DS3231_ALARM2_DATA_LEN];
+inline static void Start_RTC_step(void)
+{
+	uint8_t first_addr = 0;
+	uint8_t len;
 
-	alarm1_buffer[DS3231_ALARM1_SEC - DS3231_ALARM1_SEC] 		= 0x00;
-	alarm1_buffer[DS3231_ALARM1_MIN - DS3231_ALARM1_SEC] 		= 0x00;
-	alarm1_buffer[DS3231_ALARM1_HOURS - DS3231_ALARM1_SEC] 		= 0x00;
-	alarm1_buffer[DS3231_ALARM1_DAY_DATE - DS3231_ALARM1_SEC]	= 0x01;
+	if(rtc_flush_pending == TRUE)
+	{
+		len = Find_RTC_dirty_run(&first_addr);
 
-	/* Disable alarm 1 */
-	set_OK &= I2C_Write_Data(DS3231_ADDR, DS3231_ALARM1_SEC, alarm1_buffer, DS3231_ALARM1_DATA_LEN);
+		if(len > 0)
+		{
+			/* Copy, shadow may change while it is being sent */
+			for(uint8_t i = 0; i < len; i++)
+			{
+				rtc_reg_buffer[i] = ds3231_shadow[first_addr + i];
+			}
 
-	alarm2_buffer[DS3231_ALARM2_MIN - DS3231_ALARM2_MIN] 		= 0x00;
-	alarm2_buffer[DS3231_ALARM2_HOURS - DS3231_ALARM2_MIN] 		= 0x00;
-	alarm2_buffer[DS3231_ALARM2_DAY_DATE - DS3231_ALARM2_MIN] 	= 0x01;
+			Submit_RTC_step(RTC_STEP_FLUSH, I2C_REQ_WRITE_DATA, first_addr, len);
 
-	/* Disable alarm 2 */
-	set_OK &= I2C_Write_Data(DS3231_ADDR, DS3231_ALARM2_MIN, alarm2_buffer, DS3231_ALARM2_DATA_LEN);
+			return;
+		}
+
+		/* All written */
+		rtc_flush_pending = FALSE;
+	}
+
+	if(rtc_conv_pending == TRUE)
+	{
+		/* Check if conversion is already in progress */
+		Submit_RTC_step(RTC_STEP_STATUS_READ, I2C_REQ_READ_DATA, DS3231_STATUS_ADDR, 1);
+	}
+	else if(rtc_temp_read_pending == TRUE)
+	{
+		Submit_RTC_step(RTC_STEP_TEMP_READ, I2C_REQ_READ_DATA, DS3231_TEMP_MSB_ADDR, DS3231_TEMP_DATA_LEN);
+	}
+}
+
+inline static void Submit_RTC_step(uint8_t step, uint8_t type, uint8_t first_addr, uint8_t len)
+{
+	rtc_reg_request.type			= type;
+	rtc_reg_request.device_addr		= DS3231_ADDR;
+	rtc_reg_request.reg_addr		= first_addr;
+	rtc_reg_request.data			= rtc_reg_buffer;
+	rtc_reg_request.data_len		= len;
+	rtc_reg_request.priority		= I2C_PRIORITY_NORMAL;
+	rtc_reg_request.callback		= NULL;
+
+	rtc_step = step;
+
+	/* Queue full, tried again in next step; rejected on stuck bus, finished as failed */
+	if((I2C_Submit(&rtc_reg_request) == FALSE) && (rtc_reg_request.status != I2C_REQ_FAILED))
+	{
+		rtc_step = RTC_STEP_IDLE;
+	}
+}
+
+inline static void Finish_RTC_step(uint8_t status, volatile struct rtc_data_struct *rtc_data)
+{
+	switch(rtc_step)
+	{
+		case RTC_STEP_STATUS_READ:
+			rtc_conv_pending = FALSE;
+
+			if(status == I2C_REQ_DONE)
+			{
+				Store_RTC_registers(DS3231_STATUS_ADDR, rtc_reg_buffer, 1);
+
+				/* If busy, result will be fresh anyway */
+				if((ds3231_shadow[DS3231_STATUS_ADDR] & DS3231_BSY_BIT) == 0)
+				{
+					/* Force conversion */
+					Write_RTC_register(DS3231_CONTROL_ADDR, DS3231_CONTROL_VALUE | DS3231_CONV_BIT);
+
+					rtc_flush_pending = TRUE;
+				}
+			}
+			break;
+
+		case RTC_STEP_TEMP_READ:
+			rtc_temp_read_pending = FALSE;
+
+			if(status == I2C_REQ_DONE)
+			{
+				Store_RTC_registers(DS3231_TEMP_MSB_ADDR, rtc_reg_buffer, DS3231_TEMP_DATA_LEN);
+
+				Update_RTC_temp();
+
+				/* Shown with next second */
+				rtc_data->temperature = rtc_temperature;
+			}
+			break;
+
+		case RTC_STEP_FLUSH:
+			if(status == I2C_REQ_DONE)
+			{
+				Clear_RTC_dirty(rtc_reg_request.reg_addr, rtc_reg_buffer, rtc_reg_request.data_len);
+			}
+			else
+			{
+				/* Keep dirty, next flush retries it */
+				rtc_flush_pending = FALSE;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	rtc_step = RTC_STEP_IDLE;
+}
+
+inline static void Update_RTC_temp(void)
+{
+	uint8_t *buffer = &ds3231_shadow[DS3231_TEMP_MSB_ADDR];
+
+	/* Combine integer MSB and fractional LSB, reg addr minus base addr */
+	int16_t raw_temp = (int16_t)((buffer[DS3231_TEMP_MSB_ADDR - DS3231_TEMP_MSB_ADDR] << 8) | buffer[DS3231_TEMP_LSB_ADDR - DS3231_TEMP_MSB_ADDR]) >> DS3231_TEMP_SHIFT;
+
+	/* Convert to tenths of *C */
+	rtc_temperature = FIXED_TO_TENTHS(raw_temp, DS3231_TEMP_FRAC_BITS);
+
+	/* Remember when */
+	rtc_temperature_tick = Get_scheduler_tick();
+	rtc_temperature_valid = TRUE;
+}
+
+inline static void Copy_RTC_time(volatile struct rtc_data_struct *rtc_data)
+{
+	uint8_t *buffer = &ds3231_shadow[DS3231_SECONDS_ADDR];
+
+	/* Copy time, keep BCD */
+	rtc_data->second = buffer[DS3231_SECONDS_ADDR] & 0x7F;
+	rtc_data->minute = buffer[DS3231_MINUTES_ADDR] & 0x7F;
+	rtc_data->hour = buffer[DS3231_HOURS_ADDR] & 0x3F;
+
+	/* Copy date, keep BCD */
+	rtc_data->date = buffer[DS3231_DATE_ADDR] & 0x3F;
+	rtc_data->month = buffer[DS3231_MONTH_ADDR] & 0x1F;
+	rtc_data->year = buffer[DS3231_YEAR_ADDR] & 0xFF;
+}
+
+inline static uint8_t Read_RTC_registers(uint8_t first_addr, uint8_t len)
+{
+	uint8_t local_buffer[DS3231_NUM_OF_REGS];
+
+	/* Straight into the shadow, unless some values wait to be written */
+	uint8_t *buffer = (ds3231_dirty & (((1UL << len) - 1) << first_addr)) ? local_buffer : &ds3231_shadow[first_addr];
+
+	/* Get exactly the requested window */
+	if(I2C_Read_Data(DS3231_ADDR, first_addr, buffer, len) == FALSE)
+	{
+		return FALSE;
+	}
+
+	Store_RTC_registers(first_addr, buffer, len);
+
+	return TRUE;
+}
+
+inline static void Store_RTC_registers(uint8_t first_addr, uint8_t *data, uint8_t len)
+{
+	/* Address, register address, repeated start address, data */
+	rtc_bus_stats.read_transactions++;
+	rtc_bus_stats.bytes += 3 + len;
+
+	for(uint8_t i = 0; i < len; i++)
+	{
+		/* Do not overwrite values waiting to be written */
+		if((ds3231_dirty & (1UL << (first_addr + i))) == 0)
+		{
+			ds3231_shadow[first_addr + i] = data[i];
+		}
+	}
+}
+
+inline static void Write_RTC_register(uint8_t addr, uint8_t value)
+{
+	ds3231_shadow[addr] = value;
+	ds3231_dirty |= (1UL << addr);
+}
+
+inline static uint8_t Find_RTC_dirty_run(uint8_t *first_addr)
+{
+	uint8_t addr = *first_addr;
+	uint8_t len = 0;
+
+	/* First dirty register from given address */
+	while((addr < DS3231_NUM_OF_REGS) && ((ds3231_dirty & (1UL << addr)) == 0))
+	{
+		addr++;
+	}
+
+	/* Run of adjacent dirty registers */
+	while(((addr + len) < DS3231_NUM_OF_REGS) && (ds3231_dirty & (1UL << (addr + len))))
+	{
+		len++;
+	}
+
+	*first_addr = addr;
+
+	return len;
+}
+
+inline static void Clear_RTC_dirty(uint8_t first_addr, const uint8_t *written, uint8_t len)
+{
+	/* Address, register address, data */
+	rtc_bus_stats.write_transactions++;
+	rtc_bus_stats.bytes += 2 + len;
+
+	for(uint8_t i = 0; i < len; i++)
+	{
+		/* Changed while being sent, stays dirty */
+		if(ds3231_shadow[first_addr + i] == written[i])
+		{
+			ds3231_dirty &= ~(1UL << (first_addr + i));
+		}
+	}
+
+	/* CONV bit is cleared by DS3231 when done, unless it is waiting to be sent again */
+	if((ds3231_dirty & (1UL << DS3231_CONTROL_ADDR)) == 0)
+	{
+		ds3231_shadow[DS3231_CONTROL_ADDR] &= ~DS3231_CONV_BIT;
+	}
+}
+
+inline static uint8_t Flush_RTC_registers(void)
+{
+	uint8_t flush_OK = TRUE;
+
+	uint8_t addr = 0;
+	uint8_t len;
+
+	while((len = Find_RTC_dirty_run(&addr)) > 0)
+	{
+		/* Write it in one burst */
+		if(I2C_Write_Data(DS3231_ADDR, addr, &ds3231_shadow[addr], len) == TRUE)
+		{
+			/* Written, shadow matches DS3231 */
+			Clear_RTC_dirty(addr, &ds3231_shadow[addr], len);
+		}
+		else
+		{
+			/* Keep dirty, next flush retries it */
+			flush_OK = FALSE;
+		}
+
+		addr += len;
+	}
+
+	return flush_OK;
+}
+
+inline static uint8_t Inc_BCD_with_carry(volatile uint8_t *val, uint8_t min, uint8_t max)
+{
+	/* Rewind also invalid values */
+	if(*val >= max)
+	{
+		*val = min;
+
+		return TRUE;
+	}
+
+	Inc_BCD_value_with_rewind(val, min, max);
 
-	return set_OK;
+	return FALSE;
 }
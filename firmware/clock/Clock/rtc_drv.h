@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 
+/* Date and time are BCD coded, as stored in DS3231 */
 struct rtc_data_struct
 {
 	uint8_t year;
@@ -19,13 +20,35 @@ struct rtc_data_struct
 	uint8_t minute;
 	uint8_t second;
 
-	int8_t temperature;
+	int16_t temperature;		/* Tenths of *C */
+};
+
+/* DS3231 bus traffic */
+struct rtc_bus_stats_struct
+{
+	uint32_t read_transactions;
+	uint32_t write_transactions;
+	uint32_t bytes;				/* Including address bytes */
 };
 
 uint8_t Init_RTC(void);
 
 uint8_t Get_RTC_data(volatile struct rtc_data_struct *rtc_data);
 
+uint8_t Start_RTC_data_read(void);
+uint8_t Get_RTC_data_read(volatile struct rtc_data_struct *rtc_data, uint32_t *read_time);
+
+void Advance_RTC_time(volatile struct rtc_data_struct *rtc_data);
+
+/* Queued, finished by Manage_RTC in later main loop passes */
 uint8_t Set_RTC_time(volatile struct rtc_data_struct *rtc_data);
+uint8_t Start_RTC_temp_conversion(void);
+uint8_t Start_RTC_temp_read(void);
+uint32_t Get_RTC_temp_age(void);
+
+void Manage_RTC(volatile struct rtc_data_struct *rtc_data);
+uint8_t Is_RTC_idle(void);
+
+void Get_RTC_bus_stats(struct rtc_bus_stats_struct *stats);
 
 #endif /* RTC_DRV_H_ */
@@ -0,0 +1,632 @@
+/*
+ * rtc_sync.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#include "rtc_sync.h"
+
+#include "common_defs.h"
+#include "common_fcns.h"
+
+#include "scheduler.h"
+#include "display_drv.h"
+
+enum RTC_READ_TYPES
+{
+	REGULAR_READ = 0,
+	EDGE_READ,			/* Bisects the expected rollover window */
+	FOLLOW_UP_READ		/* At the end of the window, if edge read was too early */
+};
+
+/* Nominal time between regular reads */
+static uint32_t read_interval;
+
+/* Length of RTC second, tracked against TIM14, and how far it can be off per second */
+static uint32_t rtc_second;
+static uint32_t rtc_second_bound;
+
+static uint32_t next_read_time;
+static uint8_t next_read_type = REGULAR_READ;
+static uint8_t regular_reads_left = 0;
+
+/* Rollover window, latest time known before and earliest time known after the rollover */
+static uint32_t window_low;
+static uint32_t window_high;
+static uint8_t window_valid = FALSE;
+static uint32_t edge_read_time;
+
+static uint8_t sync_locked = FALSE;
+static uint8_t locked_seconds = 0;
+
+/* Center of the last narrow window */
+static uint32_t last_center;
+static uint8_t last_center_valid = FALSE;
+static uint32_t seconds_since_center = 1;
+
+/* Narrow window RTC second is measured from, longer baseline is more precise */
+static uint32_t anchor_center;
+static uint32_t anchor_width;
+static uint32_t seconds_since_anchor = 0;
+
+/* Rollovers left to predict without reading RTC */
+static uint32_t interp_seconds_left = 0;
+static uint8_t interp_resync = FALSE;
+
+static uint8_t last_second;
+static uint32_t last_read_time;
+static uint8_t last_second_valid = FALSE;
+
+/* DS3231 SQW output is connected to UNUSED_1 pin */
+#define RTC_SQW_EXTI_LINE		LL_EXTI_LINE_4
+
+/* Square wave edges counted by interrupt */
+static volatile uint8_t sqw_pending_seconds = 0;
+static volatile uint32_t sqw_edge_time;
+
+static uint8_t sqw_active = FALSE;
+static uint8_t sqw_time_valid = FALSE;		/* Time was read after an edge */
+static uint8_t sqw_read_requested = FALSE;
+static uint32_t sqw_resync_counter = 0;
+
+/* Rollover to display latency, upper bound */
+static uint8_t latency_pending = FALSE;
+static uint32_t latency_start;
+
+static volatile struct rtc_sync_stats_struct rtc_sync_stats;
+
+inline static uint8_t Take_SQW_seconds(void);
+inline static uint8_t Take_interpolated_seconds(void);
+inline static void Schedule_after_rollover(void);
+inline static void Measure_RTC_second(uint32_t center, uint32_t width);
+inline static uint32_t Get_interp_seconds(void);
+inline static void Schedule_next_read(uint32_t previous_read_time);
+inline static void Lose_sync(void);
+inline static uint8_t Is_time_reached(uint32_t time);
+inline static void Request_SQW_read(uint32_t edge_time);
+
+void Init_RTC_sync(void)
+{
+	uint32_t tick_counts = LL_TIM_GetAutoReload(TIM14) + 1;
+
+	/* Start with nominal values */
+	read_interval	= RTC_READ_PERIOD * tick_counts;
+	rtc_second		= UPDATE_FREQUENCY * tick_counts;
+
+	/* Not measured yet, HSI tolerance */
+	rtc_second_bound = SCHEDULER_US_TO_COUNTS(RTC_SYNC_ACQUIRE_MARGIN);
+
+	rtc_sync_stats.rtc_second = rtc_second;
+
+	RTC_sync_reset();
+
+#if RTC_SQW_ENABLED == TRUE
+	/* Interrupt on falling edge of SQW, coincident with seconds update */
+	LL_SYSCFG_SetEXTISource(LL_SYSCFG_EXTI_PORTA, LL_SYSCFG_EXTI_LINE4);
+	LL_EXTI_EnableFallingTrig_0_31(RTC_SQW_EXTI_LINE);
+	LL_EXTI_ClearFlag_0_31(RTC_SQW_EXTI_LINE);
+	LL_EXTI_EnableIT_0_31(RTC_SQW_EXTI_LINE);
+
+	NVIC_SetPriority(EXTI4_15_IRQn, 0);
+	NVIC_EnableIRQ(EXTI4_15_IRQn);
+#endif
+}
+
+void RTC_SQW_IRQ_handler(void)
+{
+	if(LL_EXTI_IsActiveFlag_0_31(RTC_SQW_EXTI_LINE))
+	{
+		LL_EXTI_ClearFlag_0_31(RTC_SQW_EXTI_LINE);
+
+		/* Count new second */
+		sqw_edge_time = Get_scheduler_time();
+
+		if(sqw_pending_seconds < 0xFF)
+		{
+			sqw_pending_seconds++;
+		}
+	}
+}
+
+uint8_t Take_RTC_elapsed_seconds(void)
+{
+	/* Square wave has priority, if present */
+	uint8_t seconds = Take_SQW_seconds();
+
+	if(sqw_active == FALSE)
+	{
+		seconds = Take_interpolated_seconds();
+	}
+
+	return seconds;
+}
+
+uint8_t Is_RTC_read_due(void)
+{
+	if(sqw_active == TRUE)
+	{
+		/* Time is advanced by square wave, read only to resync */
+		return ((sqw_read_requested == TRUE) && (Is_time_reached(next_read_time) == TRUE)) ? TRUE : FALSE;
+	}
+
+	if(interp_seconds_left > 0)
+	{
+		/* Time is advanced by prediction */
+		return FALSE;
+	}
+
+	return Is_time_reached(next_read_time);
+}
+
+uint32_t Get_RTC_time_to_read(void)
+{
+	if(((sqw_active == TRUE) && (sqw_read_requested == FALSE)) || ((sqw_active == FALSE) && (interp_seconds_left > 0)))
+	{
+		/* Next read is at least a second away */
+		return RTC_SYNC_NO_READ_DUE;
+	}
+
+	if(Is_time_reached(next_read_time) == TRUE)
+	{
+		return 0;
+	}
+
+	return next_read_time - Get_scheduler_time();
+}
+
+uint8_t RTC_sync_update(uint8_t second, uint32_t read_time, uint8_t time_matches)
+{
+	uint8_t changed = ((last_second_valid == TRUE) && (second != last_second)) ? TRUE : FALSE;
+	uint32_t previous_read_time = last_read_time;
+
+	last_second = second;
+	last_read_time = read_time;
+	last_second_valid = TRUE;
+
+	/* Wrap-safe, reads can not start early */
+	if((int32_t)(read_time - next_read_time) >= 0)
+	{
+		rtc_sync_stats.read_delay = read_time - next_read_time;
+
+		if(rtc_sync_stats.read_delay > rtc_sync_stats.read_delay_max)
+		{
+			rtc_sync_stats.read_delay_max = rtc_sync_stats.read_delay;
+		}
+	}
+
+	if(time_matches == FALSE)
+	{
+		/* Time differs from what was kept in RAM */
+		if((window_valid == TRUE) || ((sqw_active == TRUE) && (sqw_time_valid == TRUE)))
+		{
+			rtc_sync_stats.discrepancies++;
+		}
+
+		/* Start over from this read */
+		Lose_sync();
+	}
+
+	if(sqw_active == TRUE)
+	{
+		/* Read away from edges, time can be advanced from now on */
+		sqw_read_requested = FALSE;
+		sqw_time_valid = TRUE;
+
+		return FALSE;
+	}
+
+	if(changed == TRUE)
+	{
+		/* Display will show new second, rollover was not earlier than that */
+		latency_start = (next_read_type == REGULAR_READ) ? previous_read_time : window_low;
+	}
+
+	if(window_valid == FALSE)
+	{
+		/* Nothing expected, treat as regular read */
+		next_read_type = REGULAR_READ;
+	}
+
+	switch(next_read_type)
+	{
+		case EDGE_READ:
+			if(changed == TRUE)
+			{
+				/* Rollover in the first half of the window */
+				window_high = read_time;
+
+				Schedule_after_rollover();
+			}
+			else
+			{
+				/* Rollover in the second half, read again at the end of the window */
+				window_low = read_time;
+
+				next_read_type = FOLLOW_UP_READ;
+				next_read_time = window_high;
+			}
+			break;
+
+		case FOLLOW_UP_READ:
+			if(changed == TRUE)
+			{
+				window_high = read_time;
+
+				Schedule_after_rollover();
+			}
+			else
+			{
+				/* Rollover outside of the window, start over */
+				rtc_sync_stats.lost_locks++;
+
+				Lose_sync();
+
+				Schedule_next_read(read_time);
+			}
+			break;
+
+		default:
+			if((changed == TRUE) && ((read_time - previous_read_time) <= (read_interval << 1)))
+			{
+				/* Rollover between previous and this read, unexpected if locked */
+				if(window_valid == TRUE)
+				{
+					Lose_sync();
+				}
+
+				window_low = previous_read_time;
+				window_high = read_time;
+				window_valid = TRUE;
+
+				Schedule_after_rollover();
+			}
+			else
+			{
+				Schedule_next_read(read_time);
+			}
+			break;
+	}
+
+	return changed;
+}
+
+void RTC_sync_no_data(void)
+{
+	/* Nothing known about this read */
+	last_second_valid = FALSE;
+
+	/* Try again after next edge */
+	sqw_read_requested = FALSE;
+	sqw_time_valid = FALSE;
+
+	Lose_sync();
+
+	Schedule_next_read(next_read_time);
+}
+
+void RTC_sync_reset(void)
+{
+	/* RTC phase is unknown, e.g. after setting the time */
+	last_second_valid = FALSE;
+
+	Lose_sync();
+
+	/* Read right away, next edge is a second away */
+	next_read_type = REGULAR_READ;
+	next_read_time = Get_scheduler_time();
+
+	sqw_time_valid = FALSE;
+	sqw_read_requested = TRUE;
+}
+
+void RTC_sync_displayed(void)
+{
+	/* Measure when display transfer is done */
+	latency_pending = TRUE;
+}
+
+void Manage_RTC_sync_latency(void)
+{
+	if((latency_pending == TRUE) && (Is_display_busy() == FALSE))
+	{
+		latency_pending = FALSE;
+
+		rtc_sync_stats.latency = Get_scheduler_time() - latency_start;
+
+		/* Worst case only when locked, acquisition is slow by design */
+		if((sync_locked == TRUE) && (rtc_sync_stats.latency > rtc_sync_stats.latency_max))
+		{
+			rtc_sync_stats.latency_max = rtc_sync_stats.latency;
+		}
+	}
+}
+
+uint8_t Is_RTC_sync_locked(void)
+{
+	return sync_locked;
+}
+
+void Get_RTC_sync_stats(struct rtc_sync_stats_struct *stats)
+{
+	*stats = rtc_sync_stats;
+}
+
+inline static uint8_t Take_SQW_seconds(void)
+{
+	uint8_t seconds;
+	uint32_t edge_time;
+
+	/* Take edges counted by interrupt */
+	__disable_irq();
+	seconds = sqw_pending_seconds;
+	sqw_pending_seconds = 0;
+	edge_time = sqw_edge_time;
+	__enable_irq();
+
+	if(seconds == 0)
+	{
+		/* Fall back to polling, if square wave is gone */
+		if((sqw_active == TRUE) && ((Get_scheduler_time() - edge_time) > (RTC_SQW_TIMEOUT * rtc_second)))
+		{
+			sqw_active = FALSE;
+
+			RTC_sync_reset();
+		}
+
+		return 0;
+	}
+
+	if(sqw_active == FALSE)
+	{
+		/* Square wave present, stop polling */
+		sqw_active = TRUE;
+		sqw_time_valid = FALSE;
+
+		Lose_sync();
+	}
+
+	if(sqw_time_valid == FALSE)
+	{
+		/* Time is not known relative to edges yet */
+		Request_SQW_read(edge_time);
+
+		return 0;
+	}
+
+	/* Re-read RTC from time to time */
+	sqw_resync_counter += seconds;
+	if(sqw_resync_counter >= RTC_SQW_RESYNC_PERIOD)
+	{
+		sqw_resync_counter = 0;
+
+		Request_SQW_read(edge_time);
+	}
+
+	/* Display latency is measured from the edge */
+	latency_start = edge_time;
+	sync_locked = TRUE;
+
+	return seconds;
+}
+
+inline static uint8_t Take_interpolated_seconds(void)
+{
+	/* Predicted rollover is in the center of the window */
+	uint32_t rollover_time = window_low + ((window_high - window_low) >> 1);
+
+	if((interp_seconds_left == 0) || (Is_time_reached(rollover_time) == FALSE))
+	{
+		return 0;
+	}
+
+	/* Window of the next rollover, widened by possible drift and error of RTC second */
+	uint32_t margin = SCHEDULER_US_TO_COUNTS(RTC_INTERP_DRIFT_MARGIN) + rtc_second_bound;
+
+	window_low	= window_low + rtc_second - margin;
+	window_high	= window_high + rtc_second + margin;
+
+	seconds_since_center++;
+
+	interp_seconds_left--;
+	if(interp_seconds_left == 0)
+	{
+		interp_resync = TRUE;
+
+		/* Resync, by bisecting the next rollover */
+		edge_read_time = window_low + ((window_high - window_low) >> 1);
+
+		next_read_type = EDGE_READ;
+		next_read_time = edge_read_time;
+	}
+
+	/* Follow the time kept in RAM */
+	Inc_BCD_value_with_rewind(&last_second, 0x00, 0x59);
+
+	latency_start = rollover_time;
+
+	return 1;
+}
+
+inline static void Schedule_after_rollover(void)
+{
+	uint32_t width = window_high - window_low;
+	uint32_t center = window_low + (width >> 1);
+
+	/* Until RTC second is known, window has to cover HSI tolerance */
+	uint32_t margin = SCHEDULER_US_TO_COUNTS(RTC_SYNC_ACQUIRE_MARGIN);
+
+	/* Track RTC second only with narrow windows */
+	if(width <= SCHEDULER_US_TO_COUNTS(RTC_SYNC_TRAIN_WINDOW))
+	{
+		if(last_center_valid == TRUE)
+		{
+			int32_t error = (int32_t)(center - (last_center + (rtc_second * seconds_since_center)));
+
+			if(seconds_since_center > 1)
+			{
+				/* Resync after interpolation, keep drift statistics */
+				uint32_t abs_error = (error < 0) ? -error : error;
+
+				rtc_sync_stats.resyncs++;
+				rtc_sync_stats.last_error = error;
+
+				if(abs_error > rtc_sync_stats.max_error)
+				{
+					rtc_sync_stats.max_error = abs_error;
+				}
+			}
+
+			seconds_since_anchor += seconds_since_center;
+
+			Measure_RTC_second(center, width);
+
+			/* Widen next window by read jitter and error of RTC second */
+			margin = SCHEDULER_US_TO_COUNTS(RTC_SYNC_WINDOW_MARGIN) + rtc_second_bound;
+		}
+		else
+		{
+			/* Measure from here */
+			anchor_center = center;
+			anchor_width = width;
+			seconds_since_anchor = 0;
+		}
+
+		last_center = center;
+		last_center_valid = TRUE;
+	}
+	else
+	{
+		last_center_valid = FALSE;
+	}
+
+	seconds_since_center = 1;
+
+	/* Check if rollover is known precisely enough */
+	if(width <= SCHEDULER_US_TO_COUNTS(RTC_SYNC_LOCK_WINDOW))
+	{
+		sync_locked = TRUE;
+
+		if(locked_seconds < 0xFF)
+		{
+			locked_seconds++;
+		}
+	}
+	else
+	{
+		sync_locked = FALSE;
+		locked_seconds = 0;
+	}
+
+	uint32_t rollover_seen = window_high;
+
+	/* Predict next rollover */
+	window_low	= window_low + rtc_second - margin;
+	window_high	= window_high + rtc_second + margin;
+
+	/* Bisect it */
+	edge_read_time = window_low + ((window_high - window_low) >> 1);
+
+#if RTC_INTERP_ENABLED == TRUE
+	/* Once RTC second is learned, predict rollovers instead of reading */
+	uint32_t interp_seconds = Get_interp_seconds();
+
+	if((interp_seconds > 1) && (sync_locked == TRUE) && ((locked_seconds >= RTC_INTERP_LOCKED_SECONDS) || (interp_resync == TRUE)))
+	{
+		interp_resync = FALSE;
+		interp_seconds_left = interp_seconds - 1;
+		regular_reads_left = 0;
+
+		return;
+	}
+
+	if(interp_resync == TRUE)
+	{
+		/* Only edge reads until locked again */
+		regular_reads_left = 0;
+		Schedule_next_read(rollover_seen);
+
+		return;
+	}
+#endif
+
+	/* Regular reads go right after this rollover */
+	regular_reads_left = RTC_READ_FREQUENCY - 1;
+	Schedule_next_read(rollover_seen);
+}
+
+inline static void Measure_RTC_second(uint32_t center, uint32_t width)
+{
+	/* Error of both centers, spread over all seconds in between */
+	uint32_t bound = (((anchor_width + width) >> 1) + seconds_since_anchor - 1) / seconds_since_anchor;
+
+	/* Keep the best estimate, but follow HSI drift with a fresh long one */
+	if((bound < rtc_second_bound) || (seconds_since_anchor >= RTC_SYNC_MAX_BASELINE))
+	{
+		rtc_second = (center - anchor_center + (seconds_since_anchor >> 1)) / seconds_since_anchor;
+		rtc_second_bound = bound;
+
+		rtc_sync_stats.rtc_second = rtc_second;
+	}
+
+	/* Restart from a much narrower window, or once baseline is long enough */
+	if((width < (anchor_width >> 1)) || (seconds_since_anchor >= RTC_SYNC_MAX_BASELINE))
+	{
+		anchor_center = center;
+		anchor_width = width;
+		seconds_since_anchor = 0;
+	}
+}
+
+inline static uint32_t Get_interp_seconds(void)
+{
+	/* Predicted rollover may drift by error of RTC second, at most half of lock window */
+	uint32_t seconds = (SCHEDULER_US_TO_COUNTS(RTC_SYNC_LOCK_WINDOW) >> 1) / ((rtc_second_bound > 0) ? rtc_second_bound : 1);
+
+	return (seconds < RTC_INTERP_RESYNC_PERIOD) ? seconds : RTC_INTERP_RESYNC_PERIOD;
+}
+
+inline static void Schedule_next_read(uint32_t previous_read_time)
+{
+	if((window_valid == TRUE) && (regular_reads_left == 0))
+	{
+		next_read_type = EDGE_READ;
+		next_read_time = edge_read_time;
+	}
+	else
+	{
+		next_read_type = REGULAR_READ;
+		next_read_time = previous_read_time + read_interval;
+
+		if(regular_reads_left > 0)
+		{
+			regular_reads_left--;
+		}
+	}
+}
+
+inline static void Lose_sync(void)
+{
+	window_valid = FALSE;
+	sync_locked = FALSE;
+	locked_seconds = 0;
+	last_center_valid = FALSE;
+	seconds_since_center = 1;
+	regular_reads_left = 0;
+	interp_seconds_left = 0;
+	interp_resync = FALSE;
+}
+
+inline static uint8_t Is_time_reached(uint32_t time)
+{
+	/* Wrap-safe */
+	return ((int32_t)(Get_scheduler_time() - time) >= 0) ? TRUE : FALSE;
+}
+
+inline static void Request_SQW_read(uint32_t edge_time)
+{
+	/* Far enough from edges, so read and edge count do not race */
+	next_read_time = edge_time + SCHEDULER_US_TO_COUNTS(RTC_SQW_READ_DELAY);
+
+	sqw_read_requested = TRUE;
+}
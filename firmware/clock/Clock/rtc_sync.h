@@ -0,0 +1,51 @@
+/*
+ * rtc_sync.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#ifndef RTC_SYNC_H_
+#define RTC_SYNC_H_
+
+#include <stdint.h>
+
+/* All times are scheduler times, in TIM14 counts (10us) */
+struct rtc_sync_stats_struct
+{
+	uint32_t rtc_second;		/* Measured length of RTC second */
+	int32_t last_error;			/* Rollover prediction error at last resync */
+	uint32_t max_error;			/* Largest absolute prediction error at resync */
+	uint32_t resyncs;
+	uint32_t lost_locks;
+	uint32_t discrepancies;		/* RTC time differed from time kept in RAM */
+
+	uint32_t latency;			/* Rollover to display latency */
+	uint32_t latency_max;
+
+	uint32_t read_delay;		/* Read start after it was due, by main loop and bus traffic */
+	uint32_t read_delay_max;
+};
+
+/* No read scheduled */
+#define RTC_SYNC_NO_READ_DUE		0xFFFFFFFF
+
+void Init_RTC_sync(void);
+
+void RTC_SQW_IRQ_handler(void);
+uint8_t Take_RTC_elapsed_seconds(void);
+
+uint8_t Is_RTC_read_due(void);
+uint32_t Get_RTC_time_to_read(void);
+
+uint8_t RTC_sync_update(uint8_t second, uint32_t read_time, uint8_t time_matches);
+void RTC_sync_no_data(void);
+void RTC_sync_reset(void);
+
+void RTC_sync_displayed(void);
+void Manage_RTC_sync_latency(void);
+
+uint8_t Is_RTC_sync_locked(void);
+void Get_RTC_sync_stats(struct rtc_sync_stats_struct *stats);
+
+#endif /* RTC_SYNC_H_ */
@@ -0,0 +1,125 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#include "scheduler.h"
+
+#include "common_defs.h"
+
+/* Incremented by TIM14 update interrupt */
+static volatile uint32_t scheduler_tick = 0;
+
+/* Last tick handled by Run_scheduler */
+static uint32_t last_run_tick = 0;
+
+/* Ticks, which passed without Run_scheduler being called */
+static volatile uint32_t scheduler_missed_ticks = 0;
+
+inline static uint32_t Get_time_since_tick(uint32_t tick);
+
+void Scheduler_tick(void)
+{
+	scheduler_tick++;
+}
+
+uint32_t Get_scheduler_tick(void)
+{
+	return scheduler_tick;
+}
+
+uint32_t Get_scheduler_missed_ticks(void)
+{
+	return scheduler_missed_ticks;
+}
+
+uint32_t Get_scheduler_time(void)
+{
+	/* TIM14 counts since start, wraps every ~12 hours */
+	return Get_time_since_tick(0);
+}
+
+void Init_scheduler(struct task_struct *tasks, uint8_t num_of_tasks)
+{
+	last_run_tick = scheduler_tick;
+
+	for(uint8_t i = 0; i < num_of_tasks; i++)
+	{
+		/* First run is at the phase of the next period */
+		tasks[i].next_due = last_run_tick + tasks[i].phase;
+
+		tasks[i].wcet = 0;
+		tasks[i].overruns = 0;
+	}
+}
+
+void Run_scheduler(struct task_struct *tasks, uint8_t num_of_tasks, uint32_t tick)
+{
+	/* Count ticks, which were not handled in time */
+	if((tick - last_run_tick) > 1)
+	{
+		scheduler_missed_ticks += tick - last_run_tick - 1;
+	}
+
+	last_run_tick = tick;
+
+	for(uint8_t i = 0; i < num_of_tasks; i++)
+	{
+		/* Check if task is due, wrap-safe */
+		if((int32_t)(tick - tasks[i].next_due) < 0)
+		{
+			continue;
+		}
+
+		uint32_t start = Get_time_since_tick(tick);
+
+		/* Run task */
+		tasks[i].function();
+
+		uint32_t end = Get_time_since_tick(tick);
+
+		/* Update statistics */
+		if((end - start) > tasks[i].wcet)
+		{
+			tasks[i].wcet = end - start;
+		}
+
+		if(end > tasks[i].deadline)
+		{
+			tasks[i].overruns++;
+		}
+
+		/* Schedule next run, skipping periods which were missed */
+		do
+		{
+			tasks[i].next_due += tasks[i].period;
+		}
+		while((int32_t)(tick - tasks[i].next_due) >= 0);
+	}
+}
+
+inline static uint32_t Get_time_since_tick(uint32_t tick)
+{
+	uint32_t now_tick;
+	uint32_t pending;
+	uint32_t counts;
+
+	/* Get consistent tick and counter, update may be pending if interrupts are busy */
+	do
+	{
+		now_tick = scheduler_tick;
+		pending = LL_TIM_IsActiveFlag_UPDATE(TIM14);
+		counts = LL_TIM_GetCounter(TIM14);
+	}
+	while((now_tick != scheduler_tick) || (pending != LL_TIM_IsActiveFlag_UPDATE(TIM14)));
+
+	if(pending)
+	{
+		/* Counter already rolled over, but tick was not counted yet */
+		now_tick++;
+	}
+
+	return ((now_tick - tick) * (LL_TIM_GetAutoReload(TIM14) + 1)) + counts;
+}
@@ -0,0 +1,39 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+
+/* Scheduler time base is TIM14 counter, running at 100kHz */
+#define SCHEDULER_TIMER_FREQUENCY	100000	//Hz
+#define SCHEDULER_US_TO_COUNTS(us)	((us) / (1000000 / SCHEDULER_TIMER_FREQUENCY))
+
+/* Periods and phases are in ticks, deadline and execution time in TIM14 counts */
+struct task_struct
+{
+	void (*function)(void);
+
+	uint32_t period;
+	uint32_t phase;
+	uint32_t deadline;		/* Latest completion, from start of the tick */
+
+	uint32_t next_due;
+	uint32_t wcet;			/* Worst case execution time */
+	uint32_t overruns;		/* Number of missed deadlines */
+};
+
+void Scheduler_tick(void);
+uint32_t Get_scheduler_tick(void);
+uint32_t Get_scheduler_missed_ticks(void);
+uint32_t Get_scheduler_time(void);
+
+void Init_scheduler(struct task_struct *tasks, uint8_t num_of_tasks);
+void Run_scheduler(struct task_struct *tasks, uint8_t num_of_tasks, uint32_t tick);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,99 @@
+/*
+ * seg_font.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#ifndef SEG_FONT_H_
+#define SEG_FONT_H_
+
+#include <stdint.h>
+
+/* Canonical segments */
+#define SEG_A				0x01	/* Top */
+#define SEG_B				0x02	/* Upper right */
+#define SEG_C				0x04	/* Lower right */
+#define SEG_D				0x08	/* Bottom */
+#define SEG_E				0x10	/* Lower left */
+#define SEG_F				0x20	/* Upper left */
+#define SEG_G				0x40	/* Middle */
+#define SEG_DP				0x80	/* Decimal point */
+
+/* Glyphs */
+#define GLYPH_0				(SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F)
+#define GLYPH_1				(SEG_B | SEG_C)
+#define GLYPH_2				(SEG_A | SEG_B | SEG_D | SEG_E | SEG_G)
+#define GLYPH_3				(SEG_A | SEG_B | SEG_C | SEG_D | SEG_G)
+#define GLYPH_4				(SEG_B | SEG_C | SEG_F | SEG_G)
+#define GLYPH_5				(SEG_A | SEG_C | SEG_D | SEG_F | SEG_G)
+#define GLYPH_6				(SEG_A | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G)
+#define GLYPH_7				(SEG_A | SEG_B | SEG_C)
+#define GLYPH_8				(SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G)
+#define GLYPH_9				(SEG_A | SEG_B | SEG_C | SEG_D | SEG_F | SEG_G)
+
+#define GLYPH_A				(SEG_A | SEG_B | SEG_C | SEG_E | SEG_F | SEG_G)
+#define GLYPH_b				(SEG_C | SEG_D | SEG_E | SEG_F | SEG_G)
+#define GLYPH_C				(SEG_A | SEG_D | SEG_E | SEG_F)
+#define GLYPH_c				(SEG_D | SEG_E | SEG_G)
+#define GLYPH_d				(SEG_B | SEG_C | SEG_D | SEG_E | SEG_G)
+#define GLYPH_E				(SEG_A | SEG_D | SEG_E | SEG_F | SEG_G)
+#define GLYPH_F				(SEG_A | SEG_E | SEG_F | SEG_G)
+#define GLYPH_G				(SEG_A | SEG_C | SEG_D | SEG_E | SEG_F)
+#define GLYPH_H				(SEG_B | SEG_C | SEG_E | SEG_F | SEG_G)
+#define GLYPH_h				(SEG_C | SEG_E | SEG_F | SEG_G)
+#define GLYPH_I				(SEG_E | SEG_F)
+#define GLYPH_I_RIGHT		(SEG_B | SEG_C)
+#define GLYPH_J				(SEG_B | SEG_C | SEG_D | SEG_E)
+#define GLYPH_L				(SEG_D | SEG_E | SEG_F)
+#define GLYPH_n				(SEG_C | SEG_E | SEG_G)
+#define GLYPH_o				(SEG_C | SEG_D | SEG_E | SEG_G)
+#define GLYPH_P				(SEG_A | SEG_B | SEG_E | SEG_F | SEG_G)
+#define GLYPH_r				(SEG_E | SEG_G)
+#define GLYPH_S				GLYPH_5
+#define GLYPH_t				(SEG_D | SEG_E | SEG_F | SEG_G)
+#define GLYPH_U				(SEG_B | SEG_C | SEG_D | SEG_E | SEG_F)
+#define GLYPH_u				(SEG_C | SEG_D | SEG_E)
+#define GLYPH_y				(SEG_B | SEG_C | SEG_D | SEG_F | SEG_G)
+
+#define GLYPH_MINUS			(SEG_G)
+#define GLYPH_UNDERSCORE	(SEG_D)
+#define GLYPH_DEGREE		(SEG_A | SEG_B | SEG_F | SEG_G)
+#define GLYPH_BLANK			0x00
+
+/* Move canonical segment to given bit */
+#define REMAP_SEG(glyph, seg, bit)	(((glyph) & (seg)) ? (1 << (bit)) : 0)
+
+/* pabcdefg configuration */
+#define MAP_TO_PABCDEFG(glyph)	(uint8_t)(	REMAP_SEG(glyph, SEG_DP, 7) | REMAP_SEG(glyph, SEG_A, 6) | \
+											REMAP_SEG(glyph, SEG_B, 5) | REMAP_SEG(glyph, SEG_C, 4) | \
+											REMAP_SEG(glyph, SEG_D, 3) | REMAP_SEG(glyph, SEG_E, 2) | \
+											REMAP_SEG(glyph, SEG_F, 1) | REMAP_SEG(glyph, SEG_G, 0))
+
+/* dcpefgba configuration */
+#define MAP_TO_DCPEFGBA(glyph)	(uint8_t)(	REMAP_SEG(glyph, SEG_D, 7) | REMAP_SEG(glyph, SEG_C, 6) | \
+											REMAP_SEG(glyph, SEG_DP, 5) | REMAP_SEG(glyph, SEG_E, 4) | \
+											REMAP_SEG(glyph, SEG_F, 3) | REMAP_SEG(glyph, SEG_G, 2) | \
+											REMAP_SEG(glyph, SEG_B, 1) | REMAP_SEG(glyph, SEG_A, 0))
+
+/* Font characters, digits first so BCD nibbles can be used as index */
+enum FONT_CHARS
+{
+	CHAR_0 = 0, CHAR_1, CHAR_2, CHAR_3, CHAR_4,
+	CHAR_5, CHAR_6, CHAR_7, CHAR_8, CHAR_9,
+	CHAR_A, CHAR_b, CHAR_C, CHAR_c, CHAR_d, CHAR_E, CHAR_F, CHAR_G,
+	CHAR_H, CHAR_h, CHAR_I, CHAR_J, CHAR_L, CHAR_n, CHAR_o, CHAR_P,
+	CHAR_r, CHAR_S, CHAR_t, CHAR_U, CHAR_u, CHAR_y,
+	CHAR_MINUS, CHAR_UNDERSCORE, CHAR_DEGREE, CHAR_BLANK,
+	NUM_OF_FONT_CHARS
+};
+
+/* Font table initializer for given configuration, same order as FONT_CHARS */
+#define FONT_TABLE(MAP)	{	MAP(GLYPH_0), MAP(GLYPH_1), MAP(GLYPH_2), MAP(GLYPH_3), MAP(GLYPH_4), \
+							MAP(GLYPH_5), MAP(GLYPH_6), MAP(GLYPH_7), MAP(GLYPH_8), MAP(GLYPH_9), \
+							MAP(GLYPH_A), MAP(GLYPH_b), MAP(GLYPH_C), MAP(GLYPH_c), MAP(GLYPH_d), MAP(GLYPH_E), MAP(GLYPH_F), MAP(GLYPH_G), \
+							MAP(GLYPH_H), MAP(GLYPH_h), MAP(GLYPH_I), MAP(GLYPH_J), MAP(GLYPH_L), MAP(GLYPH_n), MAP(GLYPH_o), MAP(GLYPH_P), \
+							MAP(GLYPH_r), MAP(GLYPH_S), MAP(GLYPH_t), MAP(GLYPH_U), MAP(GLYPH_u), MAP(GLYPH_y), \
+							MAP(GLYPH_MINUS), MAP(GLYPH_UNDERSCORE), MAP(GLYPH_DEGREE), MAP(GLYPH_BLANK) }
+
+#endif /* SEG_FONT_H_ */
@@ -53,6 +53,9 @@ void PendSV_Handler(void);
 void SysTick_Handler(void);
 void TIM14_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA1_Channel2_3_IRQHandler(void);
+void EXTI4_15_IRQHandler(void);
+void I2C1_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -23,6 +23,9 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "../Clock/clock.h"
+#include "../Clock/display_drv.h"
+#include "../Clock/rtc_sync.h"
+#include "../Clock/i2c_drv.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -156,4 +159,28 @@ void TIM14_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles DMA1 channel 2 and 3 interrupts.
+  */
+void DMA1_Channel2_3_IRQHandler(void)
+{
+	Display_DMA_IRQ_handler();
+}
+
+/**
+  * @brief This function handles EXTI line 4 to 15 interrupts.
+  */
+void EXTI4_15_IRQHandler(void)
+{
+	RTC_SQW_IRQ_handler();
+}
+
+/**
+  * @brief This function handles I2C1 event and error interrupts.
+  */
+void I2C1_IRQHandler(void)
+{
+	I2C_IRQ_handler();
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,194 @@
+/*
+ * bench_crc.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* Table-driven OneWire_CRC8 against the bit loop it replaced, same results, cost per byte */
+
+#include "test_common.h"
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../Clock/common_defs.h"
+#include "../Clock/onewire_bridge_drv.h"
+
+/* DS18B20 scratchpad without its CRC byte */
+#define FRAME_SIZE					8
+#define NUM_OF_FRAMES				4096
+#define NUM_OF_ROUNDS				64
+#define NUM_OF_RUNS					5
+
+/* Old DS18B20_calculate_CRC */
+#define DS18B20_CRC_INIT_VALUE		0x00
+#define DS18B20_CRC_MSB_MASK		0x01
+#define DS18B20_CRC_POLYNOMIAL		0x8C	// Polynomial x^8 + x^5 + x^4 + 1 (0x31 reversed)
+
+static uint8_t frames[NUM_OF_FRAMES][FRAME_SIZE];
+static volatile uint8_t crc_sink;
+
+/* Not inlined, driver function is called across files too */
+__attribute__((noinline)) static uint8_t Bit_loop_CRC8(const uint8_t *data, uint8_t len)
+{
+	uint8_t crc = DS18B20_CRC_INIT_VALUE;
+
+	for(uint8_t i = 0; i < len; i++)
+	{
+		uint8_t inbyte = data[i];
+
+		for(uint8_t j = 0; j < 8; j++)
+		{
+			if((crc ^ inbyte) & DS18B20_CRC_MSB_MASK)
+			{
+				crc = (crc >> 1) ^ DS18B20_CRC_POLYNOMIAL;
+			}
+			else
+			{
+				crc >>= 1;
+			}
+
+			inbyte >>= 1;
+		}
+	}
+
+	return crc;
+}
+
+static uint64_t Now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000U) + ts.tv_nsec;
+#endif
+}
+
+/* Best of runs, per byte */
+static double Cost_per_byte(uint8_t (*crc8)(const uint8_t *data, uint8_t len))
+{
+	uint64_t best = UINT64_MAX;
+
+	for(uint32_t run = 0; run < NUM_OF_RUNS; run++)
+	{
+		uint64_t start = Now();
+
+		for(uint32_t round = 0; round < NUM_OF_ROUNDS; round++)
+		{
+			for(uint32_t i = 0; i < NUM_OF_FRAMES; i++)
+			{
+				crc_sink = crc8(frames[i], FRAME_SIZE);
+			}
+		}
+
+		uint64_t elapsed = Now() - start;
+
+		if(elapsed < best)
+		{
+			best = elapsed;
+		}
+	}
+
+	return (double)best / ((double)NUM_OF_ROUNDS * NUM_OF_FRAMES * FRAME_SIZE);
+}
+
+static void Same_results(const void *arg)
+{
+	uint32_t mismatches = 0;
+	uint8_t byte;
+
+	/* Every single byte, from zero CRC */
+	for(uint32_t value = 0; value < 256; value++)
+	{
+		byte = (uint8_t)value;
+
+		if(OneWire_CRC8(&byte, 1) != Bit_loop_CRC8(&byte, 1))
+		{
+			mismatches++;
+		}
+	}
+
+	/* Random frames, all lengths up to a scratchpad */
+	for(uint32_t i = 0; i < NUM_OF_FRAMES; i++)
+	{
+		for(uint8_t len = 0; len <= FRAME_SIZE; len++)
+		{
+			if(OneWire_CRC8(frames[i], len) != Bit_loop_CRC8(frames[i], len))
+			{
+				mismatches++;
+			}
+		}
+	}
+
+	CHECK_EQUAL(mismatches, 0);
+}
+
+static void ROM_codes(const void *arg)
+{
+	/* Application note 27 example, family code first */
+	uint8_t rom[ONEWIRE_ROM_SIZE] = {0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2};
+	uint8_t shorted[ONEWIRE_ROM_SIZE] = {0};
+
+	CHECK_EQUAL(OneWire_CRC8(rom, ONEWIRE_ROM_SIZE - 1), 0xA2);
+	CHECK(Is_OneWire_ROM_valid(rom) == TRUE);
+
+	/* Any single bit error is caught */
+	for(uint8_t bit = 0; bit < (ONEWIRE_ROM_SIZE * 8); bit++)
+	{
+		rom[bit >> 3] ^= 1 << (bit & 0x07);
+
+		CHECK(Is_OneWire_ROM_valid(rom) == FALSE);
+
+		rom[bit >> 3] ^= 1 << (bit & 0x07);
+	}
+
+	/* CRC of zeros is zero, shorted bus must not pass */
+	CHECK(Is_OneWire_ROM_valid(shorted) == FALSE);
+}
+
+static void Cost(const void *arg)
+{
+	double bit_loop = Cost_per_byte(Bit_loop_CRC8);
+	double table = Cost_per_byte(OneWire_CRC8);
+
+#if defined(__x86_64__) || defined(__i386__)
+	const char *unit = "TSC cycles";
+#else
+	const char *unit = "ns";
+#endif
+
+	printf("  bit loop: %.2f %s/byte\n", bit_loop, unit);
+	printf("  %s table: %.2f %s/byte, %.1fx\n", (ONEWIRE_CRC8_FULL_TABLE == TRUE) ? "256 byte" : "16+16 byte",
+			table, unit, bit_loop / table);
+
+	/* Timing is only reported, host load would make a limit flaky */
+	CHECK(table > 0.0);
+}
+
+int main(void)
+{
+	/* Same frames in each case */
+	srand(1);
+
+	for(uint32_t i = 0; i < NUM_OF_FRAMES; i++)
+	{
+		for(uint8_t j = 0; j < FRAME_SIZE; j++)
+		{
+			frames[i][j] = (uint8_t)rand();
+		}
+	}
+
+	Test_isolated("same results", Same_results, NULL);
+	Test_isolated("ROM codes", ROM_codes, NULL);
+	Test_isolated("cost", Cost, NULL);
+
+	return Test_summary("bench_crc");
+}
@@ -0,0 +1,217 @@
+/*
+ * bench_display.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* BCD nibbles straight to segments against the old BCD2BIN, / 10 and % 10 path, same segments, cost per frame */
+
+#include "test_common.h"
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* Static helpers are measured as built into the driver */
+#include "../Clock/display_drv.c"
+
+/* Hour, minute, second, date, month, year */
+#define NUM_OF_FIELDS				6
+#define NUM_OF_FRAMES				4096
+#define NUM_OF_ROUNDS				64
+#define NUM_OF_RUNS					5
+
+static uint8_t frames[NUM_OF_FRAMES][NUM_OF_FIELDS];
+static uint8_t segments[NUM_OF_FIELDS * 2];
+
+/* Divisor the compiler cannot fold, Cortex-M0 has no divide instruction and calls __aeabi_uidivmod for any */
+static volatile uint8_t runtime_ten = 10;
+
+/* Old Uint8_to_two_7segments_with_blanking */
+inline static void Old_with_blanking(uint8_t val, uint8_t ten, uint8_t *first_digit, uint8_t *second_digit, const uint8_t *seg_table)
+{
+	if(val > 99)
+	{
+		val = 99;
+	}
+
+	if(val >= 10)
+	{
+		*first_digit	= seg_table[val / ten];
+		*second_digit	= seg_table[val % ten];
+	}
+	else
+	{
+		*first_digit	= BLANK_DISP;
+		*second_digit	= seg_table[val];
+	}
+}
+
+/* Old Uint8_to_two_7segments_without_blanking */
+inline static void Old_without_blanking(uint8_t val, uint8_t ten, uint8_t *first_digit, uint8_t *second_digit, const uint8_t *seg_table)
+{
+	if(val > 99)
+	{
+		val = 99;
+	}
+
+	*first_digit	= seg_table[val / ten];
+	*second_digit	= seg_table[val % ten];
+}
+
+/* Registers were converted to binary when read, then split into digits for display */
+inline static void Old_frame(const uint8_t *bcd, uint8_t ten, uint8_t *seg)
+{
+	Old_with_blanking(BCD2BIN(bcd[0]),		ten, &seg[0], &seg[1], seg_table_hour);
+	Old_without_blanking(BCD2BIN(bcd[1]),	ten, &seg[2], &seg[3], seg_table_hour);
+	Old_without_blanking(BCD2BIN(bcd[2]),	ten, &seg[4], &seg[5], seg_table_hour);
+	Old_with_blanking(BCD2BIN(bcd[3]),		ten, &seg[6], &seg[7], seg_table_date_temperature);
+	Old_without_blanking(BCD2BIN(bcd[4]),	ten, &seg[8], &seg[9], seg_table_date_temperature);
+	Old_without_blanking(BCD2BIN(bcd[5]),	ten, &seg[10], &seg[11], seg_table_date_temperature);
+}
+
+/* Not inlined, as the conversion is called once per update */
+__attribute__((noinline)) static void Old_constant_divide(const uint8_t *bcd, uint8_t *seg)
+{
+	Old_frame(bcd, 10, seg);
+}
+
+__attribute__((noinline)) static void Old_runtime_divide(const uint8_t *bcd, uint8_t *seg)
+{
+	Old_frame(bcd, runtime_ten, seg);
+}
+
+__attribute__((noinline)) static void New_nibbles(const uint8_t *bcd, uint8_t *seg)
+{
+	BCD_to_two_7segments_with_blanking(bcd[0],		&seg[0], &seg[1], seg_table_hour);
+	BCD_to_two_7segments_without_blanking(bcd[1],	&seg[2], &seg[3], seg_table_hour);
+	BCD_to_two_7segments_without_blanking(bcd[2],	&seg[4], &seg[5], seg_table_hour);
+	BCD_to_two_7segments_with_blanking(bcd[3],		&seg[6], &seg[7], seg_table_date_temperature);
+	BCD_to_two_7segments_without_blanking(bcd[4],	&seg[8], &seg[9], seg_table_date_temperature);
+	BCD_to_two_7segments_without_blanking(bcd[5],	&seg[10], &seg[11], seg_table_date_temperature);
+}
+
+/* DEC2BCD takes its argument more than once */
+static uint8_t Random_BCD(uint8_t min, uint8_t max)
+{
+	uint8_t val = min + (rand() % (max - min + 1));
+
+	return DEC2BCD(val);
+}
+
+static uint64_t Now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000U) + ts.tv_nsec;
+#endif
+}
+
+/* Best of runs, per frame */
+static double Cost_per_frame(void (*convert)(const uint8_t *bcd, uint8_t *seg))
+{
+	uint64_t best = UINT64_MAX;
+
+	for(uint32_t run = 0; run < NUM_OF_RUNS; run++)
+	{
+		uint64_t start = Now();
+
+		for(uint32_t round = 0; round < NUM_OF_ROUNDS; round++)
+		{
+			for(uint32_t i = 0; i < NUM_OF_FRAMES; i++)
+			{
+				convert(frames[i], segments);
+			}
+		}
+
+		uint64_t elapsed = Now() - start;
+
+		if(elapsed < best)
+		{
+			best = elapsed;
+		}
+	}
+
+	return (double)best / ((double)NUM_OF_ROUNDS * NUM_OF_FRAMES);
+}
+
+static void Same_segments(const void *arg)
+{
+	uint8_t old_seg[NUM_OF_FIELDS * 2];
+	uint8_t new_seg[NUM_OF_FIELDS * 2];
+	uint32_t mismatches = 0;
+
+	/* Every valid BCD value in every field */
+	for(uint8_t val = 0; val <= 99; val++)
+	{
+		uint8_t bcd[NUM_OF_FIELDS];
+
+		for(uint8_t f = 0; f < NUM_OF_FIELDS; f++)
+		{
+			bcd[f] = DEC2BCD(val);
+		}
+
+		Old_runtime_divide(bcd, old_seg);
+		New_nibbles(bcd, new_seg);
+
+		for(uint8_t i = 0; i < (NUM_OF_FIELDS * 2); i++)
+		{
+			if(old_seg[i] != new_seg[i])
+			{
+				printf("  %u, byte %u: 0x%02X, expected 0x%02X\n", val, i, new_seg[i], old_seg[i]);
+				mismatches++;
+			}
+		}
+	}
+
+	CHECK_EQUAL(mismatches, 0);
+}
+
+static void Cost(const void *arg)
+{
+	double old_constant = Cost_per_frame(Old_constant_divide);
+	double old_runtime = Cost_per_frame(Old_runtime_divide);
+	double new_nibbles = Cost_per_frame(New_nibbles);
+
+#if defined(__x86_64__) || defined(__i386__)
+	const char *unit = "TSC cycles";
+#else
+	const char *unit = "ns";
+#endif
+
+	printf("  BCD2BIN, / 10 and %% 10: %.2f %s/frame, %.2f with runtime divide\n", old_constant, unit, old_runtime);
+	printf("  BCD nibbles: %.2f %s/frame, %.1fx, %.1fx\n", new_nibbles, unit,
+			old_constant / new_nibbles, old_runtime / new_nibbles);
+
+	/* Timing is only reported, host load would make a limit flaky */
+	CHECK(new_nibbles > 0.0);
+}
+
+int main(void)
+{
+	/* Same frames in each case, valid BCD time and date */
+	srand(1);
+
+	for(uint32_t i = 0; i < NUM_OF_FRAMES; i++)
+	{
+		frames[i][0] = Random_BCD(0, 23);
+		frames[i][1] = Random_BCD(0, 59);
+		frames[i][2] = Random_BCD(0, 59);
+		frames[i][3] = Random_BCD(1, 31);
+		frames[i][4] = Random_BCD(1, 12);
+		frames[i][5] = Random_BCD(0, 99);
+	}
+
+	Test_isolated("same segments", Same_segments, NULL);
+	Test_isolated("cost", Cost, NULL);
+
+	return Test_summary("bench_display");
+}
@@ -0,0 +1,18 @@
+/*
+ * config_overdrive.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* Overdrive is off by default, force-included to build the 1-Wire tests again with it on */
+
+#ifndef CONFIG_OVERDRIVE_H_
+#define CONFIG_OVERDRIVE_H_
+
+#include "../Clock/common_defs.h"
+
+#undef EXT_TEMP_OVERDRIVE_ENABLED
+#define EXT_TEMP_OVERDRIVE_ENABLED		TRUE
+
+#endif /* CONFIG_OVERDRIVE_H_ */
@@ -0,0 +1,18 @@
+/*
+ * config_sqw.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* Square wave is off by default, force-included to build the RTC tests again with it on */
+
+#ifndef CONFIG_SQW_H_
+#define CONFIG_SQW_H_
+
+#include "../Clock/common_defs.h"
+
+#undef RTC_SQW_ENABLED
+#define RTC_SQW_ENABLED					TRUE
+
+#endif /* CONFIG_SQW_H_ */
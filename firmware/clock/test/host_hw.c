@@ -0,0 +1,312 @@
+/*
+ * host_hw.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#include "host_hw.h"
+
+#include "../Clock/common_defs.h"
+#include "../Clock/common_fcns.h"
+
+#include "../Clock/scheduler.h"
+#include "../Clock/display_drv.h"
+
+/* Sites reading SysTick, each sees COUNTFLAG once per millisecond */
+#define HOST_MAX_TICK_SITES			64
+
+#define HOST_MAX_MODELS				4
+
+uint32_t SystemCoreClock = HOST_CORE_CLOCK;
+
+I2C_TypeDef host_i2c1 = {1};
+DMA_TypeDef host_dma1 = {1};
+GPIO_TypeDef host_gpioa = {1};
+TIM_TypeDef host_tim14 = {14};
+SPI_TypeDef host_spi1 = {1};
+
+volatile uint8_t host_display_busy = FALSE;
+volatile uint8_t host_dma_claimed = FALSE;
+volatile uint32_t host_exti_pending = 0;
+
+static uint64_t host_cycles = 0;
+
+static void (*host_models[HOST_MAX_MODELS])(void);
+static uint8_t host_num_of_models = 0;
+static uint8_t host_models_running = FALSE;
+
+static uint8_t host_primask = FALSE;
+static uint8_t host_irq_depth = 0;
+
+static SysTick_Type host_systick;
+
+struct host_tick_site_struct
+{
+	void *site;
+	uint64_t last_ms;
+};
+
+static struct host_tick_site_struct host_tick_sites[HOST_MAX_TICK_SITES];
+static uint8_t host_num_of_tick_sites = 0;
+
+/* External definitions of inline helpers, for calls not inlined */
+extern inline void Inc_value(volatile uint8_t *val, uint8_t max);
+extern inline void Dec_value(volatile uint8_t *val, uint8_t min);
+extern inline void Inc_value_with_rewind(volatile uint8_t *val, uint8_t min, uint8_t max);
+extern inline void Dec_value_with_rewind(volatile uint8_t *val, uint8_t min, uint8_t max);
+extern inline void Inc_BCD_value_with_rewind(volatile uint8_t *val, uint8_t min, uint8_t max);
+extern inline void Dec_BCD_value_with_rewind(volatile uint8_t *val, uint8_t min, uint8_t max);
+
+static void Host_run_models(void)
+{
+	/* Models may access registers too, no recursion */
+	if(host_models_running == TRUE)
+	{
+		return;
+	}
+
+	host_models_running = TRUE;
+
+	for(uint8_t i = 0; i < host_num_of_models; i++)
+	{
+		host_models[i]();
+	}
+
+	host_models_running = FALSE;
+}
+
+static void Host_access(void)
+{
+	host_cycles += HOST_ACCESS_CYCLES;
+
+	Host_run_models();
+}
+
+uint64_t Host_get_cycles(void)
+{
+	return host_cycles;
+}
+
+void Host_run_until(uint64_t cycles)
+{
+	if(host_num_of_models == 0)
+	{
+		/* Nothing to advance on the way */
+		if(host_cycles < cycles)
+		{
+			host_cycles = cycles;
+		}
+
+		return;
+	}
+
+	while(host_cycles < cycles)
+	{
+		/* Microsecond steps, finer than any bus event */
+		uint64_t step = cycles - host_cycles;
+
+		host_cycles += (step < (HOST_CORE_CLOCK / 1000000U)) ? step : (HOST_CORE_CLOCK / 1000000U);
+
+		Host_run_models();
+	}
+}
+
+void Host_run_cycles(uint64_t cycles)
+{
+	Host_run_until(host_cycles + cycles);
+}
+
+void Host_run_us(uint32_t us)
+{
+	Host_run_cycles((uint64_t)us * (HOST_CORE_CLOCK / 1000000U));
+}
+
+void Host_add_model(void (*step)(void))
+{
+	if(host_num_of_models < HOST_MAX_MODELS)
+	{
+		host_models[host_num_of_models++] = step;
+	}
+}
+
+uint8_t Host_is_irq_allowed(void)
+{
+	/* Single priority level, no nesting */
+	return ((host_primask == FALSE) && (host_irq_depth == 0)) ? TRUE : FALSE;
+}
+
+uint8_t Host_is_in_irq(void)
+{
+	return (host_irq_depth > 0) ? TRUE : FALSE;
+}
+
+void Host_enter_irq(void)
+{
+	host_irq_depth++;
+}
+
+void Host_exit_irq(void)
+{
+	host_irq_depth--;
+}
+
+void Host_disable_irq(void)
+{
+	host_primask = TRUE;
+}
+
+void Host_enable_irq(void)
+{
+	host_primask = FALSE;
+
+	/* Pending interrupts are taken right away */
+	Host_run_models();
+}
+
+uint32_t __get_PRIMASK(void)
+{
+	return host_primask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+	if(primask == FALSE)
+	{
+		Host_enable_irq();
+	}
+	else
+	{
+		Host_disable_irq();
+	}
+}
+
+SysTick_Type *Host_SysTick(void)
+{
+	void *site = __builtin_return_address(0);
+	uint64_t ms;
+	uint8_t i;
+
+	Host_access();
+
+	ms = host_cycles / HOST_CYCLES_PER_MS;
+
+	/* Down-counting, reloads every millisecond */
+	host_systick.LOAD = HOST_CYCLES_PER_MS - 1;
+	host_systick.VAL = host_systick.LOAD - (uint32_t)(host_cycles % HOST_CYCLES_PER_MS);
+	host_systick.CTRL = 0x5;
+
+	/* COUNTFLAG clears on read, target has one reader of it per loop */
+	for(i = 0; i < host_num_of_tick_sites; i++)
+	{
+		if(host_tick_sites[i].site == site)
+		{
+			break;
+		}
+	}
+
+	if(i == host_num_of_tick_sites)
+	{
+		if(host_num_of_tick_sites < HOST_MAX_TICK_SITES)
+		{
+			host_tick_sites[host_num_of_tick_sites].site = site;
+			host_tick_sites[host_num_of_tick_sites].last_ms = ms;
+			host_num_of_tick_sites++;
+		}
+
+		return &host_systick;
+	}
+
+	if(host_tick_sites[i].last_ms != ms)
+	{
+		host_tick_sites[i].last_ms = ms;
+		host_systick.CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+	}
+
+	return &host_systick;
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+	(void)irq;
+	(void)priority;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+	(void)irq;
+}
+
+void LL_AHB1_GRP1_EnableClock(uint32_t periphs)
+{
+	(void)periphs;
+}
+
+uint32_t LL_TIM_GetAutoReload(TIM_TypeDef *tim)
+{
+	(void)tim;
+
+	return (SCHEDULER_TIMER_FREQUENCY / UPDATE_FREQUENCY) - 1;
+}
+
+void LL_SYSCFG_SetEXTISource(uint32_t port, uint32_t line)
+{
+	(void)port;
+	(void)line;
+}
+
+void LL_EXTI_EnableFallingTrig_0_31(uint32_t lines)
+{
+	(void)lines;
+}
+
+void LL_EXTI_EnableIT_0_31(uint32_t lines)
+{
+	(void)lines;
+}
+
+void LL_EXTI_ClearFlag_0_31(uint32_t lines)
+{
+	host_exti_pending &= ~lines;
+}
+
+uint32_t LL_EXTI_IsActiveFlag_0_31(uint32_t lines)
+{
+	return ((host_exti_pending & lines) == lines) ? 1U : 0U;
+}
+
+/* Scheduler, TIM14 counts derived from core cycles */
+uint32_t Get_scheduler_time(void)
+{
+	Host_access();
+
+	return (uint32_t)(host_cycles / HOST_CYCLES_PER_COUNT);
+}
+
+uint32_t Get_scheduler_tick(void)
+{
+	return (uint32_t)(host_cycles / (HOST_CYCLES_PER_COUNT * (SCHEDULER_TIMER_FREQUENCY / UPDATE_FREQUENCY)));
+}
+
+/* Display, only its claim on the DMA channels, replaced by the driver in display tests */
+__attribute__((weak)) uint8_t Is_display_busy(void)
+{
+	return host_display_busy;
+}
+
+__attribute__((weak)) uint8_t Claim_display_DMA(void)
+{
+	if((host_display_busy == TRUE) || (host_dma_claimed == TRUE))
+	{
+		return FALSE;
+	}
+
+	host_dma_claimed = TRUE;
+
+	return TRUE;
+}
+
+__attribute__((weak)) void Release_display_DMA(void)
+{
+	host_dma_claimed = FALSE;
+}
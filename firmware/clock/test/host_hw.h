@@ -0,0 +1,228 @@
+/*
+ * host_hw.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* Stands in for main.h when drivers are built on the host, force-included */
+
+#ifndef HOST_HW_H_
+#define HOST_HW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* From main.h */
+#define UPDATE_FREQUENCY 32
+
+#define UNUSED_1_Pin LL_GPIO_PIN_4
+#define UNUSED_1_GPIO_Port GPIOA
+#define LED_CS_Pin LL_GPIO_PIN_6
+#define LED_CS_GPIO_Port GPIOA
+
+/* Simulated core clock, as on target */
+#define HOST_CORE_CLOCK				16000000U
+#define HOST_CYCLES_PER_MS			(HOST_CORE_CLOCK / 1000U)
+#define HOST_CYCLES_PER_COUNT		(HOST_CORE_CLOCK / 100000U)		/* TIM14 runs at 100kHz */
+
+/* Every access to a simulated register takes this long */
+#define HOST_ACCESS_CYCLES			4
+
+extern uint32_t SystemCoreClock;
+
+/* Peripheral handles, only identify the instance */
+typedef struct { uint32_t id; } I2C_TypeDef;
+typedef struct { uint32_t id; } DMA_TypeDef;
+typedef struct { uint32_t id; } GPIO_TypeDef;
+typedef struct { uint32_t id; } TIM_TypeDef;
+typedef struct { uint32_t id; } SPI_TypeDef;
+
+extern I2C_TypeDef host_i2c1;
+extern DMA_TypeDef host_dma1;
+extern GPIO_TypeDef host_gpioa;
+extern TIM_TypeDef host_tim14;
+extern SPI_TypeDef host_spi1;
+
+#define I2C1						(&host_i2c1)
+#define DMA1						(&host_dma1)
+#define GPIOA						(&host_gpioa)
+#define TIM14						(&host_tim14)
+#define SPI1						(&host_spi1)
+
+/* SysTick, every access advances simulated time */
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t LOAD;
+	volatile uint32_t VAL;
+	volatile uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick_CTRL_COUNTFLAG_Msk	(1UL << 16U)
+
+SysTick_Type *Host_SysTick(void);
+#define SysTick						(Host_SysTick())
+
+/* Interrupts */
+typedef enum
+{
+	EXTI4_15_IRQn = 7,
+	DMA1_Channel2_3_IRQn = 10,
+	TIM14_IRQn = 19,
+	I2C1_IRQn = 23,
+	SPI1_IRQn = 25
+} IRQn_Type;
+
+void Host_disable_irq(void);
+void Host_enable_irq(void);
+#define __disable_irq()				Host_disable_irq()
+#define __enable_irq()				Host_enable_irq()
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+void NVIC_EnableIRQ(IRQn_Type irq);
+
+/* RCC */
+#define LL_AHB1_GRP1_PERIPH_DMA1	(1UL << 0U)
+
+void LL_AHB1_GRP1_EnableClock(uint32_t periphs);
+
+/* TIM */
+uint32_t LL_TIM_GetAutoReload(TIM_TypeDef *tim);
+
+/* EXTI and SYSCFG */
+#define LL_EXTI_LINE_4				(1UL << 4U)
+#define LL_SYSCFG_EXTI_PORTA		0U
+#define LL_SYSCFG_EXTI_LINE4		((0x0000FU << 16U) | 1U)
+#define LL_SYSCFG_I2C_FASTMODEPLUS_PA9	(1UL << 22U)
+#define LL_SYSCFG_I2C_FASTMODEPLUS_PA10	(1UL << 23U)
+
+void LL_SYSCFG_SetEXTISource(uint32_t port, uint32_t line);
+void LL_SYSCFG_EnableFastModePlus(uint32_t mask);
+void LL_SYSCFG_DisableFastModePlus(uint32_t mask);
+void LL_EXTI_EnableFallingTrig_0_31(uint32_t lines);
+void LL_EXTI_EnableIT_0_31(uint32_t lines);
+void LL_EXTI_ClearFlag_0_31(uint32_t lines);
+uint32_t LL_EXTI_IsActiveFlag_0_31(uint32_t lines);
+
+/* GPIO */
+#define LL_GPIO_PIN_4				(1UL << 4U)
+#define LL_GPIO_PIN_6				(1UL << 6U)
+#define LL_GPIO_PIN_9				(1UL << 9U)
+#define LL_GPIO_PIN_10				(1UL << 10U)
+#define LL_GPIO_MODE_INPUT			0U
+#define LL_GPIO_MODE_OUTPUT			1U
+#define LL_GPIO_MODE_ALTERNATE		2U
+
+void LL_GPIO_SetOutputPin(GPIO_TypeDef *port, uint32_t pins);
+void LL_GPIO_ResetOutputPin(GPIO_TypeDef *port, uint32_t pins);
+void LL_GPIO_SetPinMode(GPIO_TypeDef *port, uint32_t pin, uint32_t mode);
+uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef *port, uint32_t pins);
+
+/* DMA */
+#define LL_DMA_CHANNEL_2			2U
+#define LL_DMA_CHANNEL_3			3U
+#define LL_DMA_DIRECTION_PERIPH_TO_MEMORY	0x00000000U
+#define LL_DMA_DIRECTION_MEMORY_TO_PERIPH	0x00000010U
+#define LL_DMA_DIRECTION_MEMORY_TO_MEMORY	0x00004000U
+#define LL_DMA_MODE_NORMAL			0x00000000U
+#define LL_DMA_PERIPH_NOINCREMENT	0x00000000U
+#define LL_DMA_MEMORY_NOINCREMENT	0x00000000U
+#define LL_DMA_MEMORY_INCREMENT		0x00000080U
+#define LL_DMA_PDATAALIGN_BYTE		0x00000000U
+#define LL_DMA_MDATAALIGN_BYTE		0x00000000U
+#define LL_DMA_PRIORITY_LOW			0x00000000U
+
+void LL_DMA_ConfigTransfer(DMA_TypeDef *dma, uint32_t channel, uint32_t configuration);
+void LL_DMA_ConfigAddresses(DMA_TypeDef *dma, uint32_t channel, uint32_t src_address, uint32_t dst_address, uint32_t direction);
+void LL_DMA_SetMemoryAddress(DMA_TypeDef *dma, uint32_t channel, uint32_t address);
+void LL_DMA_SetPeriphAddress(DMA_TypeDef *dma, uint32_t channel, uint32_t address);
+void LL_DMA_SetDataLength(DMA_TypeDef *dma, uint32_t channel, uint32_t length);
+uint32_t LL_DMA_GetDataLength(DMA_TypeDef *dma, uint32_t channel);
+void LL_DMA_EnableChannel(DMA_TypeDef *dma, uint32_t channel);
+void LL_DMA_DisableChannel(DMA_TypeDef *dma, uint32_t channel);
+void LL_DMA_EnableIT_TC(DMA_TypeDef *dma, uint32_t channel);
+void LL_DMA_DisableIT_TC(DMA_TypeDef *dma, uint32_t channel);
+uint32_t LL_DMA_IsActiveFlag_TC2(DMA_TypeDef *dma);
+void LL_DMA_ClearFlag_GI2(DMA_TypeDef *dma);
+void LL_DMA_ClearFlag_GI3(DMA_TypeDef *dma);
+
+/* SPI */
+void LL_SPI_Enable(SPI_TypeDef *spi);
+void LL_SPI_EnableDMAReq_RX(SPI_TypeDef *spi);
+void LL_SPI_DisableDMAReq_RX(SPI_TypeDef *spi);
+void LL_SPI_EnableDMAReq_TX(SPI_TypeDef *spi);
+void LL_SPI_DisableDMAReq_TX(SPI_TypeDef *spi);
+uint32_t LL_SPI_DMA_GetRegAddr(SPI_TypeDef *spi);
+
+/* I2C */
+#define LL_I2C_ADDRSLAVE_7BIT		0x00000000U
+#define LL_I2C_MODE_AUTOEND			(1UL << 25U)
+#define LL_I2C_MODE_SOFTEND			0x00000000U
+#define LL_I2C_GENERATE_START_WRITE	(0x80000000U | (1UL << 13U))
+#define LL_I2C_GENERATE_START_READ	(0x80000000U | (1UL << 13U) | (1UL << 10U))
+#define LL_I2C_DMA_REG_DATA_TRANSMIT	0U
+#define LL_I2C_DMA_REG_DATA_RECEIVE		1U
+
+void LL_I2C_Enable(I2C_TypeDef *i2c);
+void LL_I2C_Disable(I2C_TypeDef *i2c);
+uint32_t LL_I2C_IsEnabled(I2C_TypeDef *i2c);
+void LL_I2C_SetTiming(I2C_TypeDef *i2c, uint32_t timing);
+
+void LL_I2C_EnableIT_TX(I2C_TypeDef *i2c);
+void LL_I2C_DisableIT_TX(I2C_TypeDef *i2c);
+void LL_I2C_EnableIT_RX(I2C_TypeDef *i2c);
+void LL_I2C_DisableIT_RX(I2C_TypeDef *i2c);
+void LL_I2C_EnableIT_TC(I2C_TypeDef *i2c);
+void LL_I2C_EnableIT_STOP(I2C_TypeDef *i2c);
+void LL_I2C_EnableIT_NACK(I2C_TypeDef *i2c);
+void LL_I2C_EnableIT_ERR(I2C_TypeDef *i2c);
+void LL_I2C_EnableDMAReq_TX(I2C_TypeDef *i2c);
+void LL_I2C_DisableDMAReq_TX(I2C_TypeDef *i2c);
+void LL_I2C_EnableDMAReq_RX(I2C_TypeDef *i2c);
+void LL_I2C_DisableDMAReq_RX(I2C_TypeDef *i2c);
+
+uint32_t LL_I2C_IsActiveFlag_TXE(I2C_TypeDef *i2c);
+uint32_t LL_I2C_IsActiveFlag_TXIS(I2C_TypeDef *i2c);
+uint32_t LL_I2C_IsActiveFlag_RXNE(I2C_TypeDef *i2c);
+uint32_t LL_I2C_IsActiveFlag_TC(I2C_TypeDef *i2c);
+uint32_t LL_I2C_IsActiveFlag_STOP(I2C_TypeDef *i2c);
+uint32_t LL_I2C_IsActiveFlag_NACK(I2C_TypeDef *i2c);
+uint32_t LL_I2C_IsActiveFlag_BERR(I2C_TypeDef *i2c);
+uint32_t LL_I2C_IsActiveFlag_ARLO(I2C_TypeDef *i2c);
+uint32_t LL_I2C_IsActiveFlag_OVR(I2C_TypeDef *i2c);
+void LL_I2C_ClearFlag_TXE(I2C_TypeDef *i2c);
+void LL_I2C_ClearFlag_STOP(I2C_TypeDef *i2c);
+void LL_I2C_ClearFlag_NACK(I2C_TypeDef *i2c);
+void LL_I2C_ClearFlag_BERR(I2C_TypeDef *i2c);
+void LL_I2C_ClearFlag_ARLO(I2C_TypeDef *i2c);
+void LL_I2C_ClearFlag_OVR(I2C_TypeDef *i2c);
+
+void LL_I2C_TransmitData8(I2C_TypeDef *i2c, uint8_t data);
+uint8_t LL_I2C_ReceiveData8(I2C_TypeDef *i2c);
+void LL_I2C_HandleTransfer(I2C_TypeDef *i2c, uint32_t slave_addr, uint32_t slave_addr_size,
+		uint32_t transfer_size, uint32_t end_mode, uint32_t request);
+uint32_t LL_I2C_DMA_GetRegAddr(I2C_TypeDef *i2c, uint32_t direction);
+
+/* Simulated time, in core cycles since start */
+uint64_t Host_get_cycles(void);
+void Host_run_cycles(uint64_t cycles);
+void Host_run_us(uint32_t us);
+void Host_run_until(uint64_t cycles);
+
+/* Peripheral models advanced with time, called also from register accesses */
+void Host_add_model(void (*step)(void));
+uint8_t Host_is_irq_allowed(void);
+uint8_t Host_is_in_irq(void);
+void Host_enter_irq(void);
+void Host_exit_irq(void);
+
+/* Target stubs, controlled by tests */
+extern volatile uint8_t host_display_busy;
+extern volatile uint8_t host_dma_claimed;
+extern volatile uint32_t host_exti_pending;
+
+#endif /* HOST_HW_H_ */
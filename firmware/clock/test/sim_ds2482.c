@@ -0,0 +1,729 @@
+/*
+ * sim_ds2482.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#include "sim_ds2482.h"
+
+#include <stddef.h>
+
+#include "../Clock/common_defs.h"
+
+#define SIM_DS2482_ADDR				0x30
+
+/* Commands */
+#define SIM_DS2482_DRST				0xF0
+#define SIM_DS2482_WCFG				0xD2
+#define SIM_DS2482_SRP				0xE1
+#define SIM_DS2482_1WRS				0xB4
+#define SIM_DS2482_1WWB				0xA5
+#define SIM_DS2482_1WRB				0x96
+#define SIM_DS2482_1WSB				0x87
+#define SIM_DS2482_1WT				0x78
+
+/* Read pointer codes */
+#define SIM_DS2482_PTR_STATUS		0xF0
+#define SIM_DS2482_PTR_DATA			0xE1
+#define SIM_DS2482_PTR_CONFIG		0xC3
+
+/* Status and configuration bits */
+#define SIM_DS2482_1WB				0x01
+#define SIM_DS2482_PPD				0x02
+#define SIM_DS2482_LL				0x08
+#define SIM_DS2482_RST				0x10
+#define SIM_DS2482_SBR				0x20
+#define SIM_DS2482_TSB				0x40
+#define SIM_DS2482_DIR				0x80
+#define SIM_DS2482_SPU				0x04
+#define SIM_DS2482_1WS				0x08
+
+/* 1-Wire timing of the bridge, standard and overdrive */
+#define SIM_DS2482_RESET_US			1148
+#define SIM_DS2482_RESET_US_OD		146
+#define SIM_DS2482_SLOT_US			73
+#define SIM_DS2482_SLOT_US_OD		11
+
+/* ROM and function commands */
+#define SIM_OW_SEARCH_ROM			0xF0
+#define SIM_OW_MATCH_ROM			0x55
+#define SIM_OW_SKIP_ROM				0xCC
+#define SIM_OW_OVERDRIVE_MATCH_ROM	0x69
+#define SIM_OW_CONVERT_T			0x44
+#define SIM_OW_WRITE_SCRATCHPAD		0x4E
+#define SIM_OW_READ_SCRATCHPAD		0xBE
+#define SIM_OW_READ_POWER_SUPPLY	0xB4
+
+#define SIM_OW_ROM_BITS				64
+#define SIM_OW_SCRATCHPAD_BITS		72
+#define SIM_OW_CONFIG_BITS			24
+
+/* Register after power-up, 85*C */
+#define SIM_DS18B20_POWER_ON_TEMP	0x0550
+
+/* Device answers from state it is in, until next reset */
+enum SIM_ONEWIRE_STATES
+{
+	SIM_OW_IDLE = 0,				/* Not selected */
+	SIM_OW_ROM_COMMAND,
+	SIM_OW_SEARCH,
+	SIM_OW_MATCH,
+	SIM_OW_FUNCTION_COMMAND,
+	SIM_OW_READ,					/* Scratchpad shifted out */
+	SIM_OW_WRITE,					/* TH, TL and configuration shifted in */
+	SIM_OW_POWER_SUPPLY,
+	SIM_OW_CONVERSION				/* Read slots show if still converting */
+};
+
+static uint8_t Sim_DS2482_start(uint8_t read);
+static uint8_t Sim_DS2482_write(uint8_t data);
+static uint8_t Sim_DS2482_read(void);
+static void Sim_DS2482_stop(void);
+static uint8_t Sim_DS2482_execute(uint8_t command, uint8_t parameter);
+static uint8_t Sim_OneWire_reset(void);
+static uint8_t Sim_OneWire_slot(uint8_t master_bit);
+static uint8_t Sim_OneWire_output(struct sim_onewire_device_struct *device);
+static void Sim_OneWire_input(struct sim_onewire_device_struct *device, uint8_t bit);
+static void Sim_OneWire_function(struct sim_onewire_device_struct *device, uint8_t command);
+static void Sim_OneWire_update(struct sim_onewire_device_struct *device);
+static void Sim_OneWire_end_strong_pullup(void);
+static uint8_t Is_sensor(const struct sim_onewire_device_struct *device);
+static uint8_t ROM_bit(const struct sim_onewire_device_struct *device, uint8_t bit);
+
+struct sim_i2c_slave_struct sim_ds2482 = {SIM_DS2482_ADDR, Sim_DS2482_start, Sim_DS2482_write, Sim_DS2482_read, Sim_DS2482_stop, 0, 0};
+
+uint32_t sim_onewire_resets = 0;
+uint32_t sim_onewire_triplets = 0;
+
+static struct sim_onewire_device_struct *onewire_devices[SIM_ONEWIRE_MAX_DEVICES];
+static uint8_t num_of_devices = 0;
+
+static uint8_t ds2482_pointer = SIM_DS2482_PTR_STATUS;
+static uint8_t ds2482_status = 0;
+static uint8_t ds2482_data = 0;
+static uint8_t ds2482_config = 0;
+static uint64_t ds2482_busy_end = 0;
+
+/* Command byte of a write, waiting for its parameter */
+static uint8_t ds2482_command = 0;
+static uint8_t ds2482_command_pending = FALSE;
+static uint8_t ds2482_first_byte = FALSE;
+
+/* Strong pull-up, from end of last written byte until next 1-Wire command */
+static uint8_t strong_pullup = FALSE;
+
+void Sim_DS2482_init(void)
+{
+	num_of_devices = 0;
+
+	ds2482_pointer = SIM_DS2482_PTR_STATUS;
+	ds2482_status = SIM_DS2482_RST | SIM_DS2482_LL;
+	ds2482_config = 0;
+	ds2482_busy_end = 0;
+	strong_pullup = FALSE;
+
+	Sim_I2C_add_slave(&sim_ds2482);
+}
+
+void Sim_OneWire_add_device(struct sim_onewire_device_struct *device, uint8_t family, uint32_t serial)
+{
+	device->rom[0] = family;
+
+	/* Serial number, least significant byte first, upper bytes zero */
+	for(uint8_t i = 1; i < 7; i++)
+	{
+		device->rom[i] = (i <= 4) ? (uint8_t)(serial >> ((i - 1) * 8)) : 0x00;
+	}
+
+	device->rom[7] = Sim_OneWire_CRC8(device->rom, 7);
+
+	if(device->eeprom_config == 0)
+	{
+		/* Factory setting */
+		device->eeprom_config = SIM_DS18B20_CONFIG(12);
+	}
+
+	Sim_OneWire_power_up(device);
+
+	if(num_of_devices < SIM_ONEWIRE_MAX_DEVICES)
+	{
+		onewire_devices[num_of_devices++] = device;
+	}
+}
+
+void Sim_OneWire_power_up(struct sim_onewire_device_struct *device)
+{
+	device->temperature_reg = SIM_DS18B20_POWER_ON_TEMP;
+	device->th = 0x4B;
+	device->tl = 0x46;
+	device->config = device->eeprom_config;
+
+	device->state = SIM_OW_IDLE;
+	device->overdrive = FALSE;
+	device->converting = FALSE;
+}
+
+uint8_t Sim_OneWire_CRC8(const uint8_t *data, uint8_t len)
+{
+	uint8_t crc = 0;
+
+	/* Bit by bit, as in datasheet, independent of driver tables */
+	for(uint8_t i = 0; i < len; i++)
+	{
+		uint8_t byte = data[i];
+
+		for(uint8_t bit = 0; bit < 8; bit++)
+		{
+			uint8_t mix = (crc ^ byte) & 0x01;
+
+			crc >>= 1;
+
+			if(mix)
+			{
+				crc ^= 0x8C;
+			}
+
+			byte >>= 1;
+		}
+	}
+
+	return crc;
+}
+
+static uint8_t Sim_DS2482_start(uint8_t read)
+{
+	if(read == FALSE)
+	{
+		ds2482_first_byte = TRUE;
+		ds2482_command_pending = FALSE;
+	}
+
+	return TRUE;
+}
+
+static uint8_t Sim_DS2482_write(uint8_t data)
+{
+	if(ds2482_first_byte == TRUE)
+	{
+		ds2482_first_byte = FALSE;
+
+		if((Host_get_cycles() < ds2482_busy_end) && (data != SIM_DS2482_DRST) && (data != SIM_DS2482_SRP))
+		{
+			/* Commands are not acknowledged during 1-Wire activity */
+			return FALSE;
+		}
+
+		switch(data)
+		{
+			case SIM_DS2482_WCFG:
+			case SIM_DS2482_SRP:
+			case SIM_DS2482_1WWB:
+			case SIM_DS2482_1WSB:
+			case SIM_DS2482_1WT:
+				/* Parameter byte follows */
+				ds2482_command = data;
+				ds2482_command_pending = TRUE;
+				return TRUE;
+
+			default:
+				return Sim_DS2482_execute(data, 0);
+		}
+	}
+
+	if(ds2482_command_pending == TRUE)
+	{
+		ds2482_command_pending = FALSE;
+
+		return Sim_DS2482_execute(ds2482_command, data);
+	}
+
+	/* Nothing expects more bytes */
+	return FALSE;
+}
+
+static uint8_t Sim_DS2482_read(void)
+{
+	switch(ds2482_pointer)
+	{
+		case SIM_DS2482_PTR_DATA:
+			return ds2482_data;
+
+		case SIM_DS2482_PTR_CONFIG:
+			/* Upper nibble reads as zero */
+			return ds2482_config;
+
+		default:
+			return (ds2482_status & ~SIM_DS2482_1WB) | ((Host_get_cycles() < ds2482_busy_end) ? SIM_DS2482_1WB : 0);
+	}
+}
+
+static void Sim_DS2482_stop(void)
+{
+}
+
+static uint8_t Sim_DS2482_execute(uint8_t command, uint8_t parameter)
+{
+	uint8_t overdrive = (ds2482_config & SIM_DS2482_1WS) ? TRUE : FALSE;
+	uint32_t bus_time = 0;
+
+	switch(command)
+	{
+		case SIM_DS2482_DRST:
+			/* Ends any 1-Wire activity, configuration cleared */
+			Sim_OneWire_end_strong_pullup();
+
+			ds2482_config = 0;
+			ds2482_status = SIM_DS2482_RST | SIM_DS2482_LL;
+			ds2482_busy_end = 0;
+			ds2482_pointer = SIM_DS2482_PTR_STATUS;
+			return TRUE;
+
+		case SIM_DS2482_WCFG:
+			if((uint8_t)(~parameter >> 4 & 0x0F) != (parameter & 0x0F))
+			{
+				/* Upper nibble must be complement of lower one */
+				return FALSE;
+			}
+
+			if(!(parameter & SIM_DS2482_SPU))
+			{
+				Sim_OneWire_end_strong_pullup();
+			}
+
+			ds2482_config = parameter & 0x0F;
+			ds2482_status &= ~SIM_DS2482_RST;
+			ds2482_pointer = SIM_DS2482_PTR_CONFIG;
+			return TRUE;
+
+		case SIM_DS2482_SRP:
+			if((parameter != SIM_DS2482_PTR_STATUS) && (parameter != SIM_DS2482_PTR_DATA) && (parameter != SIM_DS2482_PTR_CONFIG))
+			{
+				return FALSE;
+			}
+
+			ds2482_pointer = parameter;
+			return TRUE;
+
+		case SIM_DS2482_1WRS:
+			Sim_OneWire_end_strong_pullup();
+
+			ds2482_status = SIM_DS2482_LL | ((Sim_OneWire_reset() == TRUE) ? SIM_DS2482_PPD : 0);
+			bus_time = overdrive ? SIM_DS2482_RESET_US_OD : SIM_DS2482_RESET_US;
+			break;
+
+		case SIM_DS2482_1WWB:
+			Sim_OneWire_end_strong_pullup();
+
+			/* Pull-up takes over right after last bit, conversion is powered from start */
+			if(ds2482_config & SIM_DS2482_SPU)
+			{
+				strong_pullup = TRUE;
+			}
+
+			for(uint8_t bit = 0; bit < 8; bit++)
+			{
+				(void)Sim_OneWire_slot((parameter >> bit) & 0x01);
+			}
+
+			bus_time = 8 * (overdrive ? SIM_DS2482_SLOT_US_OD : SIM_DS2482_SLOT_US);
+			break;
+
+		case SIM_DS2482_1WRB:
+			Sim_OneWire_end_strong_pullup();
+
+			ds2482_data = 0;
+
+			for(uint8_t bit = 0; bit < 8; bit++)
+			{
+				ds2482_data |= Sim_OneWire_slot(1) << bit;
+			}
+
+			bus_time = 8 * (overdrive ? SIM_DS2482_SLOT_US_OD : SIM_DS2482_SLOT_US);
+			break;
+
+		case SIM_DS2482_1WSB:
+			Sim_OneWire_end_strong_pullup();
+
+			if(ds2482_config & SIM_DS2482_SPU)
+			{
+				strong_pullup = TRUE;
+			}
+
+			ds2482_status &= ~SIM_DS2482_SBR;
+			ds2482_status |= Sim_OneWire_slot((parameter & 0x80) ? 1 : 0) ? SIM_DS2482_SBR : 0;
+
+			bus_time = overdrive ? SIM_DS2482_SLOT_US_OD : SIM_DS2482_SLOT_US;
+			break;
+
+		case SIM_DS2482_1WT:
+		{
+			uint8_t id_bit;
+			uint8_t complement_bit;
+			uint8_t direction;
+
+			Sim_OneWire_end_strong_pullup();
+
+			sim_onewire_triplets++;
+
+			/* Two read slots, then write of the direction */
+			id_bit = Sim_OneWire_slot(1);
+			complement_bit = Sim_OneWire_slot(1);
+
+			if(id_bit != complement_bit)
+			{
+				direction = id_bit;
+			}
+			else if(id_bit == 0)
+			{
+				direction = (parameter & 0x80) ? 1 : 0;
+			}
+			else
+			{
+				/* Nobody answered */
+				direction = 1;
+			}
+
+			(void)Sim_OneWire_slot(direction);
+
+			ds2482_status &= ~(SIM_DS2482_SBR | SIM_DS2482_TSB | SIM_DS2482_DIR);
+			ds2482_status |= (id_bit ? SIM_DS2482_SBR : 0) | (complement_bit ? SIM_DS2482_TSB : 0) | (direction ? SIM_DS2482_DIR : 0);
+
+			bus_time = 3 * (overdrive ? SIM_DS2482_SLOT_US_OD : SIM_DS2482_SLOT_US);
+			break;
+		}
+
+		default:
+			/* Unknown command */
+			return FALSE;
+	}
+
+	/* 1-Wire command, status follows its progress */
+	ds2482_pointer = SIM_DS2482_PTR_STATUS;
+	ds2482_busy_end = Host_get_cycles() + ((uint64_t)bus_time * HOST_CYCLES_PER_MS) / 1000;
+
+	return TRUE;
+}
+
+static uint8_t Sim_OneWire_reset(void)
+{
+	uint8_t overdrive = (ds2482_config & SIM_DS2482_1WS) ? TRUE : FALSE;
+	uint8_t presence = FALSE;
+
+	sim_onewire_resets++;
+
+	for(uint8_t i = 0; i < num_of_devices; i++)
+	{
+		struct sim_onewire_device_struct *device = onewire_devices[i];
+
+		Sim_OneWire_update(device);
+
+		if(overdrive == FALSE)
+		{
+			/* Standard reset pulse returns everyone to standard speed */
+			device->overdrive = FALSE;
+		}
+		else if(device->overdrive == FALSE)
+		{
+			/* Overdrive pulse is too short to be a reset at standard speed */
+			continue;
+		}
+
+		device->state = SIM_OW_ROM_COMMAND;
+		device->bits = 0;
+		device->buffer[0] = 0;
+
+		presence = TRUE;
+	}
+
+	return presence;
+}
+
+static uint8_t Sim_OneWire_slot(uint8_t master_bit)
+{
+	uint8_t overdrive = (ds2482_config & SIM_DS2482_1WS) ? TRUE : FALSE;
+	uint8_t bus = master_bit;
+
+	/* Wired AND of master and every device at the same speed */
+	for(uint8_t i = 0; i < num_of_devices; i++)
+	{
+		Sim_OneWire_update(onewire_devices[i]);
+
+		if(onewire_devices[i]->overdrive == overdrive)
+		{
+			bus &= Sim_OneWire_output(onewire_devices[i]);
+		}
+	}
+
+	for(uint8_t i = 0; i < num_of_devices; i++)
+	{
+		if(onewire_devices[i]->overdrive == overdrive)
+		{
+			Sim_OneWire_input(onewire_devices[i], bus);
+		}
+	}
+
+	return bus;
+}
+
+static uint8_t Sim_OneWire_output(struct sim_onewire_device_struct *device)
+{
+	switch(device->state)
+	{
+		case SIM_OW_SEARCH:
+			if(device->phase == 0)
+			{
+				return ROM_bit(device, device->bits);
+			}
+			else if(device->phase == 1)
+			{
+				return ROM_bit(device, device->bits) ^ 1;
+			}
+			return 1;
+
+		case SIM_OW_READ:
+			if(device->bits < SIM_OW_SCRATCHPAD_BITS)
+			{
+				return (device->buffer[device->bits >> 3] >> (device->bits & 0x07)) & 0x01;
+			}
+			return 1;
+
+		case SIM_OW_POWER_SUPPLY:
+			return (device->parasite == TRUE) ? 0 : 1;
+
+		case SIM_OW_CONVERSION:
+			/* Parasite powered device can not pull the bus down */
+			return ((device->converting == TRUE) && (device->parasite == FALSE)) ? 0 : 1;
+
+		default:
+			return 1;
+	}
+}
+
+static void Sim_OneWire_input(struct sim_onewire_device_struct *device, uint8_t bit)
+{
+	switch(device->state)
+	{
+		case SIM_OW_ROM_COMMAND:
+		case SIM_OW_FUNCTION_COMMAND:
+			device->buffer[0] |= bit << device->bits;
+
+			if(++device->bits < 8)
+			{
+				break;
+			}
+
+			device->bits = 0;
+
+			if(device->state == SIM_OW_FUNCTION_COMMAND)
+			{
+				Sim_OneWire_function(device, device->buffer[0]);
+				break;
+			}
+
+			switch(device->buffer[0])
+			{
+				case SIM_OW_SEARCH_ROM:
+					device->state = SIM_OW_SEARCH;
+					device->phase = 0;
+					break;
+
+				case SIM_OW_MATCH_ROM:
+					device->state = SIM_OW_MATCH;
+					break;
+
+				case SIM_OW_SKIP_ROM:
+					device->state = SIM_OW_FUNCTION_COMMAND;
+					device->buffer[0] = 0;
+					break;
+
+				case SIM_OW_OVERDRIVE_MATCH_ROM:
+					device->overdrive_commands++;
+
+					if(device->rom[0] == SIM_DS28EA00_FAMILY)
+					{
+						/* ROM code follows at overdrive speed */
+						device->overdrive = TRUE;
+						device->state = SIM_OW_MATCH;
+					}
+					else
+					{
+						device->state = SIM_OW_IDLE;
+					}
+					break;
+
+				default:
+					device->state = SIM_OW_IDLE;
+					break;
+			}
+			break;
+
+		case SIM_OW_SEARCH:
+			if(device->phase < 2)
+			{
+				device->phase++;
+			}
+			else if(bit != ROM_bit(device, device->bits))
+			{
+				/* Master took the other branch */
+				device->state = SIM_OW_IDLE;
+			}
+			else if(++device->bits >= SIM_OW_ROM_BITS)
+			{
+				device->state = SIM_OW_FUNCTION_COMMAND;
+				device->bits = 0;
+				device->buffer[0] = 0;
+			}
+			else
+			{
+				device->phase = 0;
+			}
+			break;
+
+		case SIM_OW_MATCH:
+			if(bit != ROM_bit(device, device->bits))
+			{
+				device->state = SIM_OW_IDLE;
+			}
+			else if(++device->bits >= SIM_OW_ROM_BITS)
+			{
+				if(device->overdrive == TRUE)
+				{
+					device->overdrive_matches++;
+				}
+
+				device->state = SIM_OW_FUNCTION_COMMAND;
+				device->bits = 0;
+				device->buffer[0] = 0;
+			}
+			break;
+
+		case SIM_OW_READ:
+			if(device->bits < SIM_OW_SCRATCHPAD_BITS)
+			{
+				device->bits++;
+			}
+			break;
+
+		case SIM_OW_WRITE:
+			device->buffer[device->bits >> 3] |= bit << (device->bits & 0x07);
+
+			if(++device->bits >= SIM_OW_CONFIG_BITS)
+			{
+				/* Unused and resolution bits only */
+				device->th = device->buffer[0];
+				device->tl = device->buffer[1];
+				device->config = (device->buffer[2] & 0x60) | 0x1F;
+
+				device->state = SIM_OW_IDLE;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void Sim_OneWire_function(struct sim_onewire_device_struct *device, uint8_t command)
+{
+	uint8_t resolution = ((device->config >> 5) & 0x03) + 9;
+
+	if(Is_sensor(device) == FALSE)
+	{
+		/* Serial number devices have ROM commands only */
+		device->state = SIM_OW_IDLE;
+		return;
+	}
+
+	switch(command)
+	{
+		case SIM_OW_CONVERT_T:
+			/* Parasite device needs strong pull-up, for the whole conversion */
+			device->converting = TRUE;
+			device->powered = ((device->parasite == FALSE) || (strong_pullup == TRUE)) ? TRUE : FALSE;
+			device->conversion_end = Host_get_cycles() + ((uint64_t)SIM_DS18B20_CONVERSION_US(resolution) * HOST_CYCLES_PER_MS) / 1000;
+			device->state = SIM_OW_CONVERSION;
+			break;
+
+		case SIM_OW_READ_SCRATCHPAD:
+			device->buffer[0] = (uint8_t)device->temperature_reg;
+			device->buffer[1] = (uint8_t)(device->temperature_reg >> 8);
+			device->buffer[2] = device->th;
+			device->buffer[3] = device->tl;
+			device->buffer[4] = device->config;
+			device->buffer[5] = 0xFF;
+			device->buffer[6] = 0x0C;
+			device->buffer[7] = 0x10;
+			device->buffer[8] = Sim_OneWire_CRC8(device->buffer, 8);
+
+			if(device->corrupt_reads > 0)
+			{
+				/* Noise on the line, after CRC was calculated */
+				device->corrupt_reads--;
+				device->buffer[0] ^= 0x04;
+			}
+
+			device->scratchpad_reads++;
+			device->state = SIM_OW_READ;
+			break;
+
+		case SIM_OW_WRITE_SCRATCHPAD:
+			device->buffer[0] = 0;
+			device->buffer[1] = 0;
+			device->buffer[2] = 0;
+			device->state = SIM_OW_WRITE;
+			break;
+
+		case SIM_OW_READ_POWER_SUPPLY:
+			device->state = SIM_OW_POWER_SUPPLY;
+			break;
+
+		default:
+			device->state = SIM_OW_IDLE;
+			break;
+	}
+}
+
+static void Sim_OneWire_update(struct sim_onewire_device_struct *device)
+{
+	if((device->converting == TRUE) && (Host_get_cycles() >= device->conversion_end))
+	{
+		/* Low resolution leaves lowest bits undefined, they keep what the ADC had */
+		device->temperature_reg = (device->powered == TRUE) ? device->temperature : SIM_DS18B20_POWER_ON_TEMP;
+		device->converting = FALSE;
+		device->conversions++;
+	}
+}
+
+static void Sim_OneWire_end_strong_pullup(void)
+{
+	if(strong_pullup == FALSE)
+	{
+		return;
+	}
+
+	for(uint8_t i = 0; i < num_of_devices; i++)
+	{
+		Sim_OneWire_update(onewire_devices[i]);
+
+		if((onewire_devices[i]->parasite == TRUE) && (onewire_devices[i]->converting == TRUE))
+		{
+			/* Conversion ran out of power */
+			onewire_devices[i]->powered = FALSE;
+		}
+	}
+
+	strong_pullup = FALSE;
+	ds2482_config &= ~SIM_DS2482_SPU;
+}
+
+static uint8_t Is_sensor(const struct sim_onewire_device_struct *device)
+{
+	return ((device->rom[0] == SIM_DS18B20_FAMILY) || (device->rom[0] == SIM_DS28EA00_FAMILY)) ? TRUE : FALSE;
+}
+
+static uint8_t ROM_bit(const struct sim_onewire_device_struct *device, uint8_t bit)
+{
+	/* Least significant bit of family code first */
+	return (device->rom[bit >> 3] >> (bit & 0x07)) & 0x01;
+}
@@ -0,0 +1,79 @@
+/*
+ * sim_ds2482.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* DS2482-100 on simulated I2C1, driving a multi-drop 1-Wire bus time slot by time slot */
+
+#ifndef SIM_DS2482_H_
+#define SIM_DS2482_H_
+
+#include <stdint.h>
+
+#include "sim_i2c.h"
+
+#define SIM_ONEWIRE_MAX_DEVICES		8
+
+/* Family codes */
+#define SIM_DS2401_FAMILY			0x01	// Serial number only, ROM commands
+#define SIM_DS18B20_FAMILY			0x28
+#define SIM_DS28EA00_FAMILY			0x42	// DS18B20 scratchpad, overdrive capable
+
+/* Typical conversion time, datasheet maximum is 750ms at 12-bit */
+#define SIM_DS18B20_CONVERSION_US(res)	(600000U >> (12 - (res)))
+
+/* Configuration Register for resolution, as in EEPROM */
+#define SIM_DS18B20_CONFIG(res)		(uint8_t)((((res) - 9) << 5) | 0x1F)
+
+struct sim_onewire_device_struct
+{
+	/* Set by test */
+	uint8_t rom[8];
+	uint8_t parasite;				/* Powered from data line, needs strong pull-up to convert */
+	int16_t temperature;			/* Result of next conversion, 1/16 *C */
+	uint8_t eeprom_config;			/* Configuration Register after power-up */
+	uint8_t corrupt_reads;			/* Scratchpad reads with a flipped bit, CRC left as it was */
+
+	/* Scratchpad */
+	int16_t temperature_reg;
+	uint8_t th;
+	uint8_t tl;
+	uint8_t config;
+
+	/* Traffic of the device */
+	uint32_t conversions;			/* Finished, with or without enough power */
+	uint32_t scratchpad_reads;
+	uint32_t overdrive_matches;		/* Selected at overdrive speed */
+	uint32_t overdrive_commands;	/* OVERDRIVE MATCH ROM heard, addressed to any device */
+
+	/* Bus state */
+	uint8_t state;
+	uint8_t overdrive;
+	uint8_t bits;
+	uint8_t phase;
+	uint8_t buffer[9];
+	uint8_t converting;
+	uint8_t powered;
+	uint64_t conversion_end;
+};
+
+extern struct sim_i2c_slave_struct sim_ds2482;
+
+/* Bus traffic, all devices */
+extern uint32_t sim_onewire_resets;
+extern uint32_t sim_onewire_triplets;
+
+/* Bridge as after power-up, empty bus */
+void Sim_DS2482_init(void);
+
+/* Device with given serial number joins the bus, ROM code CRC is made valid */
+void Sim_OneWire_add_device(struct sim_onewire_device_struct *device, uint8_t family, uint32_t serial);
+
+/* Brown-out, configuration reloaded from EEPROM, power-on temperature of 85*C */
+void Sim_OneWire_power_up(struct sim_onewire_device_struct *device);
+
+uint8_t Sim_OneWire_CRC8(const uint8_t *data, uint8_t len);
+
+#endif /* SIM_DS2482_H_ */
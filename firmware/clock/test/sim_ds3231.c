@@ -0,0 +1,156 @@
+/*
+ * sim_ds3231.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#include "sim_ds3231.h"
+
+#include "../Clock/common_defs.h"
+
+#define SIM_DS3231_ADDR				0xD0
+
+#define SIM_DS3231_OSF_BIT			0x80
+#define SIM_DS3231_EN32KHZ_BIT		0x08
+#define SIM_DS3231_BSY_BIT			0x04
+#define SIM_DS3231_ALARM_FLAGS		0x03
+#define SIM_DS3231_CONV_BIT			0x20
+
+static uint8_t Sim_DS3231_start(uint8_t read);
+static uint8_t Sim_DS3231_write(uint8_t data);
+static uint8_t Sim_DS3231_read(void);
+static void Sim_DS3231_stop(void);
+static void Sim_DS3231_step(void);
+
+struct sim_i2c_slave_struct sim_ds3231 = {SIM_DS3231_ADDR, Sim_DS3231_start, Sim_DS3231_write, Sim_DS3231_read, Sim_DS3231_stop, 0, 0};
+
+uint8_t sim_ds3231_regs[SIM_DS3231_NUM_OF_REGS];
+uint32_t sim_ds3231_conversions = 0;
+uint8_t sim_ds3231_nack_data = FALSE;
+
+static uint8_t ds3231_pointer = 0;
+static uint8_t ds3231_pointer_set = FALSE;
+
+static int16_t ds3231_temperature = 25 * 4;
+static uint64_t ds3231_conversion_end = 0;
+
+void Sim_DS3231_init(void)
+{
+	for(uint8_t i = 0; i < SIM_DS3231_NUM_OF_REGS; i++)
+	{
+		sim_ds3231_regs[i] = 0;
+	}
+
+	/* Date registers start at 1, INTCN set, 1Hz rate bits set, 32kHz output on */
+	sim_ds3231_regs[0x03] = 0x01;
+	sim_ds3231_regs[0x04] = 0x01;
+	sim_ds3231_regs[0x05] = 0x01;
+	sim_ds3231_regs[SIM_DS3231_CONTROL] = 0x1C;
+	sim_ds3231_regs[SIM_DS3231_STATUS] = SIM_DS3231_OSF_BIT | SIM_DS3231_EN32KHZ_BIT;
+	sim_ds3231_regs[SIM_DS3231_TEMP_MSB] = (uint8_t)(ds3231_temperature >> 2);
+	sim_ds3231_regs[SIM_DS3231_TEMP_LSB] = (uint8_t)(ds3231_temperature << 6);
+
+	Sim_I2C_add_slave(&sim_ds3231);
+	Host_add_model(Sim_DS3231_step);
+}
+
+void Sim_DS3231_set_temperature(int16_t quarters)
+{
+	ds3231_temperature = quarters;
+}
+
+static uint8_t Sim_DS3231_start(uint8_t read)
+{
+	/* First byte of a write sets register pointer */
+	if(read == FALSE)
+	{
+		ds3231_pointer_set = FALSE;
+	}
+
+	return TRUE;
+}
+
+static uint8_t Sim_DS3231_write(uint8_t data)
+{
+	uint8_t reg;
+
+	if(ds3231_pointer_set == FALSE)
+	{
+		ds3231_pointer = (data < SIM_DS3231_NUM_OF_REGS) ? data : 0;
+		ds3231_pointer_set = TRUE;
+
+		return TRUE;
+	}
+
+	if(sim_ds3231_nack_data == TRUE)
+	{
+		return FALSE;
+	}
+
+	reg = ds3231_pointer;
+
+	switch(reg)
+	{
+		case SIM_DS3231_CONTROL:
+			/* CONV starts conversion, unless one is running, reads back set until done */
+			if((data & SIM_DS3231_CONV_BIT) && ((sim_ds3231_regs[SIM_DS3231_STATUS] & SIM_DS3231_BSY_BIT) == 0))
+			{
+				sim_ds3231_regs[SIM_DS3231_STATUS] |= SIM_DS3231_BSY_BIT;
+				ds3231_conversion_end = Host_get_cycles() + ((uint64_t)SIM_DS3231_CONVERSION_MS * HOST_CYCLES_PER_MS);
+			}
+
+			sim_ds3231_regs[reg] = (data & ~SIM_DS3231_CONV_BIT) |
+					((sim_ds3231_regs[SIM_DS3231_STATUS] & SIM_DS3231_BSY_BIT) ? SIM_DS3231_CONV_BIT : 0);
+			break;
+
+		case SIM_DS3231_STATUS:
+			/* Flags can only be cleared, BSY is read-only */
+			sim_ds3231_regs[reg] = (data & SIM_DS3231_EN32KHZ_BIT) |
+					(sim_ds3231_regs[reg] & data & (SIM_DS3231_OSF_BIT | SIM_DS3231_ALARM_FLAGS)) |
+					(sim_ds3231_regs[reg] & SIM_DS3231_BSY_BIT);
+			break;
+
+		case SIM_DS3231_TEMP_MSB:
+		case SIM_DS3231_TEMP_LSB:
+			/* Read-only */
+			break;
+
+		default:
+			sim_ds3231_regs[reg] = data;
+			break;
+	}
+
+	/* Pointer wraps after the last register */
+	ds3231_pointer = (reg + 1) % SIM_DS3231_NUM_OF_REGS;
+
+	return TRUE;
+}
+
+static uint8_t Sim_DS3231_read(void)
+{
+	uint8_t data = sim_ds3231_regs[ds3231_pointer];
+
+	ds3231_pointer = (ds3231_pointer + 1) % SIM_DS3231_NUM_OF_REGS;
+
+	return data;
+}
+
+static void Sim_DS3231_stop(void)
+{
+}
+
+static void Sim_DS3231_step(void)
+{
+	if((sim_ds3231_regs[SIM_DS3231_STATUS] & SIM_DS3231_BSY_BIT) && (Host_get_cycles() >= ds3231_conversion_end))
+	{
+		/* Result, left aligned quarters of *C */
+		sim_ds3231_regs[SIM_DS3231_TEMP_MSB] = (uint8_t)(ds3231_temperature >> 2);
+		sim_ds3231_regs[SIM_DS3231_TEMP_LSB] = (uint8_t)(ds3231_temperature << 6);
+
+		sim_ds3231_regs[SIM_DS3231_STATUS] &= ~SIM_DS3231_BSY_BIT;
+		sim_ds3231_regs[SIM_DS3231_CONTROL] &= ~SIM_DS3231_CONV_BIT;
+
+		sim_ds3231_conversions++;
+	}
+}
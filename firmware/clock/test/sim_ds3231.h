@@ -0,0 +1,40 @@
+/*
+ * sim_ds3231.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* DS3231 register file on simulated I2C1, time stands still unless a test moves it */
+
+#ifndef SIM_DS3231_H_
+#define SIM_DS3231_H_
+
+#include <stdint.h>
+
+#include "sim_i2c.h"
+
+#define SIM_DS3231_NUM_OF_REGS		19
+
+#define SIM_DS3231_CONTROL			0x0E
+#define SIM_DS3231_STATUS			0x0F
+#define SIM_DS3231_TEMP_MSB			0x11
+#define SIM_DS3231_TEMP_LSB			0x12
+
+/* Typical, datasheet allows up to 200ms */
+#define SIM_DS3231_CONVERSION_MS	125
+
+extern struct sim_i2c_slave_struct sim_ds3231;
+extern uint8_t sim_ds3231_regs[SIM_DS3231_NUM_OF_REGS];
+extern uint32_t sim_ds3231_conversions;
+
+/* Register data is not acknowledged, pointer still is */
+extern uint8_t sim_ds3231_nack_data;
+
+/* Registers as after first power-up, oscillator stop flag set */
+void Sim_DS3231_init(void);
+
+/* Result of next conversion, quarters of *C */
+void Sim_DS3231_set_temperature(int16_t quarters);
+
+#endif /* SIM_DS3231_H_ */
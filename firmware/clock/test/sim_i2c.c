@@ -0,0 +1,736 @@
+/*
+ * sim_i2c.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#include "sim_i2c.h"
+
+#include <stddef.h>
+
+#include "../Clock/common_defs.h"
+#include "../Clock/i2c_drv.h"
+
+#define SIM_I2C_MAX_SLAVES			8
+
+/* Register addresses as on target, DMA is pointed at them */
+#define SIM_I2C1_BASE				0x40005400U
+#define SIM_I2C1_RXDR				(SIM_I2C1_BASE + 0x24U)
+#define SIM_I2C1_TXDR				(SIM_I2C1_BASE + 0x28U)
+#define SIM_PERIPH_BASE				0x40000000U
+#define SIM_PERIPH_END				0x60000000U
+
+/* ISR flags */
+#define SIM_I2C_TXIS				(1UL << 1U)
+#define SIM_I2C_RXNE				(1UL << 2U)
+#define SIM_I2C_NACKF				(1UL << 4U)
+#define SIM_I2C_STOPF				(1UL << 5U)
+#define SIM_I2C_TC					(1UL << 6U)
+#define SIM_I2C_BERR				(1UL << 8U)
+#define SIM_I2C_ARLO				(1UL << 9U)
+#define SIM_I2C_OVR					(1UL << 10U)
+
+/* CR1 interrupt enables and DMA requests */
+#define SIM_I2C_TXIE				(1UL << 1U)
+#define SIM_I2C_RXIE				(1UL << 2U)
+#define SIM_I2C_NACKIE				(1UL << 4U)
+#define SIM_I2C_STOPIE				(1UL << 5U)
+#define SIM_I2C_TCIE				(1UL << 6U)
+#define SIM_I2C_ERRIE				(1UL << 7U)
+#define SIM_I2C_TXDMAEN				(1UL << 14U)
+#define SIM_I2C_RXDMAEN				(1UL << 15U)
+
+/* CR2 fields used by HandleTransfer */
+#define SIM_I2C_RD_WRN				(1UL << 10U)
+#define SIM_I2C_START				(1UL << 13U)
+
+/* SCL synchronization and rise time, I2CCLK periods per bit */
+#define SIM_I2C_SYNC_CYCLES			4
+
+#define SIM_I2C_SCL_PIN				LL_GPIO_PIN_9
+#define SIM_I2C_SDA_PIN				LL_GPIO_PIN_10
+
+#define SIM_DMA_NUM_OF_CHANNELS		8
+
+enum SIM_I2C_PHASES
+{
+	SIM_I2C_IDLE = 0,
+	SIM_I2C_BLOCKED,		/* START waits for SDA, forever */
+	SIM_I2C_ADDRESS,
+	SIM_I2C_DATA,
+	SIM_I2C_WAIT_TC,		/* SCL stretched until next HandleTransfer */
+	SIM_I2C_STOP
+};
+
+struct sim_dma_channel_struct
+{
+	uint32_t configuration;
+	uint32_t cpar;
+	uint32_t cmar;
+	uint32_t cndtr;
+	uint8_t enabled;
+};
+
+static struct sim_i2c_slave_struct *sim_slaves[SIM_I2C_MAX_SLAVES];
+static uint8_t sim_num_of_slaves = 0;
+
+/* I2C1 registers and transfer in progress */
+static uint8_t i2c_enabled = TRUE;
+static uint32_t i2c_timing = 0x00503D58;		/* CubeMX init, standard mode */
+static uint32_t i2c_timing_writes_in_irq = 0;
+static uint32_t i2c_cr1 = 0;
+static uint32_t i2c_isr = 0;
+static uint8_t i2c_txdr = 0;
+static uint8_t i2c_txdr_full = FALSE;
+static uint8_t i2c_rxdr = 0;
+
+static uint8_t i2c_phase = SIM_I2C_IDLE;
+static uint64_t i2c_next_event = 0;
+static uint8_t i2c_read = FALSE;
+static uint8_t i2c_addr = 0;
+static uint8_t i2c_nbytes = 0;
+static uint8_t i2c_count = 0;
+static uint8_t i2c_autoend = FALSE;
+static uint8_t i2c_shifting = FALSE;
+static uint8_t i2c_shift_byte = 0;
+static uint8_t i2c_arlo_pending = FALSE;
+static struct sim_i2c_slave_struct *i2c_slave = NULL;
+
+static uint32_t syscfg_fast_mode_plus = 0;
+
+static struct sim_dma_channel_struct dma_channels[SIM_DMA_NUM_OF_CHANNELS];
+
+/* GPIOA, I2C pins are open-drain with pull-ups */
+static uint32_t gpio_odr = 0xFFFF;
+static uint32_t gpio_modes[16];
+
+static uint8_t sda_stuck = FALSE;
+static uint32_t sda_release_pulses = 0;
+static uint32_t scl_pulses = 0;
+static uint32_t scl_pulses_when_stuck = 0;
+
+static void Sim_I2C_step(void);
+static void Sim_I2C_event(uint64_t now);
+static void Sim_I2C_feed(uint64_t now);
+static void Sim_I2C_end(uint64_t now);
+static void Sim_I2C_nack(uint64_t now);
+static void Sim_I2C_interrupt(void);
+static void Sim_DMA_serve(void);
+static uint8_t Sim_DMA_transfer(struct sim_dma_channel_struct *channel);
+static uint8_t *Sim_memory(uint32_t addr);
+static struct sim_i2c_slave_struct *Sim_I2C_find_slave(uint8_t addr);
+static void Sim_GPIO_changed(uint32_t old_odr);
+
+void Sim_I2C_init(void)
+{
+	Host_add_model(Sim_I2C_step);
+}
+
+void Sim_I2C_add_slave(struct sim_i2c_slave_struct *slave)
+{
+	if(sim_num_of_slaves < SIM_I2C_MAX_SLAVES)
+	{
+		sim_slaves[sim_num_of_slaves++] = slave;
+	}
+}
+
+void Sim_I2C_stick_SDA(uint32_t release_after_pulses)
+{
+	sda_stuck = TRUE;
+	sda_release_pulses = release_after_pulses;
+	scl_pulses_when_stuck = scl_pulses;
+}
+
+void Sim_I2C_release_SDA(void)
+{
+	sda_stuck = FALSE;
+}
+
+uint8_t Sim_I2C_is_SDA_stuck(void)
+{
+	return sda_stuck;
+}
+
+uint32_t Sim_I2C_get_SCL_pulses(void)
+{
+	return scl_pulses;
+}
+
+void Sim_I2C_inject_ARLO(void)
+{
+	i2c_arlo_pending = TRUE;
+}
+
+uint32_t Sim_I2C_get_bit_cycles(void)
+{
+	uint32_t presc = (i2c_timing >> 28) + 1;
+	uint32_t sclh = ((i2c_timing >> 8) & 0xFF) + 1;
+	uint32_t scll = (i2c_timing & 0xFF) + 1;
+
+	/* 16MHz I2CCLK, same as core */
+	return (presc * (sclh + scll)) + SIM_I2C_SYNC_CYCLES;
+}
+
+uint32_t Sim_I2C_get_timing_writes_in_irq(void)
+{
+	return i2c_timing_writes_in_irq;
+}
+
+uint8_t Sim_I2C_is_fast_mode_plus(void)
+{
+	return ((syscfg_fast_mode_plus & (LL_SYSCFG_I2C_FASTMODEPLUS_PA9 | LL_SYSCFG_I2C_FASTMODEPLUS_PA10)) ==
+			(LL_SYSCFG_I2C_FASTMODEPLUS_PA9 | LL_SYSCFG_I2C_FASTMODEPLUS_PA10)) ? TRUE : FALSE;
+}
+
+static void Sim_I2C_step(void)
+{
+	uint64_t now = Host_get_cycles();
+
+	Sim_DMA_serve();
+
+	/* Nothing moves while a slave holds SDA */
+	while((i2c_enabled == TRUE) && (sda_stuck == FALSE) &&
+			((i2c_phase == SIM_I2C_ADDRESS) || (i2c_phase == SIM_I2C_DATA) || (i2c_phase == SIM_I2C_STOP)) &&
+			(now >= i2c_next_event))
+	{
+		uint8_t phase = i2c_phase;
+		uint8_t count = i2c_count;
+
+		Sim_I2C_event(now);
+
+		/* Stalled, waits for software or DMA */
+		if((phase == i2c_phase) && (count == i2c_count) && (now >= i2c_next_event))
+		{
+			break;
+		}
+
+		Sim_DMA_serve();
+	}
+
+	Sim_I2C_interrupt();
+}
+
+static void Sim_I2C_event(uint64_t now)
+{
+	uint32_t bit = Sim_I2C_get_bit_cycles();
+
+	if(i2c_arlo_pending == TRUE)
+	{
+		/* Another master won, bus released without STOP */
+		i2c_arlo_pending = FALSE;
+		i2c_isr |= SIM_I2C_ARLO;
+		i2c_phase = SIM_I2C_IDLE;
+		i2c_slave = NULL;
+
+		return;
+	}
+
+	switch(i2c_phase)
+	{
+		case SIM_I2C_ADDRESS:
+			i2c_slave = Sim_I2C_find_slave(i2c_addr);
+
+			if((i2c_slave == NULL) || (i2c_slave->start(i2c_read) == FALSE))
+			{
+				Sim_I2C_nack(now);
+				break;
+			}
+
+			i2c_slave->bytes++;
+
+			if(i2c_nbytes == 0)
+			{
+				Sim_I2C_end(now);
+				break;
+			}
+
+			i2c_phase = SIM_I2C_DATA;
+			i2c_shifting = i2c_read;
+			i2c_next_event = now + (9 * bit);
+
+			if(i2c_read == FALSE)
+			{
+				Sim_I2C_feed(now);
+			}
+			break;
+
+		case SIM_I2C_DATA:
+			if(i2c_read == FALSE)
+			{
+				if(i2c_shifting == FALSE)
+				{
+					Sim_I2C_feed(now);
+					break;
+				}
+
+				i2c_shifting = FALSE;
+				i2c_count++;
+				i2c_slave->bytes++;
+
+				if(i2c_slave->write(i2c_shift_byte) == FALSE)
+				{
+					Sim_I2C_nack(now);
+				}
+				else if(i2c_count == i2c_nbytes)
+				{
+					Sim_I2C_end(now);
+				}
+				else
+				{
+					Sim_I2C_feed(now);
+				}
+			}
+			else
+			{
+				/* SCL stretched, until previous byte is taken */
+				if(i2c_isr & SIM_I2C_RXNE)
+				{
+					break;
+				}
+
+				i2c_rxdr = i2c_slave->read();
+				i2c_isr |= SIM_I2C_RXNE;
+				i2c_count++;
+				i2c_slave->bytes++;
+
+				if(i2c_count == i2c_nbytes)
+				{
+					/* Last byte not acknowledged by master */
+					Sim_I2C_end(now);
+				}
+				else
+				{
+					i2c_next_event = now + (9 * bit);
+				}
+			}
+			break;
+
+		case SIM_I2C_STOP:
+		default:
+			i2c_isr |= SIM_I2C_STOPF;
+			i2c_phase = SIM_I2C_IDLE;
+
+			if(i2c_slave != NULL)
+			{
+				i2c_slave->transactions++;
+				i2c_slave->stop();
+				i2c_slave = NULL;
+			}
+			break;
+	}
+}
+
+static void Sim_I2C_feed(uint64_t now)
+{
+	/* TXDR moves to shift register, TXIS asks for the next byte meanwhile */
+	if((i2c_shifting == FALSE) && (i2c_txdr_full == TRUE))
+	{
+		i2c_shift_byte = i2c_txdr;
+		i2c_txdr_full = FALSE;
+		i2c_shifting = TRUE;
+		i2c_next_event = now + (9 * Sim_I2C_get_bit_cycles());
+	}
+
+	if(((i2c_count + i2c_shifting) < i2c_nbytes) && (i2c_txdr_full == FALSE))
+	{
+		i2c_isr |= SIM_I2C_TXIS;
+	}
+}
+
+static void Sim_I2C_end(uint64_t now)
+{
+	if(i2c_autoend == TRUE)
+	{
+		i2c_phase = SIM_I2C_STOP;
+		i2c_next_event = now + Sim_I2C_get_bit_cycles();
+	}
+	else
+	{
+		i2c_isr |= SIM_I2C_TC;
+		i2c_phase = SIM_I2C_WAIT_TC;
+	}
+}
+
+static void Sim_I2C_nack(uint64_t now)
+{
+	/* Master generates STOP on its own */
+	i2c_isr |= SIM_I2C_NACKF;
+	i2c_isr &= ~SIM_I2C_TXIS;
+	i2c_phase = SIM_I2C_STOP;
+	i2c_next_event = now + Sim_I2C_get_bit_cycles();
+}
+
+static void Sim_I2C_interrupt(void)
+{
+	uint32_t pending = 0;
+
+	if((i2c_enabled == FALSE) || (Host_is_irq_allowed() == FALSE))
+	{
+		return;
+	}
+
+	if(i2c_cr1 & SIM_I2C_TXIE)		pending |= i2c_isr & SIM_I2C_TXIS;
+	if(i2c_cr1 & SIM_I2C_RXIE)		pending |= i2c_isr & SIM_I2C_RXNE;
+	if(i2c_cr1 & SIM_I2C_NACKIE)	pending |= i2c_isr & SIM_I2C_NACKF;
+	if(i2c_cr1 & SIM_I2C_STOPIE)	pending |= i2c_isr & SIM_I2C_STOPF;
+	if(i2c_cr1 & SIM_I2C_TCIE)		pending |= i2c_isr & SIM_I2C_TC;
+	if(i2c_cr1 & SIM_I2C_ERRIE)		pending |= i2c_isr & (SIM_I2C_BERR | SIM_I2C_ARLO | SIM_I2C_OVR);
+
+	if(pending != 0)
+	{
+		Host_enter_irq();
+		I2C_IRQ_handler();
+		Host_exit_irq();
+	}
+}
+
+static void Sim_DMA_serve(void)
+{
+	/* Request stays active until RXDR is read, also when DMA reads elsewhere */
+	while((i2c_cr1 & SIM_I2C_RXDMAEN) && (i2c_isr & SIM_I2C_RXNE) &&
+			(Sim_DMA_transfer(&dma_channels[LL_DMA_CHANNEL_3]) == TRUE));
+
+	if((i2c_phase != SIM_I2C_DATA) || (i2c_read == TRUE))
+	{
+		return;
+	}
+
+	Sim_I2C_feed(Host_get_cycles());
+
+	/* Fills TXDR, then again once it moves to the shift register */
+	while((i2c_cr1 & SIM_I2C_TXDMAEN) && (i2c_isr & SIM_I2C_TXIS) &&
+			(Sim_DMA_transfer(&dma_channels[LL_DMA_CHANNEL_2]) == TRUE))
+	{
+		Sim_I2C_feed(Host_get_cycles());
+	}
+}
+
+static uint8_t Sim_DMA_transfer(struct sim_dma_channel_struct *channel)
+{
+	uint32_t src;
+	uint32_t dst;
+	uint8_t data;
+
+	if((channel->enabled == FALSE) || (channel->cndtr == 0))
+	{
+		return FALSE;
+	}
+
+	if(channel->configuration & LL_DMA_DIRECTION_MEMORY_TO_PERIPH)
+	{
+		src = channel->cmar;
+		dst = channel->cpar;
+	}
+	else
+	{
+		src = channel->cpar;
+		dst = channel->cmar;
+	}
+
+	/* Read source */
+	if(src == SIM_I2C1_RXDR)
+	{
+		data = LL_I2C_ReceiveData8(I2C1);
+	}
+	else if(Sim_memory(src) != NULL)
+	{
+		data = *Sim_memory(src);
+	}
+	else
+	{
+		/* Transfer error, channel disabled */
+		channel->enabled = FALSE;
+
+		return FALSE;
+	}
+
+	/* Write destination */
+	if(dst == SIM_I2C1_TXDR)
+	{
+		LL_I2C_TransmitData8(I2C1, data);
+	}
+	else if(Sim_memory(dst) != NULL)
+	{
+		*Sim_memory(dst) = data;
+	}
+	else
+	{
+		channel->enabled = FALSE;
+
+		return FALSE;
+	}
+
+	if(channel->configuration & LL_DMA_MEMORY_INCREMENT)
+	{
+		channel->cmar++;
+	}
+
+	channel->cndtr--;
+
+	return TRUE;
+}
+
+static uint8_t *Sim_memory(uint32_t addr)
+{
+	/* Statics are below 4GB, stack is not, upper half comes from own frame */
+	uintptr_t frame = (uintptr_t)&addr;
+	uintptr_t stack_addr = (frame & ~(uintptr_t)0xFFFFFFFFU) | addr;
+
+	if((frame > 0xFFFFFFFFU) && (stack_addr >= (frame - 0x10000U)) && (stack_addr < (frame + 0x1000000U)))
+	{
+		return (uint8_t *)stack_addr;
+	}
+
+	/* Registers, other than the data registers, are not reachable */
+	if((addr >= SIM_PERIPH_BASE) && (addr < SIM_PERIPH_END))
+	{
+		return NULL;
+	}
+
+	return (uint8_t *)(uintptr_t)addr;
+}
+
+static struct sim_i2c_slave_struct *Sim_I2C_find_slave(uint8_t addr)
+{
+	for(uint8_t i = 0; i < sim_num_of_slaves; i++)
+	{
+		if(sim_slaves[i]->addr == (addr & 0xFE))
+		{
+			return sim_slaves[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* I2C */
+void LL_I2C_Enable(I2C_TypeDef *i2c)
+{
+	i2c_enabled = TRUE;
+}
+
+void LL_I2C_Disable(I2C_TypeDef *i2c)
+{
+	/* Software reset, transfer and flags are dropped, slave is left as it was */
+	i2c_enabled = FALSE;
+	i2c_isr = 0;
+	i2c_txdr_full = FALSE;
+	i2c_phase = SIM_I2C_IDLE;
+	i2c_slave = NULL;
+}
+
+uint32_t LL_I2C_IsEnabled(I2C_TypeDef *i2c)
+{
+	return i2c_enabled;
+}
+
+void LL_I2C_SetTiming(I2C_TypeDef *i2c, uint32_t timing)
+{
+	if(Host_is_in_irq() == TRUE)
+	{
+		i2c_timing_writes_in_irq++;
+	}
+
+	i2c_timing = timing;
+}
+
+void LL_I2C_EnableIT_TX(I2C_TypeDef *i2c)		{ i2c_cr1 |= SIM_I2C_TXIE; }
+void LL_I2C_DisableIT_TX(I2C_TypeDef *i2c)		{ i2c_cr1 &= ~SIM_I2C_TXIE; }
+void LL_I2C_EnableIT_RX(I2C_TypeDef *i2c)		{ i2c_cr1 |= SIM_I2C_RXIE; }
+void LL_I2C_DisableIT_RX(I2C_TypeDef *i2c)		{ i2c_cr1 &= ~SIM_I2C_RXIE; }
+void LL_I2C_EnableIT_TC(I2C_TypeDef *i2c)		{ i2c_cr1 |= SIM_I2C_TCIE; }
+void LL_I2C_EnableIT_STOP(I2C_TypeDef *i2c)		{ i2c_cr1 |= SIM_I2C_STOPIE; }
+void LL_I2C_EnableIT_NACK(I2C_TypeDef *i2c)		{ i2c_cr1 |= SIM_I2C_NACKIE; }
+void LL_I2C_EnableIT_ERR(I2C_TypeDef *i2c)		{ i2c_cr1 |= SIM_I2C_ERRIE; }
+void LL_I2C_EnableDMAReq_TX(I2C_TypeDef *i2c)	{ i2c_cr1 |= SIM_I2C_TXDMAEN; }
+void LL_I2C_DisableDMAReq_TX(I2C_TypeDef *i2c)	{ i2c_cr1 &= ~SIM_I2C_TXDMAEN; }
+void LL_I2C_EnableDMAReq_RX(I2C_TypeDef *i2c)	{ i2c_cr1 |= SIM_I2C_RXDMAEN; }
+void LL_I2C_DisableDMAReq_RX(I2C_TypeDef *i2c)	{ i2c_cr1 &= ~SIM_I2C_RXDMAEN; }
+
+uint32_t LL_I2C_IsActiveFlag_TXE(I2C_TypeDef *i2c)	{ return (i2c_txdr_full == FALSE) ? 1U : 0U; }
+uint32_t LL_I2C_IsActiveFlag_TXIS(I2C_TypeDef *i2c)	{ return (i2c_isr & SIM_I2C_TXIS) ? 1U : 0U; }
+uint32_t LL_I2C_IsActiveFlag_RXNE(I2C_TypeDef *i2c)	{ return (i2c_isr & SIM_I2C_RXNE) ? 1U : 0U; }
+uint32_t LL_I2C_IsActiveFlag_TC(I2C_TypeDef *i2c)	{ return (i2c_isr & SIM_I2C_TC) ? 1U : 0U; }
+uint32_t LL_I2C_IsActiveFlag_STOP(I2C_TypeDef *i2c)	{ return (i2c_isr & SIM_I2C_STOPF) ? 1U : 0U; }
+uint32_t LL_I2C_IsActiveFlag_NACK(I2C_TypeDef *i2c)	{ return (i2c_isr & SIM_I2C_NACKF) ? 1U : 0U; }
+uint32_t LL_I2C_IsActiveFlag_BERR(I2C_TypeDef *i2c)	{ return (i2c_isr & SIM_I2C_BERR) ? 1U : 0U; }
+uint32_t LL_I2C_IsActiveFlag_ARLO(I2C_TypeDef *i2c)	{ return (i2c_isr & SIM_I2C_ARLO) ? 1U : 0U; }
+uint32_t LL_I2C_IsActiveFlag_OVR(I2C_TypeDef *i2c)	{ return (i2c_isr & SIM_I2C_OVR) ? 1U : 0U; }
+
+void LL_I2C_ClearFlag_STOP(I2C_TypeDef *i2c)	{ i2c_isr &= ~SIM_I2C_STOPF; }
+void LL_I2C_ClearFlag_NACK(I2C_TypeDef *i2c)	{ i2c_isr &= ~SIM_I2C_NACKF; }
+void LL_I2C_ClearFlag_BERR(I2C_TypeDef *i2c)	{ i2c_isr &= ~SIM_I2C_BERR; }
+void LL_I2C_ClearFlag_ARLO(I2C_TypeDef *i2c)	{ i2c_isr &= ~SIM_I2C_ARLO; }
+void LL_I2C_ClearFlag_OVR(I2C_TypeDef *i2c)		{ i2c_isr &= ~SIM_I2C_OVR; }
+
+void LL_I2C_ClearFlag_TXE(I2C_TypeDef *i2c)
+{
+	/* Flush TXDR */
+	i2c_txdr_full = FALSE;
+}
+
+void LL_I2C_TransmitData8(I2C_TypeDef *i2c, uint8_t data)
+{
+	i2c_txdr = data;
+	i2c_txdr_full = TRUE;
+	i2c_isr &= ~SIM_I2C_TXIS;
+}
+
+uint8_t LL_I2C_ReceiveData8(I2C_TypeDef *i2c)
+{
+	i2c_isr &= ~SIM_I2C_RXNE;
+
+	return i2c_rxdr;
+}
+
+void LL_I2C_HandleTransfer(I2C_TypeDef *i2c, uint32_t slave_addr, uint32_t slave_addr_size,
+		uint32_t transfer_size, uint32_t end_mode, uint32_t request)
+{
+	i2c_addr = (uint8_t)slave_addr;
+	i2c_nbytes = (uint8_t)transfer_size;
+	i2c_autoend = (end_mode == LL_I2C_MODE_AUTOEND) ? TRUE : FALSE;
+	i2c_read = (request & SIM_I2C_RD_WRN) ? TRUE : FALSE;
+
+	if((request & SIM_I2C_START) == 0)
+	{
+		return;
+	}
+
+	/* START, or repeated START after TC */
+	i2c_isr &= ~SIM_I2C_TC;
+	i2c_count = 0;
+	i2c_shifting = FALSE;
+
+	if((sda_stuck == TRUE) && (i2c_phase != SIM_I2C_WAIT_TC))
+	{
+		/* Bus looks busy, START never comes */
+		i2c_phase = SIM_I2C_BLOCKED;
+
+		return;
+	}
+
+	/* START and address byte */
+	i2c_phase = SIM_I2C_ADDRESS;
+	i2c_next_event = Host_get_cycles() + (10 * Sim_I2C_get_bit_cycles());
+}
+
+uint32_t LL_I2C_DMA_GetRegAddr(I2C_TypeDef *i2c, uint32_t direction)
+{
+	return (direction == LL_I2C_DMA_REG_DATA_TRANSMIT) ? SIM_I2C1_TXDR : SIM_I2C1_RXDR;
+}
+
+/* SYSCFG */
+void LL_SYSCFG_EnableFastModePlus(uint32_t mask)
+{
+	syscfg_fast_mode_plus |= mask;
+}
+
+void LL_SYSCFG_DisableFastModePlus(uint32_t mask)
+{
+	syscfg_fast_mode_plus &= ~mask;
+}
+
+/* DMA, addresses as the real LL stores them */
+void LL_DMA_ConfigTransfer(DMA_TypeDef *dma, uint32_t channel, uint32_t configuration)
+{
+	dma_channels[channel].configuration = configuration;
+}
+
+void LL_DMA_ConfigAddresses(DMA_TypeDef *dma, uint32_t channel, uint32_t src_address, uint32_t dst_address, uint32_t direction)
+{
+	if(direction == LL_DMA_DIRECTION_MEMORY_TO_PERIPH)
+	{
+		dma_channels[channel].cmar = src_address;
+		dma_channels[channel].cpar = dst_address;
+	}
+	else
+	{
+		dma_channels[channel].cpar = src_address;
+		dma_channels[channel].cmar = dst_address;
+	}
+}
+
+void LL_DMA_SetDataLength(DMA_TypeDef *dma, uint32_t channel, uint32_t length)
+{
+	dma_channels[channel].cndtr = length;
+}
+
+uint32_t LL_DMA_GetDataLength(DMA_TypeDef *dma, uint32_t channel)
+{
+	return dma_channels[channel].cndtr;
+}
+
+void LL_DMA_EnableChannel(DMA_TypeDef *dma, uint32_t channel)
+{
+	dma_channels[channel].enabled = TRUE;
+}
+
+void LL_DMA_DisableChannel(DMA_TypeDef *dma, uint32_t channel)
+{
+	dma_channels[channel].enabled = FALSE;
+}
+
+void LL_DMA_DisableIT_TC(DMA_TypeDef *dma, uint32_t channel)
+{
+}
+
+/* GPIO, open-drain, lines are low if anyone pulls them */
+void LL_GPIO_SetOutputPin(GPIO_TypeDef *port, uint32_t pins)
+{
+	uint32_t old_odr = gpio_odr;
+
+	gpio_odr |= pins;
+
+	Sim_GPIO_changed(old_odr);
+}
+
+void LL_GPIO_ResetOutputPin(GPIO_TypeDef *port, uint32_t pins)
+{
+	uint32_t old_odr = gpio_odr;
+
+	gpio_odr &= ~pins;
+
+	Sim_GPIO_changed(old_odr);
+}
+
+void LL_GPIO_SetPinMode(GPIO_TypeDef *port, uint32_t pin, uint32_t mode)
+{
+	gpio_modes[__builtin_ctz(pin)] = mode;
+}
+
+uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef *port, uint32_t pins)
+{
+	uint32_t levels = 0xFFFF;
+
+	for(uint8_t i = 0; i < 16; i++)
+	{
+		if((gpio_modes[i] == LL_GPIO_MODE_OUTPUT) && ((gpio_odr & (1UL << i)) == 0))
+		{
+			levels &= ~(1UL << i);
+		}
+	}
+
+	if(sda_stuck == TRUE)
+	{
+		levels &= ~SIM_I2C_SDA_PIN;
+	}
+
+	return ((levels & pins) == pins) ? 1U : 0U;
+}
+
+static void Sim_GPIO_changed(uint32_t old_odr)
+{
+	/* Rising SCL, stuck slave shifts out one more bit */
+	if((gpio_modes[__builtin_ctz(SIM_I2C_SCL_PIN)] == LL_GPIO_MODE_OUTPUT) &&
+			((old_odr & SIM_I2C_SCL_PIN) == 0) && (gpio_odr & SIM_I2C_SCL_PIN))
+	{
+		scl_pulses++;
+
+		if((sda_stuck == TRUE) && (sda_release_pulses != SIM_I2C_STUCK_FOREVER) &&
+				((scl_pulses - scl_pulses_when_stuck) >= sda_release_pulses))
+		{
+			sda_stuck = FALSE;
+		}
+	}
+}
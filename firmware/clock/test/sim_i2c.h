@@ -0,0 +1,51 @@
+/*
+ * sim_i2c.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* I2C1, its DMA channels and pins, byte by byte against simulated slaves */
+
+#ifndef SIM_I2C_H_
+#define SIM_I2C_H_
+
+#include <stdint.h>
+
+/* Slave holding SDA does not let go, until power cycle */
+#define SIM_I2C_STUCK_FOREVER		0
+
+/* Callbacks run at the end of each byte on the bus */
+struct sim_i2c_slave_struct
+{
+	uint8_t addr;						/* 8-bit, as drivers use it */
+
+	uint8_t (*start)(uint8_t read);		/* Address acknowledged? */
+	uint8_t (*write)(uint8_t data);		/* Data acknowledged? */
+	uint8_t (*read)(void);
+	void (*stop)(void);
+
+	/* Bus traffic of the slave */
+	uint32_t transactions;				/* Ended by STOP */
+	uint32_t bytes;						/* Including address bytes */
+};
+
+void Sim_I2C_init(void);
+void Sim_I2C_add_slave(struct sim_i2c_slave_struct *slave);
+
+/* Slave interrupted mid-byte keeps SDA low, lets go after SCL pulses */
+void Sim_I2C_stick_SDA(uint32_t release_after_pulses);
+void Sim_I2C_release_SDA(void);
+uint8_t Sim_I2C_is_SDA_stuck(void);
+uint32_t Sim_I2C_get_SCL_pulses(void);
+
+/* Arbitration lost during next byte on the bus */
+void Sim_I2C_inject_ARLO(void);
+
+uint32_t Sim_I2C_get_bit_cycles(void);
+uint8_t Sim_I2C_is_fast_mode_plus(void);
+
+/* TIMINGR writes made from interrupt */
+uint32_t Sim_I2C_get_timing_writes_in_irq(void);
+
+#endif /* SIM_I2C_H_ */
@@ -0,0 +1,304 @@
+/*
+ * sim_max7219.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#include "sim_max7219.h"
+
+#include <string.h>
+
+#include "../Clock/common_defs.h"
+#include "../Clock/display_drv.h"
+
+/* SPI1 data register, as DMA sees it */
+#define SIM_SPI1_DR					0x4001300CU
+
+#define SIM_DMA_NUM_OF_CHANNELS		8
+
+/* SPI1 channels */
+#define SIM_SPI_RX_CHANNEL			LL_DMA_CHANNEL_2
+#define SIM_SPI_TX_CHANNEL			LL_DMA_CHANNEL_3
+
+/* Bytes shifted into the chain since CS fell, the chain keeps only the last ones */
+#define SIM_CHAIN_BYTES				(SIM_MAX7219_CHAIN_LENGTH * 2)
+
+struct sim_dma_channel_struct
+{
+	uint32_t configuration;
+	uint32_t cpar;
+	uint32_t cmar;
+	uint32_t cndtr;
+	uint8_t enabled;
+	uint8_t tc_interrupt;
+	uint8_t tc_flag;
+};
+
+struct sim_max7219_struct sim_max7219[SIM_MAX7219_CHAIN_LENGTH];
+
+uint32_t sim_spi_bytes = 0;
+uint32_t sim_max7219_latches = 0;
+uint32_t sim_max7219_bad_latches = 0;
+
+static struct sim_dma_channel_struct dma_channels[SIM_DMA_NUM_OF_CHANNELS];
+
+/* SPI1 */
+static uint8_t spi_enabled = FALSE;
+static uint8_t spi_tx_dma = FALSE;
+static uint8_t spi_rx_dma = FALSE;
+static uint8_t spi_shifting = FALSE;
+static uint8_t spi_shift_byte = 0;
+static uint8_t spi_rxne = FALSE;
+static uint64_t spi_byte_end = 0;
+
+/* Chain input */
+static uint8_t cs_low = FALSE;
+static uint8_t chain_bytes[SIM_CHAIN_BYTES];
+static uint32_t chain_count = 0;
+
+static void Sim_SPI_step(void);
+static void Sim_DMA_interrupt(void);
+static void Sim_MAX7219_shift(uint8_t data);
+static void Sim_MAX7219_latch(void);
+
+void Sim_MAX7219_init(void)
+{
+	memset(sim_max7219, 0, sizeof(sim_max7219));
+
+	Host_add_model(Sim_SPI_step);
+}
+
+uint8_t Sim_SPI_is_idle(void)
+{
+	if(spi_shifting == TRUE)
+	{
+		return FALSE;
+	}
+
+	if((spi_tx_dma == TRUE) && (dma_channels[SIM_SPI_TX_CHANNEL].enabled == TRUE) &&
+			(dma_channels[SIM_SPI_TX_CHANNEL].cndtr != 0))
+	{
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void Sim_SPI_step(void)
+{
+	struct sim_dma_channel_struct *rx = &dma_channels[SIM_SPI_RX_CHANNEL];
+	struct sim_dma_channel_struct *tx = &dma_channels[SIM_SPI_TX_CHANNEL];
+	uint64_t now = Host_get_cycles();
+
+	/* Byte left the shift register, the one clocked in is received */
+	if((spi_shifting == TRUE) && (now >= spi_byte_end))
+	{
+		spi_shifting = FALSE;
+		spi_rxne = TRUE;
+		sim_spi_bytes++;
+
+		Sim_MAX7219_shift(spi_shift_byte);
+	}
+
+	/* Received byte dropped to memory */
+	if((spi_rxne == TRUE) && (spi_rx_dma == TRUE) && (rx->enabled == TRUE) && (rx->cndtr != 0))
+	{
+		spi_rxne = FALSE;
+
+		*(volatile uint8_t *)(uintptr_t)rx->cmar = 0x00;
+
+		rx->cndtr--;
+
+		if(rx->cndtr == 0)
+		{
+			rx->tc_flag = TRUE;
+		}
+	}
+
+	/* Next byte from memory, one byte in flight */
+	if((spi_enabled == TRUE) && (spi_shifting == FALSE) && (spi_tx_dma == TRUE) && (tx->enabled == TRUE) && (tx->cndtr != 0))
+	{
+		spi_shift_byte = *(volatile uint8_t *)(uintptr_t)tx->cmar;
+		spi_shifting = TRUE;
+		spi_byte_end = now + SIM_SPI_BYTE_CYCLES;
+
+		if(tx->configuration & LL_DMA_MEMORY_INCREMENT)
+		{
+			tx->cmar++;
+		}
+
+		tx->cndtr--;
+
+		if(tx->cndtr == 0)
+		{
+			tx->tc_flag = TRUE;
+		}
+	}
+
+	Sim_DMA_interrupt();
+}
+
+static void Sim_DMA_interrupt(void)
+{
+	uint8_t pending = FALSE;
+
+	if(Host_is_irq_allowed() == FALSE)
+	{
+		return;
+	}
+
+	/* Channels 2 and 3 share one vector */
+	for(uint32_t channel = SIM_SPI_RX_CHANNEL; channel <= SIM_SPI_TX_CHANNEL; channel++)
+	{
+		if((dma_channels[channel].tc_interrupt == TRUE) && (dma_channels[channel].tc_flag == TRUE))
+		{
+			pending = TRUE;
+		}
+	}
+
+	if(pending == TRUE)
+	{
+		Host_enter_irq();
+		Display_DMA_IRQ_handler();
+		Host_exit_irq();
+	}
+}
+
+static void Sim_MAX7219_shift(uint8_t data)
+{
+	/* Older bytes fall out of the last display */
+	memmove(&chain_bytes[0], &chain_bytes[1], SIM_CHAIN_BYTES - 1);
+	chain_bytes[SIM_CHAIN_BYTES - 1] = data;
+
+	chain_count++;
+}
+
+static void Sim_MAX7219_latch(void)
+{
+	sim_max7219_latches++;
+
+	if((spi_shifting == TRUE) || (chain_count != SIM_CHAIN_BYTES))
+	{
+		sim_max7219_bad_latches++;
+	}
+
+	/* First two bytes have been shifted through to the last display */
+	for(uint8_t d = 0; d < SIM_MAX7219_CHAIN_LENGTH; d++)
+	{
+		uint8_t reg = chain_bytes[2*d] & 0x0F;
+
+		if(reg != SIM_MAX7219_NO_OP)
+		{
+			sim_max7219[d].regs[reg] = chain_bytes[(2*d) + 1];
+			sim_max7219[d].writes++;
+		}
+	}
+}
+
+/* SPI */
+void LL_SPI_Enable(SPI_TypeDef *spi)			{ spi_enabled = TRUE; }
+void LL_SPI_EnableDMAReq_RX(SPI_TypeDef *spi)	{ spi_rx_dma = TRUE; }
+void LL_SPI_DisableDMAReq_RX(SPI_TypeDef *spi)	{ spi_rx_dma = FALSE; }
+void LL_SPI_EnableDMAReq_TX(SPI_TypeDef *spi)	{ spi_tx_dma = TRUE; }
+void LL_SPI_DisableDMAReq_TX(SPI_TypeDef *spi)	{ spi_tx_dma = FALSE; }
+
+uint32_t LL_SPI_DMA_GetRegAddr(SPI_TypeDef *spi)
+{
+	return SIM_SPI1_DR;
+}
+
+/* DMA, addresses as the real LL stores them */
+void LL_DMA_ConfigTransfer(DMA_TypeDef *dma, uint32_t channel, uint32_t configuration)
+{
+	dma_channels[channel].configuration = configuration;
+}
+
+void LL_DMA_ConfigAddresses(DMA_TypeDef *dma, uint32_t channel, uint32_t src_address, uint32_t dst_address, uint32_t direction)
+{
+	if(direction == LL_DMA_DIRECTION_MEMORY_TO_PERIPH)
+	{
+		dma_channels[channel].cmar = src_address;
+		dma_channels[channel].cpar = dst_address;
+	}
+	else
+	{
+		dma_channels[channel].cpar = src_address;
+		dma_channels[channel].cmar = dst_address;
+	}
+}
+
+void LL_DMA_SetMemoryAddress(DMA_TypeDef *dma, uint32_t channel, uint32_t address)
+{
+	dma_channels[channel].cmar = address;
+}
+
+void LL_DMA_SetPeriphAddress(DMA_TypeDef *dma, uint32_t channel, uint32_t address)
+{
+	dma_channels[channel].cpar = address;
+}
+
+void LL_DMA_SetDataLength(DMA_TypeDef *dma, uint32_t channel, uint32_t length)
+{
+	dma_channels[channel].cndtr = length;
+}
+
+uint32_t LL_DMA_GetDataLength(DMA_TypeDef *dma, uint32_t channel)
+{
+	return dma_channels[channel].cndtr;
+}
+
+void LL_DMA_EnableChannel(DMA_TypeDef *dma, uint32_t channel)
+{
+	dma_channels[channel].enabled = TRUE;
+}
+
+void LL_DMA_DisableChannel(DMA_TypeDef *dma, uint32_t channel)
+{
+	dma_channels[channel].enabled = FALSE;
+}
+
+void LL_DMA_EnableIT_TC(DMA_TypeDef *dma, uint32_t channel)
+{
+	dma_channels[channel].tc_interrupt = TRUE;
+}
+
+void LL_DMA_DisableIT_TC(DMA_TypeDef *dma, uint32_t channel)
+{
+	dma_channels[channel].tc_interrupt = FALSE;
+}
+
+uint32_t LL_DMA_IsActiveFlag_TC2(DMA_TypeDef *dma)
+{
+	return dma_channels[LL_DMA_CHANNEL_2].tc_flag;
+}
+
+void LL_DMA_ClearFlag_GI2(DMA_TypeDef *dma)
+{
+	dma_channels[LL_DMA_CHANNEL_2].tc_flag = FALSE;
+}
+
+void LL_DMA_ClearFlag_GI3(DMA_TypeDef *dma)
+{
+	dma_channels[LL_DMA_CHANNEL_3].tc_flag = FALSE;
+}
+
+/* GPIO, only CS of the chain */
+void LL_GPIO_SetOutputPin(GPIO_TypeDef *port, uint32_t pins)
+{
+	if((pins & LED_CS_Pin) && (cs_low == TRUE))
+	{
+		cs_low = FALSE;
+
+		Sim_MAX7219_latch();
+	}
+}
+
+void LL_GPIO_ResetOutputPin(GPIO_TypeDef *port, uint32_t pins)
+{
+	if(pins & LED_CS_Pin)
+	{
+		cs_low = TRUE;
+		chain_count = 0;
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ * sim_max7219.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* MAX7219 chain on simulated SPI1, fed by its DMA channels, latched on rising CS */
+
+#ifndef SIM_MAX7219_H_
+#define SIM_MAX7219_H_
+
+#include <stdint.h>
+
+#define SIM_MAX7219_CHAIN_LENGTH	3
+#define SIM_MAX7219_NUM_OF_REGS		16
+
+/* Registers */
+#define SIM_MAX7219_NO_OP			0x00
+#define SIM_MAX7219_DIGIT0			0x01
+#define SIM_MAX7219_DECODE_MODE		0x09
+#define SIM_MAX7219_INTENSITY		0x0A
+#define SIM_MAX7219_SCAN_LIMIT		0x0B
+#define SIM_MAX7219_SHUTDOWN		0x0C
+#define SIM_MAX7219_DISPLAY_TEST	0x0F
+
+/* Byte time, SPI1 clock is core clock divided by 256 */
+#define SIM_SPI_BYTE_CYCLES			(8 * 256)
+
+struct sim_max7219_struct
+{
+	uint8_t regs[SIM_MAX7219_NUM_OF_REGS];
+
+	/* Latched writes, no-ops excluded */
+	uint32_t writes;
+};
+
+/* In order of sending, last in chain first, as the display driver numbers them */
+extern struct sim_max7219_struct sim_max7219[SIM_MAX7219_CHAIN_LENGTH];
+
+/* Bus traffic */
+extern uint32_t sim_spi_bytes;
+extern uint32_t sim_max7219_latches;
+extern uint32_t sim_max7219_bad_latches;		/* CS raised mid-byte or after other than a whole packet */
+
+/* Registers as after power-up, SPI idle */
+void Sim_MAX7219_init(void);
+
+/* No byte on the wire and nothing left for DMA */
+uint8_t Sim_SPI_is_idle(void);
+
+#endif /* SIM_MAX7219_H_ */
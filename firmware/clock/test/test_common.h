@@ -0,0 +1,71 @@
+/*
+ * test_common.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+#ifndef TEST_COMMON_H_
+#define TEST_COMMON_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* Checks count failures and go on, so one run shows all of them */
+static uint32_t test_checks = 0;
+static uint32_t test_failures = 0;
+
+#define CHECK(cond)		do { test_checks++; if(!(cond)) { test_failures++; \
+							printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); } } while(0)
+
+#define CHECK_EQUAL(actual, expected)	do { long long a_ = (long long)(actual); long long e_ = (long long)(expected); \
+							test_checks++; if(a_ != e_) { test_failures++; \
+							printf("%s:%d: check failed: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); } } while(0)
+
+#define CHECK_RANGE(actual, min, max)	do { long long a_ = (long long)(actual); \
+							test_checks++; if((a_ < (long long)(min)) || (a_ > (long long)(max))) { test_failures++; \
+							printf("%s:%d: check failed: %s is %lld, expected %lld..%lld\n", __FILE__, __LINE__, #actual, a_, \
+									(long long)(min), (long long)(max)); } } while(0)
+
+static inline int Test_summary(const char *name)
+{
+	printf("%s: %u checks, %u failed\n", name, test_checks, test_failures);
+
+	return (test_failures == 0) ? 0 : 1;
+}
+
+/* Drivers keep state in statics, each case runs in its own process */
+static inline void Test_isolated(const char *name, void (*test)(const void *arg), const void *arg)
+{
+	int status = 0;
+
+	fflush(stdout);
+
+	pid_t pid = fork();
+
+	if(pid == 0)
+	{
+		test_checks = 0;
+		test_failures = 0;
+
+		test(arg);
+
+		printf("  %s: %u checks, %u failed\n", name, test_checks, test_failures);
+		fflush(stdout);
+
+		_exit((test_failures == 0) ? 0 : 1);
+	}
+
+	test_checks++;
+
+	if((pid < 0) || (waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+	{
+		test_failures++;
+		printf("  %s: FAILED\n", name);
+	}
+}
+
+#endif /* TEST_COMMON_H_ */
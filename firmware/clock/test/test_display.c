@@ -0,0 +1,394 @@
+/*
+ * test_display.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* Display driver against a simulated MAX7219 chain, bytes on SPI per update and what the displays show */
+
+#include "test_common.h"
+
+#include <unistd.h>
+
+#include "../Clock/common_defs.h"
+#include "../Clock/display_drv.h"
+
+#include "sim_max7219.h"
+
+#define NUM_OF_DIGITS				8
+
+/* Position of the displays in the chain, in order of sending */
+#define TEMP_DISPLAY				0
+#define DATE_DISPLAY				1
+#define HOUR_DISPLAY				2
+
+/* Whole frame, as sent on every update before the shadow */
+#define OLD_FRAME_BYTES				(NUM_OF_DIGITS * SIM_MAX7219_CHAIN_LENGTH * 2)
+
+/* One row of every display */
+#define PACKET_BYTES				(SIM_MAX7219_CHAIN_LENGTH * 2)
+
+/* Segment bytes of the tables and signs before the font was generated */
+static const uint8_t old_seg_table_hour[10]				= {0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7F, 0x7B};
+static const uint8_t old_seg_table_date_temperature[10]	= {0xDB, 0x42, 0x97, 0xC7, 0x4E, 0xCD, 0xDD, 0x43, 0xDF, 0xCF};
+
+#define OLD_TIME_COLON_ON			0x60
+#define OLD_TIME_E_SIGN				0x4F
+#define OLD_TIME_r_SIGN				0x05
+#define OLD_TIME_o_SIGN				0x1D
+#define OLD_DATE_DP_ON				0x20
+#define OLD_DATE_DEG_SIGN			0x0F
+#define OLD_DATE__I_SIGN			0x42
+#define OLD_DATE_n_SIGN				0x54
+#define OLD_DATE_t_SIGN				0x9C
+#define OLD_DATE_E_SIGN				0x9D
+#define OLD_DATE_MINUS_SIGN			0x04
+#define OLD_BLANK_DISP				0x00
+
+/* Longest a drained queue may take, all slots with a whole packet */
+#define DRAIN_LIMIT_US				20000
+
+/* Bounds a driver waiting for the queue forever */
+#define HANG_LIMIT_S				10
+
+extern const uint8_t seg_table_hour[];
+extern const uint8_t seg_table_date_temperature[];
+
+extern volatile uint32_t display_spi_bytes_last_update;
+
+static struct display_data_struct data;
+
+static uint8_t BCD(uint8_t val)
+{
+	return (uint8_t)(((val / 10) << 4) | (val % 10));
+}
+
+static void Default_data(void)
+{
+	data.hour = 0x12; data.minute = 0x34; data.second = 0x00;
+	data.date = 0x17; data.month = 0x10; data.year = 0x26;
+	data.hour_colon = TRUE;
+	data.int_temperature = 215;
+	data.ext_temperature = 0;
+	data.intensity = 5;
+	data.special_mode = DISPLAY_INT_TEMP;
+}
+
+static void Drain(void)
+{
+	uint32_t us = 0;
+
+	while(((Sim_SPI_is_idle() == FALSE) || (Is_display_busy() == TRUE)) && (us < DRAIN_LIMIT_US))
+	{
+		Host_run_us(10);
+		us += 10;
+	}
+
+	CHECK(us < DRAIN_LIMIT_US);
+}
+
+static void Setup(void)
+{
+	Default_data();
+
+	Sim_MAX7219_init();
+
+	Init_display(data.intensity);
+	Drain();
+}
+
+/* Normal mode, internal temperature of 0 to 99.9*C, from the old tables and signs */
+static void Expected_frame(uint8_t frame[SIM_MAX7219_CHAIN_LENGTH][NUM_OF_DIGITS])
+{
+	const uint8_t *hour = old_seg_table_hour;
+	const uint8_t *date = old_seg_table_date_temperature;
+	uint8_t units = data.int_temperature / 10;
+
+	frame[HOUR_DISPLAY][0] = (data.hour >= 0x10) ? hour[data.hour >> 4] : OLD_BLANK_DISP;
+	frame[HOUR_DISPLAY][1] = hour[data.hour & 0x0F];
+	frame[HOUR_DISPLAY][2] = OLD_TIME_COLON_ON;
+	frame[HOUR_DISPLAY][3] = hour[data.minute >> 4];
+	frame[HOUR_DISPLAY][4] = hour[data.minute & 0x0F];
+	frame[HOUR_DISPLAY][5] = OLD_TIME_COLON_ON;
+	frame[HOUR_DISPLAY][6] = hour[data.second >> 4];
+	frame[HOUR_DISPLAY][7] = hour[data.second & 0x0F];
+
+	frame[DATE_DISPLAY][0] = (data.date >= 0x10) ? date[data.date >> 4] : OLD_BLANK_DISP;
+	frame[DATE_DISPLAY][1] = date[data.date & 0x0F] | OLD_DATE_DP_ON;
+	frame[DATE_DISPLAY][2] = date[data.month >> 4];
+	frame[DATE_DISPLAY][3] = date[data.month & 0x0F] | OLD_DATE_DP_ON;
+	frame[DATE_DISPLAY][4] = date[2];
+	frame[DATE_DISPLAY][5] = date[0];
+	frame[DATE_DISPLAY][6] = date[data.year >> 4];
+	frame[DATE_DISPLAY][7] = date[data.year & 0x0F];
+
+	frame[TEMP_DISPLAY][0] = OLD_BLANK_DISP;
+	frame[TEMP_DISPLAY][1] = OLD_BLANK_DISP;
+	frame[TEMP_DISPLAY][2] = (units >= 10) ? date[units / 10] : OLD_BLANK_DISP;
+	frame[TEMP_DISPLAY][3] = date[units % 10] | OLD_DATE_DP_ON;
+	frame[TEMP_DISPLAY][4] = date[data.int_temperature % 10];
+	frame[TEMP_DISPLAY][5] = OLD_DATE_DEG_SIGN;
+	frame[TEMP_DISPLAY][6] = OLD_BLANK_DISP;
+	frame[TEMP_DISPLAY][7] = OLD_BLANK_DISP;
+}
+
+static uint32_t Shown_mismatches(uint8_t frame[SIM_MAX7219_CHAIN_LENGTH][NUM_OF_DIGITS])
+{
+	uint32_t mismatches = 0;
+
+	for(uint8_t d = 0; d < SIM_MAX7219_CHAIN_LENGTH; d++)
+	{
+		for(uint8_t i = 0; i < NUM_OF_DIGITS; i++)
+		{
+			if(sim_max7219[d].regs[SIM_MAX7219_DIGIT0 + i] != frame[d][i])
+			{
+				printf("  display %u digit %u: 0x%02X, expected 0x%02X\n", d, i,
+						sim_max7219[d].regs[SIM_MAX7219_DIGIT0 + i], frame[d][i]);
+				mismatches++;
+			}
+		}
+	}
+
+	return mismatches;
+}
+
+static uint32_t Update(void)
+{
+	uint32_t bytes_before = sim_spi_bytes;
+
+	Update_display_data(&data);
+	Drain();
+
+	/* Debug counter of the driver agrees with the wire */
+	CHECK_EQUAL(display_spi_bytes_last_update, sim_spi_bytes - bytes_before);
+
+	return sim_spi_bytes - bytes_before;
+}
+
+static void Font(const void *arg)
+{
+	uint8_t frame[SIM_MAX7219_CHAIN_LENGTH][NUM_OF_DIGITS];
+
+	/* Digits, indexed by BCD nibbles */
+	for(uint8_t i = 0; i < 10; i++)
+	{
+		CHECK_EQUAL(seg_table_hour[i], old_seg_table_hour[i]);
+		CHECK_EQUAL(seg_table_date_temperature[i], old_seg_table_date_temperature[i]);
+	}
+
+	Setup();
+
+	/* Configuration as before */
+	for(uint8_t d = 0; d < SIM_MAX7219_CHAIN_LENGTH; d++)
+	{
+		CHECK_EQUAL(sim_max7219[d].regs[SIM_MAX7219_SHUTDOWN], 0x01);
+		CHECK_EQUAL(sim_max7219[d].regs[SIM_MAX7219_SCAN_LIMIT], 0x07);
+		CHECK_EQUAL(sim_max7219[d].regs[SIM_MAX7219_DECODE_MODE], 0x00);
+		CHECK_EQUAL(sim_max7219[d].regs[SIM_MAX7219_DISPLAY_TEST], 0x00);
+		CHECK_EQUAL(sim_max7219[d].regs[SIM_MAX7219_INTENSITY], data.intensity);
+	}
+
+	/* Every digit in every position, blanked leading zeros and signs of normal mode */
+	for(uint8_t i = 0; i < 10; i++)
+	{
+		data.hour = BCD(i); data.minute = BCD(i * 11); data.second = BCD(((i + 1) % 10) * 11);
+		data.date = BCD(i + 20); data.month = BCD(i * 11); data.year = BCD(((i + 5) % 10) * 11);
+		data.int_temperature = (i * 111) % 1000;
+
+		Update();
+		Expected_frame(frame);
+
+		CHECK_EQUAL(Shown_mismatches(frame), 0);
+	}
+
+	/* Error message */
+	data.special_mode = DISPLAY_DEMO;
+	Update();
+
+	CHECK_EQUAL(sim_max7219[HOUR_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 0], OLD_TIME_E_SIGN);
+	CHECK_EQUAL(sim_max7219[HOUR_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 1], OLD_TIME_r_SIGN);
+	CHECK_EQUAL(sim_max7219[HOUR_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 3], OLD_TIME_r_SIGN);
+	CHECK_EQUAL(sim_max7219[HOUR_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 4], OLD_TIME_o_SIGN);
+	CHECK_EQUAL(sim_max7219[HOUR_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 6], OLD_TIME_r_SIGN);
+	CHECK_EQUAL(sim_max7219[HOUR_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 7], OLD_TIME_r_SIGN);
+
+	/* Intensity setting, shown one based */
+	data.special_mode = DISPLAY_INTENSITY;
+	data.intensity = 11;
+	Update();
+
+	CHECK_EQUAL(sim_max7219[DATE_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 0], OLD_DATE__I_SIGN);
+	CHECK_EQUAL(sim_max7219[DATE_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 1], OLD_DATE_n_SIGN);
+	CHECK_EQUAL(sim_max7219[DATE_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 2], OLD_DATE_t_SIGN);
+	CHECK_EQUAL(sim_max7219[DATE_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 3], OLD_BLANK_DISP);
+	CHECK_EQUAL(sim_max7219[DATE_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 4], OLD_DATE_MINUS_SIGN);
+	CHECK_EQUAL(sim_max7219[DATE_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 5], old_seg_table_date_temperature[1]);
+	CHECK_EQUAL(sim_max7219[DATE_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 6], old_seg_table_date_temperature[2]);
+	CHECK_EQUAL(sim_max7219[DATE_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 7], OLD_DATE_MINUS_SIGN);
+
+	/* External temperature below zero, -5.5*C */
+	data.special_mode = DISPLAY_EXT_TEMP;
+	data.ext_temperature = -55;
+	Update();
+
+	CHECK_EQUAL(sim_max7219[TEMP_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 0], OLD_DATE_E_SIGN);
+	CHECK_EQUAL(sim_max7219[TEMP_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 1], OLD_DATE_MINUS_SIGN);
+	CHECK_EQUAL(sim_max7219[TEMP_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 2], OLD_BLANK_DISP);
+	CHECK_EQUAL(sim_max7219[TEMP_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 3], old_seg_table_date_temperature[5] | OLD_DATE_DP_ON);
+	CHECK_EQUAL(sim_max7219[TEMP_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 4], old_seg_table_date_temperature[5]);
+	CHECK_EQUAL(sim_max7219[TEMP_DISPLAY].regs[SIM_MAX7219_DIGIT0 + 5], OLD_DATE_DEG_SIGN);
+
+	CHECK_EQUAL(sim_max7219_bad_latches, 0);
+}
+
+static void Bytes_per_update(const void *arg)
+{
+	uint8_t frame[SIM_MAX7219_CHAIN_LENGTH][NUM_OF_DIGITS];
+	uint32_t updates = 0;
+	uint32_t old_bytes = 0;
+	uint32_t new_bytes = 0;
+	uint32_t seconds_units = 0;
+	uint32_t seconds_tens = 0;
+
+	Setup();
+
+	/* First update fills the displays */
+	CHECK_EQUAL(Update(), OLD_FRAME_BYTES);
+	updates++;
+
+	/* One minute at update rate, only seconds change */
+	for(uint8_t second = 1; second < 60; second++)
+	{
+		for(uint8_t tick = 0; tick < LED_DATA_UPDATE_FREQUENCY; tick++)
+		{
+			uint32_t bytes;
+			uint32_t expected = 0;
+
+			data.second = BCD(second);
+
+			bytes = Update();
+			updates++;
+
+			old_bytes += OLD_FRAME_BYTES;
+			new_bytes += bytes;
+
+			/* Whole frame from time to time, otherwise changed rows only */
+			if((updates % LED_DATA_FULL_REFRESH_CNTR_MAX) == 0)
+			{
+				expected = OLD_FRAME_BYTES;
+			}
+			else if((tick == 0) && ((second % 10) == 0))
+			{
+				expected = 2 * PACKET_BYTES;
+				seconds_tens++;
+			}
+			else if(tick == 0)
+			{
+				expected = PACKET_BYTES;
+				seconds_units++;
+			}
+
+			CHECK_EQUAL(bytes, expected);
+		}
+	}
+
+	printf("  %u updates: full frame %u bytes, changed rows %u bytes (%u of %u, %u of %u)\n", updates - 1,
+			old_bytes, new_bytes, seconds_units, PACKET_BYTES, seconds_tens, 2 * PACKET_BYTES);
+
+	/* Displays show the same as with whole frames */
+	Expected_frame(frame);
+	CHECK_EQUAL(Shown_mismatches(frame), 0);
+
+	CHECK(seconds_units > 0);
+	CHECK(seconds_tens > 0);
+	CHECK(new_bytes * 10 < old_bytes);
+	CHECK_EQUAL(sim_max7219_bad_latches, 0);
+}
+
+static void Config_on_change(const void *arg)
+{
+	uint32_t bytes_before;
+
+	Setup();
+
+	/* Unchanged intensity, only periodic rewrite of all config registers */
+	bytes_before = sim_spi_bytes;
+
+	for(uint32_t i = 0; i < (2 * LED_CFG_FULL_REFRESH_CNTR_MAX); i++)
+	{
+		Update_display_config(&data);
+		Drain();
+	}
+
+	CHECK_EQUAL(sim_spi_bytes - bytes_before, 2 * 5 * PACKET_BYTES);
+
+	/* Changed intensity, one packet */
+	data.intensity = 9;
+	bytes_before = sim_spi_bytes;
+
+	Update_display_config(&data);
+	Drain();
+
+	CHECK_EQUAL(sim_spi_bytes - bytes_before, PACKET_BYTES);
+
+	for(uint8_t d = 0; d < SIM_MAX7219_CHAIN_LENGTH; d++)
+	{
+		CHECK_EQUAL(sim_max7219[d].regs[SIM_MAX7219_INTENSITY], 9);
+	}
+
+	CHECK_EQUAL(sim_max7219_bad_latches, 0);
+}
+
+static void Full_queue(const void *arg)
+{
+	uint8_t frame[SIM_MAX7219_CHAIN_LENGTH][NUM_OF_DIGITS];
+	uint32_t bytes_before;
+
+	Setup();
+	Update();
+
+	/* DMA lent to I2C, nothing leaves the queue */
+	CHECK(Claim_display_DMA() == TRUE);
+
+	bytes_before = sim_spi_bytes;
+
+	/* Driver must not wait for the queue in the main loop */
+	alarm(HANG_LIMIT_S);
+
+	/* Every digit row changes, more packets than the queue holds */
+	for(uint8_t i = 1; i <= 5; i++)
+	{
+		data.hour = BCD(i); data.minute = BCD(i * 11); data.second = BCD(i * 11);
+		data.date = BCD(i + 10); data.month = BCD(i); data.year = BCD(i * 11);
+		data.int_temperature = i * 111;
+
+		Update_display_data(&data);
+		Update_display_config(&data);
+	}
+
+	alarm(0);
+
+	CHECK_EQUAL(sim_spi_bytes, bytes_before);
+
+	/* Queued packets go out, dropped rows with the next update */
+	Release_display_DMA();
+	Drain();
+
+	Update();
+
+	Expected_frame(frame);
+	CHECK_EQUAL(Shown_mismatches(frame), 0);
+
+	CHECK_EQUAL(sim_max7219_bad_latches, 0);
+}
+
+int main(void)
+{
+	Test_isolated("font", Font, NULL);
+	Test_isolated("bytes per update", Bytes_per_update, NULL);
+	Test_isolated("config on change", Config_on_change, NULL);
+	Test_isolated("full queue", Full_queue, NULL);
+
+	return Test_summary("test_display");
+}
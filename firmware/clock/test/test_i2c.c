@@ -0,0 +1,625 @@
+/*
+ * test_i2c.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* I2C driver against simulated I2C1, DMA and a memory-like slave */
+
+#include <string.h>
+
+#include "test_common.h"
+
+#include "../Clock/common_defs.h"
+#include "../Clock/i2c_drv.h"
+#include "../Clock/scheduler.h"
+
+#include "sim_i2c.h"
+
+#define MEMORY_ADDR				0xA0
+#define SECOND_MEMORY_ADDR		0xA2
+#define ABSENT_ADDR				0x42
+
+/* Bits of a register read: START and address, register, repeated START and address, data, STOP */
+#define READ_DATA_BITS(len)		(10 + 9 + 10 + (9 * (len)) + 1)
+
+/* Main loop: spins, other work between passes, one sensor read per tick */
+#define LOOP_IDLE_US			20
+#define LOOP_SENSOR_READ_LEN	2
+
+/* Recovery: 9 pulses, STOP and settling, 5us half periods, plus register accesses */
+#define RECOVERY_COUNTS			15
+
+/* Read out with debugger on target */
+extern volatile uint32_t i2c_irq_count;
+extern volatile uint32_t i2c_dma_transfers;
+extern volatile uint32_t i2c_irq_transfers;
+
+/* Register file, first written byte sets the pointer */
+static uint8_t memory[256];
+static uint8_t memory_pointer = 0;
+static uint8_t memory_pointer_set = FALSE;
+static uint8_t memory_nack = FALSE;
+
+/* Slave gets stuck in the middle of next read, as if master was reset */
+static uint8_t memory_stick_armed = FALSE;
+static uint32_t memory_stick_pulses = 0;
+
+static uint8_t Memory_start(uint8_t read)
+{
+	if(read == FALSE)
+	{
+		memory_pointer_set = FALSE;
+	}
+
+	return (memory_nack == FALSE) ? TRUE : FALSE;
+}
+
+static uint8_t Memory_write(uint8_t data)
+{
+	if(memory_pointer_set == FALSE)
+	{
+		memory_pointer = data;
+		memory_pointer_set = TRUE;
+	}
+	else
+	{
+		memory[memory_pointer++] = data;
+	}
+
+	return TRUE;
+}
+
+static uint8_t Memory_read(void)
+{
+	if(memory_stick_armed == TRUE)
+	{
+		memory_stick_armed = FALSE;
+
+		Sim_I2C_stick_SDA(memory_stick_pulses);
+	}
+
+	return memory[memory_pointer++];
+}
+
+static void Memory_stop(void)
+{
+}
+
+static struct sim_i2c_slave_struct memory_slave = {MEMORY_ADDR, Memory_start, Memory_write, Memory_read, Memory_stop, 0, 0};
+
+/* Same register file under another address */
+static struct sim_i2c_slave_struct second_memory_slave = {SECOND_MEMORY_ADDR, Memory_start, Memory_write, Memory_read, Memory_stop, 0, 0};
+
+static uint8_t static_buffer[16];
+
+/* Copies taken by the dump hook */
+static struct i2c_device_stats_struct dumped[8];
+static uint8_t num_of_dumped = 0;
+
+static void Dump(const struct i2c_device_stats_struct *stats)
+{
+	if(num_of_dumped < (sizeof(dumped) / sizeof(dumped[0])))
+	{
+		dumped[num_of_dumped++] = *stats;
+	}
+}
+
+static const struct i2c_device_stats_struct *Dumped_stats(uint8_t device_addr)
+{
+	num_of_dumped = 0;
+
+	I2C_Dump_stats(Dump);
+
+	for(uint8_t i = 0; i < num_of_dumped; i++)
+	{
+		if(dumped[i].device_addr == device_addr)
+		{
+			return &dumped[i];
+		}
+	}
+
+	return NULL;
+}
+
+static uint32_t Bits_to_counts(uint32_t bits)
+{
+	return (bits * Sim_I2C_get_bit_cycles()) / HOST_CYCLES_PER_COUNT;
+}
+
+struct loop_stats_struct
+{
+	uint32_t pass_max;			/* Longest main loop pass, TIM14 counts */
+	uint32_t long_passes;		/* Passes, which waited for I2C timeout */
+	uint32_t reads;
+	uint32_t failed_reads;
+};
+
+/* Main loop for given time, as Run does it */
+static void Run_loop(uint32_t ms, struct loop_stats_struct *loop_stats)
+{
+	uint8_t buffer[LOOP_SENSOR_READ_LEN];
+	uint64_t end = Host_get_cycles() + ((uint64_t)ms * HOST_CYCLES_PER_MS);
+	uint32_t last_tick = Get_scheduler_tick();
+
+	*loop_stats = (struct loop_stats_struct){0};
+
+	while(Host_get_cycles() < end)
+	{
+		uint32_t pass_start = Get_scheduler_time();
+
+		Manage_I2C();
+
+		if(Get_scheduler_tick() != last_tick)
+		{
+			last_tick = Get_scheduler_tick();
+
+			loop_stats->reads++;
+
+			if(I2C_Read_Data(MEMORY_ADDR, 0x30, buffer, sizeof(buffer)) == FALSE)
+			{
+				loop_stats->failed_reads++;
+			}
+		}
+
+		uint32_t pass_time = Get_scheduler_time() - pass_start;
+
+		if(pass_time > loop_stats->pass_max)
+		{
+			loop_stats->pass_max = pass_time;
+		}
+
+		if(pass_time >= SCHEDULER_US_TO_COUNTS(1000))
+		{
+			loop_stats->long_passes++;
+		}
+
+		Host_run_us(LOOP_IDLE_US);
+	}
+}
+
+static void Setup(void)
+{
+	for(uint32_t i = 0; i < sizeof(memory); i++)
+	{
+		memory[i] = (uint8_t)(i ^ 0x5A);
+	}
+
+	Sim_I2C_init();
+	Sim_I2C_add_slave(&memory_slave);
+	Sim_I2C_add_slave(&second_memory_slave);
+
+	Init_I2C();
+}
+
+static void DMA_read(const void *arg)
+{
+	uint8_t stack_buffer[16];
+
+	Setup();
+
+	/* Caller buffers on stack and in RAM, both go straight to DMA */
+	CHECK(I2C_Read_Data(MEMORY_ADDR, 0x10, stack_buffer, sizeof(stack_buffer)) == TRUE);
+	CHECK(memcmp(stack_buffer, &memory[0x10], sizeof(stack_buffer)) == 0);
+
+	CHECK(I2C_Read_Data(MEMORY_ADDR, 0x40, static_buffer, sizeof(static_buffer)) == TRUE);
+	CHECK(memcmp(static_buffer, &memory[0x40], sizeof(static_buffer)) == 0);
+
+	CHECK_EQUAL(i2c_dma_transfers, 2);
+	CHECK_EQUAL(i2c_irq_transfers, 0);
+
+	/* Register address, repeated start and STOP only, not one per byte */
+	CHECK_RANGE(i2c_irq_count, 1, 6);
+
+	/* Channels given back to display */
+	CHECK(host_dma_claimed == FALSE);
+}
+
+static void DMA_write(const void *arg)
+{
+	uint8_t stack_buffer[16];
+
+	Setup();
+
+	for(uint8_t i = 0; i < sizeof(stack_buffer); i++)
+	{
+		stack_buffer[i] = 0xC0 + i;
+	}
+
+	CHECK(I2C_Write_Data(MEMORY_ADDR, 0x20, stack_buffer, sizeof(stack_buffer)) == TRUE);
+	CHECK(memcmp(stack_buffer, &memory[0x20], sizeof(stack_buffer)) == 0);
+
+	/* Address, register address, data */
+	CHECK_EQUAL(memory_slave.bytes, 2 + sizeof(stack_buffer));
+	CHECK_EQUAL(memory_slave.transactions, 1);
+
+	CHECK_EQUAL(i2c_dma_transfers, 1);
+	CHECK_RANGE(i2c_irq_count, 1, 3);
+	CHECK(host_dma_claimed == FALSE);
+}
+
+static void Display_holds_DMA(const void *arg)
+{
+	uint8_t buffer[16];
+
+	Setup();
+
+	/* Same transfers by interrupts */
+	host_display_busy = TRUE;
+
+	CHECK(I2C_Read_Data(MEMORY_ADDR, 0x80, buffer, sizeof(buffer)) == TRUE);
+	CHECK(memcmp(buffer, &memory[0x80], sizeof(buffer)) == 0);
+
+	memset(buffer, 0xA5, sizeof(buffer));
+
+	CHECK(I2C_Write_Data(MEMORY_ADDR, 0x90, buffer, sizeof(buffer)) == TRUE);
+	CHECK(memcmp(buffer, &memory[0x90], sizeof(buffer)) == 0);
+
+	CHECK_EQUAL(i2c_dma_transfers, 0);
+	CHECK_EQUAL(i2c_irq_transfers, 2);
+
+	/* At least one interrupt per byte */
+	CHECK(i2c_irq_count >= (2 * sizeof(buffer)));
+}
+
+static void Short_transfers(const void *arg)
+{
+	uint8_t data = 0;
+
+	Setup();
+
+	/* Below DMA minimum, cheaper by interrupts */
+	CHECK(I2C_Write_Register(MEMORY_ADDR, 0x05, 0x3C) == TRUE);
+	CHECK(I2C_Read_Register(MEMORY_ADDR, 0x05, &data) == TRUE);
+
+	CHECK_EQUAL(data, 0x3C);
+	CHECK_EQUAL(i2c_dma_transfers, 0);
+	CHECK_EQUAL(i2c_irq_transfers, 2);
+}
+
+static void Device_stats(const void *arg)
+{
+	uint8_t buffer[8];
+	const struct i2c_device_stats_struct *stats;
+
+	Setup();
+
+	for(uint8_t i = 0; i < 10; i++)
+	{
+		CHECK(I2C_Read_Data(MEMORY_ADDR, i, buffer, sizeof(buffer)) == TRUE);
+	}
+
+	for(uint8_t i = 0; i < 5; i++)
+	{
+		CHECK(I2C_Write_Data(SECOND_MEMORY_ADDR, i, buffer, 2) == TRUE);
+	}
+
+	stats = Dumped_stats(MEMORY_ADDR);
+	CHECK(stats != NULL);
+
+	if(stats != NULL)
+	{
+		CHECK_EQUAL(stats->transactions, 10);
+		CHECK_EQUAL(stats->bytes, 10 * sizeof(buffer));
+		CHECK_EQUAL(stats->nacks, 0);
+		CHECK_EQUAL(stats->bus_errors, 0);
+		CHECK_EQUAL(stats->timeouts, 0);
+
+		/* Bus time, plus interrupt latency */
+		CHECK_RANGE(stats->duration_min, Bits_to_counts(READ_DATA_BITS(sizeof(buffer))), Bits_to_counts(READ_DATA_BITS(sizeof(buffer))) + 5);
+		CHECK(stats->duration_max >= stats->duration_min);
+		CHECK_RANGE(stats->duration_total / stats->transactions, stats->duration_min, stats->duration_max);
+
+		printf("  0x%02X: %u transactions, %u bytes, duration %u/%u/%u counts\n", stats->device_addr, stats->transactions,
+				stats->bytes, stats->duration_min, stats->duration_total / stats->transactions, stats->duration_max);
+	}
+
+	stats = Dumped_stats(SECOND_MEMORY_ADDR);
+	CHECK(stats != NULL);
+
+	if(stats != NULL)
+	{
+		CHECK_EQUAL(stats->transactions, 5);
+		CHECK_EQUAL(stats->bytes, 5 * 2);
+	}
+
+	CHECK_EQUAL(num_of_dumped, 2);
+
+	/* Entries are taken again afterwards */
+	I2C_Clear_stats();
+
+	CHECK(Dumped_stats(MEMORY_ADDR) == NULL);
+	CHECK_EQUAL(num_of_dumped, 0);
+
+	CHECK(I2C_Read_Data(MEMORY_ADDR, 0, buffer, sizeof(buffer)) == TRUE);
+
+	stats = Dumped_stats(MEMORY_ADDR);
+	CHECK((stats != NULL) && (stats->transactions == 1));
+}
+
+static void NACK_stats(const void *arg)
+{
+	const struct i2c_device_stats_struct *stats;
+
+	Setup();
+
+	CHECK(I2C_Check_Addr(ABSENT_ADDR) == FALSE);
+	CHECK(I2C_Check_Addr(MEMORY_ADDR) == TRUE);
+
+	stats = Dumped_stats(ABSENT_ADDR);
+	CHECK((stats != NULL) && (stats->nacks == 1) && (stats->transactions == 1) && (stats->bytes == 0));
+
+	stats = Dumped_stats(MEMORY_ADDR);
+	CHECK((stats != NULL) && (stats->nacks == 0) && (stats->transactions == 1));
+
+	/* Fourth and further devices share the last entry */
+	CHECK(I2C_Check_Addr(0x10) == FALSE);
+	CHECK(I2C_Check_Addr(0x12) == FALSE);
+	CHECK(I2C_Check_Addr(0x14) == FALSE);
+
+	stats = Dumped_stats(I2C_STATS_OTHER_DEVICES);
+	CHECK((stats != NULL) && (stats->nacks == 2) && (stats->transactions == 2));
+
+	CHECK_EQUAL(num_of_dumped, 4);
+}
+
+static void Bus_error_stats(const void *arg)
+{
+	uint8_t buffer[8];
+	const struct i2c_device_stats_struct *stats;
+	struct i2c_recovery_stats_struct recovery_stats;
+
+	Setup();
+
+	/* Other master takes the bus */
+	Sim_I2C_inject_ARLO();
+
+	CHECK(I2C_Read_Data(MEMORY_ADDR, 0, buffer, sizeof(buffer)) == FALSE);
+
+	/* Bus released, next transfer goes on */
+	CHECK(I2C_Read_Data(MEMORY_ADDR, 0, buffer, sizeof(buffer)) == TRUE);
+	CHECK(memcmp(buffer, &memory[0], sizeof(buffer)) == 0);
+
+	stats = Dumped_stats(MEMORY_ADDR);
+	CHECK((stats != NULL) && (stats->bus_errors == 1) && (stats->resets == 1) && (stats->transactions == 2));
+
+	Get_I2C_recovery_stats(&recovery_stats);
+	CHECK_EQUAL(recovery_stats.recoveries, 1);
+	CHECK_EQUAL(recovery_stats.recovery_failures, 0);
+
+	/* Slave kept SDA low, START never came */
+	Sim_I2C_stick_SDA(2);
+
+	uint64_t start = Host_get_cycles();
+
+	CHECK(I2C_Read_Data(MEMORY_ADDR, 0, buffer, sizeof(buffer)) == FALSE);
+
+	/* Timeout, then released by recovery */
+	CHECK_RANGE(Host_get_cycles() - start, 4 * HOST_CYCLES_PER_MS, 6 * HOST_CYCLES_PER_MS);
+
+	CHECK(I2C_Read_Data(MEMORY_ADDR, 0, buffer, sizeof(buffer)) == TRUE);
+
+	stats = Dumped_stats(MEMORY_ADDR);
+	CHECK((stats != NULL) && (stats->timeouts == 1) && (stats->resets == 2));
+}
+
+static void Speed_fallback(const void *arg)
+{
+	uint8_t data;
+	const struct i2c_device_stats_struct *stats;
+
+	Setup();
+
+	I2C_Set_device_speed(MEMORY_ADDR, I2C_FAST_MODE_PLUS);
+
+	CHECK(I2C_Read_Register(MEMORY_ADDR, 0, &data) == TRUE);
+	CHECK(Sim_I2C_is_fast_mode_plus() == TRUE);
+
+	/* Errors in a row, one step slower */
+	memory_nack = TRUE;
+
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		CHECK(I2C_Read_Register(MEMORY_ADDR, 0, &data) == FALSE);
+	}
+
+	memory_nack = FALSE;
+
+	CHECK_EQUAL(Get_I2C_device_speed(MEMORY_ADDR), I2C_FAST_MODE);
+
+	CHECK(I2C_Read_Register(MEMORY_ADDR, 0, &data) == TRUE);
+	CHECK(Sim_I2C_is_fast_mode_plus() == FALSE);
+
+	stats = Dumped_stats(MEMORY_ADDR);
+	CHECK((stats != NULL) && (stats->speed_fallbacks == 1) && (stats->nacks == 3));
+
+	/* Back to full speed after a long run without errors */
+	uint16_t good_transfers = 0;
+
+	for(uint16_t i = 0; i < 999; i++)
+	{
+		good_transfers += I2C_Read_Register(MEMORY_ADDR, 0, &data);
+	}
+
+	CHECK_EQUAL(good_transfers, 999);
+
+	CHECK_EQUAL(Get_I2C_device_speed(MEMORY_ADDR), I2C_FAST_MODE_PLUS);
+}
+
+static void Speed_change_in_main_loop(const void *arg)
+{
+	uint8_t fast_data[4];
+	uint8_t slow_data[4];
+
+	struct i2c_request_struct fast = {I2C_REQ_READ_DATA, MEMORY_ADDR, 0x10, fast_data, sizeof(fast_data), I2C_PRIORITY_NORMAL, I2C_REQ_IDLE, 0, 0, NULL};
+	struct i2c_request_struct slow = {I2C_REQ_READ_DATA, SECOND_MEMORY_ADDR, 0x20, slow_data, sizeof(slow_data), I2C_PRIORITY_NORMAL, I2C_REQ_IDLE, 0, 0, NULL};
+
+	Setup();
+
+	/* Second memory stays at standard mode */
+	I2C_Set_device_speed(MEMORY_ADDR, I2C_FAST_MODE_PLUS);
+
+	/* Slow one is queued behind, would be started from the interrupt ending the fast one */
+	CHECK(I2C_Submit(&fast) == TRUE);
+	CHECK(I2C_Submit(&slow) == TRUE);
+	CHECK(Sim_I2C_is_fast_mode_plus() == TRUE);
+
+	while(Is_I2C_idle() == FALSE)
+	{
+		Host_run_us(LOOP_IDLE_US);
+
+		Manage_I2C();
+	}
+
+	CHECK_EQUAL(fast.status, I2C_REQ_DONE);
+	CHECK_EQUAL(slow.status, I2C_REQ_DONE);
+	CHECK(memcmp(fast_data, &memory[0x10], sizeof(fast_data)) == 0);
+	CHECK(memcmp(slow_data, &memory[0x20], sizeof(slow_data)) == 0);
+
+	/* PE and FM+ drive were switched by the main loop only */
+	CHECK(Sim_I2C_is_fast_mode_plus() == FALSE);
+	CHECK_EQUAL(Sim_I2C_get_timing_writes_in_irq(), 0);
+}
+
+static void Wait_stats(const void *arg)
+{
+	uint8_t first_buffer[16];
+	uint8_t second_buffer[16];
+	const struct i2c_device_stats_struct *stats;
+
+	struct i2c_request_struct first = {I2C_REQ_READ_DATA, MEMORY_ADDR, 0, first_buffer, sizeof(first_buffer), I2C_PRIORITY_NORMAL, I2C_REQ_IDLE, 0, 0, NULL};
+	struct i2c_request_struct second = {I2C_REQ_READ_DATA, SECOND_MEMORY_ADDR, 0, second_buffer, sizeof(second_buffer), I2C_PRIORITY_NORMAL, I2C_REQ_IDLE, 0, 0, NULL};
+
+	Setup();
+
+	/* Second waits for the first in the queue */
+	CHECK(I2C_Submit(&first) == TRUE);
+	CHECK(I2C_Submit(&second) == TRUE);
+
+	while(Is_I2C_idle() == FALSE)
+	{
+		Manage_I2C();
+	}
+
+	CHECK_EQUAL(first.status, I2C_REQ_DONE);
+	CHECK_EQUAL(second.status, I2C_REQ_DONE);
+
+	stats = Dumped_stats(MEMORY_ADDR);
+	CHECK((stats != NULL) && (stats->wait_max <= 1));
+
+	stats = Dumped_stats(SECOND_MEMORY_ADDR);
+	CHECK((stats != NULL) && (stats->wait_max >= Bits_to_counts(READ_DATA_BITS(sizeof(first_buffer)))));
+}
+
+static void Stuck_mid_byte(const void *arg)
+{
+	struct loop_stats_struct loop_stats;
+	struct i2c_recovery_stats_struct recovery_stats;
+
+	Setup();
+
+	Run_loop(1000, &loop_stats);
+
+	uint32_t nominal = loop_stats.pass_max;
+
+	CHECK_EQUAL(loop_stats.failed_reads, 0);
+
+	/* Slave lets go after a few clock pulses */
+	memory_stick_armed = TRUE;
+	memory_stick_pulses = 3;
+
+	Run_loop(1000, &loop_stats);
+
+	/* One tick waits for the timeout, the bus is recovered right after */
+	CHECK_EQUAL(loop_stats.failed_reads, 1);
+	CHECK_EQUAL(loop_stats.long_passes, 1);
+	CHECK(Sim_I2C_is_SDA_stuck() == FALSE);
+
+	Get_I2C_recovery_stats(&recovery_stats);
+	CHECK_EQUAL(recovery_stats.recoveries, 1);
+	CHECK_EQUAL(recovery_stats.recovery_failures, 0);
+	CHECK_EQUAL(recovery_stats.rejected_requests, 0);
+
+	/* Back to nominal tick budget */
+	Run_loop(1000, &loop_stats);
+
+	CHECK_EQUAL(loop_stats.failed_reads, 0);
+	CHECK_RANGE(loop_stats.pass_max, 0, nominal);
+
+	printf("  nominal pass %u counts, %u SCL pulses\n", nominal, Sim_I2C_get_SCL_pulses());
+}
+
+static void Stuck_for_seconds(const void *arg)
+{
+	struct loop_stats_struct loop_stats;
+	struct i2c_recovery_stats_struct recovery_stats;
+
+	Setup();
+
+	Run_loop(1000, &loop_stats);
+
+	uint32_t nominal = loop_stats.pass_max;
+
+	/* Slave does not let go, until power cycled */
+	memory_stick_armed = TRUE;
+	memory_stick_pulses = SIM_I2C_STUCK_FOREVER;
+
+	Run_loop(5000, &loop_stats);
+
+	/* Timeout only once, then reads fail fast */
+	CHECK_EQUAL(loop_stats.long_passes, 1);
+	CHECK_EQUAL(loop_stats.failed_reads, loop_stats.reads);
+
+	Get_I2C_recovery_stats(&recovery_stats);
+
+	/* Attempts after 0, 8, 24, 56 ... 4088ms */
+	CHECK_EQUAL(recovery_stats.recoveries, 0);
+	CHECK_EQUAL(recovery_stats.recovery_failures, 10);
+	CHECK_EQUAL(recovery_stats.backoff, 4096);
+	CHECK_RANGE(recovery_stats.rejected_requests, loop_stats.reads - 12, loop_stats.reads);
+	CHECK_RANGE(recovery_stats.degraded_time, 4900, 5000);
+
+	printf("  stuck: %u reads failed, %u recovery attempts, %u rejected, pass max %u counts\n", loop_stats.failed_reads,
+			recovery_stats.recovery_failures, recovery_stats.rejected_requests, loop_stats.pass_max);
+
+	/* Ticks after the first cost one recovery attempt at most */
+	Run_loop(3000, &loop_stats);
+
+	CHECK_EQUAL(loop_stats.long_passes, 0);
+	CHECK_RANGE(loop_stats.pass_max, 0, nominal + RECOVERY_COUNTS);
+
+	/* Slave power cycled, found free by next attempt after 8184ms */
+	Sim_I2C_release_SDA();
+
+	Run_loop(500, &loop_stats);
+
+	Get_I2C_recovery_stats(&recovery_stats);
+	CHECK_EQUAL(recovery_stats.recoveries, 1);
+	CHECK_EQUAL(recovery_stats.backoff, 0);
+	CHECK(loop_stats.failed_reads < loop_stats.reads);
+
+	/* Back to nominal tick budget */
+	Run_loop(1000, &loop_stats);
+
+	CHECK_EQUAL(loop_stats.failed_reads, 0);
+	CHECK_RANGE(loop_stats.pass_max, 0, nominal);
+}
+
+int main(void)
+{
+	Test_isolated("DMA read", DMA_read, NULL);
+	Test_isolated("DMA write", DMA_write, NULL);
+	Test_isolated("display holds DMA", Display_holds_DMA, NULL);
+	Test_isolated("short transfers", Short_transfers, NULL);
+	Test_isolated("device stats", Device_stats, NULL);
+	Test_isolated("NACK stats", NACK_stats, NULL);
+	Test_isolated("bus error stats", Bus_error_stats, NULL);
+	Test_isolated("speed fallback", Speed_fallback, NULL);
+	Test_isolated("speed change in main loop", Speed_change_in_main_loop, NULL);
+	Test_isolated("wait stats", Wait_stats, NULL);
+	Test_isolated("stuck mid-byte", Stuck_mid_byte, NULL);
+	Test_isolated("stuck for seconds", Stuck_for_seconds, NULL);
+
+	return Test_summary("test_i2c");
+}
@@ -0,0 +1,326 @@
+/*
+ * test_onewire.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* ROM search and multi-sensor polling, through a simulated DS2482 on a multi-drop 1-Wire bus */
+
+#include "test_common.h"
+
+#include "../Clock/common_defs.h"
+#include "../Clock/i2c_drv.h"
+#include "../Clock/onewire_bridge_drv.h"
+#include "../Clock/ext_temp_sens_drv.h"
+#include "../Clock/scheduler.h"
+
+#include "sim_ds2482.h"
+
+/* Reset, MATCH ROM, ROM code, READ SCRATCHPAD and 9 bytes, with status polls, per sensor */
+#define SENSOR_READ_BUDGET			SCHEDULER_US_TO_COUNTS(20000)
+
+extern volatile uint32_t ext_temp_reconfigurations;
+
+static struct sim_onewire_device_struct devices[SIM_ONEWIRE_MAX_DEVICES];
+
+static void Setup(void)
+{
+	Sim_I2C_init();
+	Sim_DS2482_init();
+
+	Init_I2C();
+
+	CHECK(Init_OneWire_bridge() == TRUE);
+}
+
+static void Add_sensor(uint8_t index, uint8_t family, uint32_t serial, int16_t temperature)
+{
+	devices[index].temperature = temperature;
+
+	Sim_OneWire_add_device(&devices[index], family, serial);
+}
+
+static uint8_t Was_found(const uint8_t roms[][ONEWIRE_ROM_SIZE], uint8_t num_of_roms, const uint8_t *rom)
+{
+	uint8_t found = 0;
+
+	for(uint8_t i = 0; i < num_of_roms; i++)
+	{
+		uint8_t j = 0;
+
+		while((j < ONEWIRE_ROM_SIZE) && (roms[i][j] == rom[j]))
+		{
+			j++;
+		}
+
+		if(j == ONEWIRE_ROM_SIZE)
+		{
+			found++;
+		}
+	}
+
+	return found;
+}
+
+static uint8_t Was_measured(int16_t expected)
+{
+	int16_t temperature;
+
+	for(uint8_t i = 0; i < Get_ext_temp_sensor_count(); i++)
+	{
+		if((Ext_temp_read_temperature(i, &temperature) == TRUE) && (temperature == expected))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static uint8_t Measure(uint32_t *elapsed)
+{
+	uint8_t status;
+	uint32_t start = Get_scheduler_time();
+
+	/* As from main loop, one operation per step */
+	if(Ext_temp_start_measurement() == FALSE)
+	{
+		return EXT_TEMP_FAILED;
+	}
+
+	do
+	{
+		status = Ext_temp_step();
+
+		Manage_I2C();
+	}
+	while(status == EXT_TEMP_BUSY);
+
+	*elapsed = Get_scheduler_time() - start;
+
+	return status;
+}
+
+static void Search(const void *arg)
+{
+	uint8_t roms[SIM_ONEWIRE_MAX_DEVICES][ONEWIRE_ROM_SIZE];
+	struct onewire_stats_struct stats;
+
+	Setup();
+
+	/* First two differ in lowest serial bits only */
+	Add_sensor(0, SIM_DS18B20_FAMILY, 0x000001, 0);
+	Add_sensor(1, SIM_DS18B20_FAMILY, 0x000002, 0);
+	Add_sensor(2, SIM_DS28EA00_FAMILY, 0x123456, 0);
+	Add_sensor(3, SIM_DS2401_FAMILY, 0xABCDEF, 0);
+
+	CHECK_EQUAL(OneWire_search_ROMs(roms, SIM_ONEWIRE_MAX_DEVICES), 4);
+
+	for(uint8_t i = 0; i < 4; i++)
+	{
+		CHECK_EQUAL(Was_found(roms, 4, devices[i].rom), 1);
+	}
+
+	/* One pass per device, each bit by one triplet */
+	CHECK_EQUAL(sim_onewire_resets, 4);
+	CHECK_EQUAL(sim_onewire_triplets, 4 * 64);
+
+	Get_OneWire_stats(&stats);
+	CHECK_EQUAL(stats.rom_crc_errors, 0);
+
+	/* Stops when caller has no room left */
+	CHECK_EQUAL(OneWire_search_ROMs(roms, 2), 2);
+}
+
+static void Search_corrupted_ROM(const void *arg)
+{
+	uint8_t roms[SIM_ONEWIRE_MAX_DEVICES][ONEWIRE_ROM_SIZE];
+	struct onewire_stats_struct stats;
+
+	Setup();
+
+	Add_sensor(0, SIM_DS18B20_FAMILY, 0x000010, 0);
+	Add_sensor(1, SIM_DS18B20_FAMILY, 0x000020, 0);
+	Add_sensor(2, SIM_DS18B20_FAMILY, 0x000030, 0);
+
+	/* Device answers with a code its CRC does not match */
+	devices[1].rom[7] ^= 0x01;
+
+	CHECK_EQUAL(OneWire_search_ROMs(roms, SIM_ONEWIRE_MAX_DEVICES), 2);
+	CHECK_EQUAL(Was_found(roms, 2, devices[0].rom), 1);
+	CHECK_EQUAL(Was_found(roms, 2, devices[2].rom), 1);
+
+	/* Dropped, search went on past it */
+	Get_OneWire_stats(&stats);
+	CHECK_EQUAL(stats.rom_crc_errors, 1);
+	CHECK_EQUAL(sim_onewire_resets, 3);
+}
+
+static void Empty_bus(const void *arg)
+{
+	uint8_t roms[SIM_ONEWIRE_MAX_DEVICES][ONEWIRE_ROM_SIZE];
+
+	Setup();
+
+	CHECK_EQUAL(OneWire_search_ROMs(roms, SIM_ONEWIRE_MAX_DEVICES), 0);
+	CHECK(Init_ext_temp_sens(EXT_TEMP_MAX_RESOLUTION) == FALSE);
+	CHECK_EQUAL(Get_ext_temp_sensor_count(), 0);
+	CHECK(Ext_temp_start_measurement() == FALSE);
+}
+
+static void One_conversion_window(const void *arg)
+{
+	uint32_t elapsed = 0;
+	uint32_t conversion = SCHEDULER_US_TO_COUNTS(SIM_DS18B20_CONVERSION_US(EXT_TEMP_MAX_RESOLUTION));
+
+	Setup();
+
+	/* 25.0625, -25.0625 and 125*C, serial number device in between */
+	Add_sensor(0, SIM_DS18B20_FAMILY, 0x000001, 0x0191);
+	Add_sensor(1, SIM_DS18B20_FAMILY, 0x000002, (int16_t)0xFE6F);
+	Add_sensor(2, SIM_DS2401_FAMILY, 0x000003, 0);
+	Add_sensor(3, SIM_DS28EA00_FAMILY, 0x000004, 0x07D0);
+
+	CHECK(Init_ext_temp_sens(EXT_TEMP_MAX_RESOLUTION) == TRUE);
+	CHECK_EQUAL(Get_ext_temp_sensor_count(), 3);
+
+#if EXT_TEMP_OVERDRIVE_ENABLED == TRUE
+	/* Probe is heard by all, but sent only for the DS28EA00 */
+	CHECK_EQUAL(devices[3].overdrive_commands, 1);
+#endif
+
+	/* Configuration went to all sensors at once */
+	CHECK_EQUAL(devices[0].config, SIM_DS18B20_CONFIG(EXT_TEMP_MAX_RESOLUTION));
+	CHECK_EQUAL(devices[3].config, SIM_DS18B20_CONFIG(EXT_TEMP_MAX_RESOLUTION));
+
+	CHECK_EQUAL(Measure(&elapsed), EXT_TEMP_DONE);
+
+	CHECK(Was_measured(251) == TRUE);
+	CHECK(Was_measured(-251) == TRUE);
+	CHECK(Was_measured(1250) == TRUE);
+
+	/* One broadcast CONVERT T, each sensor read by own MATCH ROM */
+	CHECK_EQUAL(devices[0].conversions, 1);
+	CHECK_EQUAL(devices[1].conversions, 1);
+	CHECK_EQUAL(devices[3].conversions, 1);
+	CHECK_EQUAL(devices[0].scratchpad_reads, 1);
+	CHECK_EQUAL(devices[1].scratchpad_reads, 1);
+
+#if EXT_TEMP_OVERDRIVE_ENABLED == TRUE
+	/* Overdrive capable one was read at overdrive speed */
+	CHECK(devices[3].overdrive_matches >= 2);
+#else
+	/* Bus stays at standard speed */
+	CHECK_EQUAL(devices[3].overdrive_commands, 0);
+	CHECK_EQUAL(devices[3].overdrive_matches, 0);
+#endif
+
+	/* Done is seen within one poll period, then reads follow */
+	CHECK_RANGE(Get_ext_temp_conversion_time(), conversion, conversion + SCHEDULER_US_TO_COUNTS(EXT_TEMP_READY_POLL_PERIOD) + 10);
+	CHECK(elapsed < (Get_ext_temp_conversion_time() + (3 * SENSOR_READ_BUDGET)));
+	CHECK(elapsed < (2 * conversion));
+
+	printf("  3 sensors: %u counts, conversion %u counts\n", elapsed, Get_ext_temp_conversion_time());
+}
+
+static void Sensor_lost_configuration(const void *arg)
+{
+	uint32_t elapsed = 0;
+
+	Setup();
+
+	Add_sensor(0, SIM_DS18B20_FAMILY, 0x000001, 0x0191);
+	Add_sensor(1, SIM_DS18B20_FAMILY, 0x000002, 0x00A2);
+
+	/* Factory set to 9-bit */
+	devices[0].eeprom_config = SIM_DS18B20_CONFIG(9);
+
+	CHECK(Init_ext_temp_sens(EXT_TEMP_MAX_RESOLUTION) == TRUE);
+	CHECK_EQUAL(devices[0].config, SIM_DS18B20_CONFIG(EXT_TEMP_MAX_RESOLUTION));
+
+	/* Brown-out after init */
+	Sim_OneWire_power_up(&devices[0]);
+
+	/* Converted at 9-bit, reported resolution is used */
+	CHECK_EQUAL(Measure(&elapsed), EXT_TEMP_DONE);
+	CHECK(Was_measured(250) == TRUE);
+	CHECK(Was_measured(101) == TRUE);
+	CHECK_EQUAL(ext_temp_reconfigurations, 1);
+
+	/* Configuration is written again before next conversion */
+	CHECK_EQUAL(Measure(&elapsed), EXT_TEMP_DONE);
+	CHECK_EQUAL(devices[0].config, SIM_DS18B20_CONFIG(EXT_TEMP_MAX_RESOLUTION));
+	CHECK(Was_measured(251) == TRUE);
+	CHECK_EQUAL(ext_temp_reconfigurations, 1);
+}
+
+static void Corrupted_scratchpad(const void *arg)
+{
+	uint32_t elapsed = 0;
+	int16_t temperature;
+
+	Setup();
+
+	Add_sensor(0, SIM_DS18B20_FAMILY, 0x000001, 0x0191);
+	Add_sensor(1, SIM_DS18B20_FAMILY, 0x000002, 0x00A2);
+
+	CHECK(Init_ext_temp_sens(EXT_TEMP_MAX_RESOLUTION) == TRUE);
+
+	devices[0].corrupt_reads = 1;
+
+	/* Only the sensor with bad CRC is invalid */
+	CHECK_EQUAL(Measure(&elapsed), EXT_TEMP_DONE);
+	CHECK(Was_measured(101) == TRUE);
+	CHECK(Was_measured(251) == FALSE);
+
+	uint8_t valid = 0;
+
+	for(uint8_t i = 0; i < Get_ext_temp_sensor_count(); i++)
+	{
+		valid += Ext_temp_read_temperature(i, &temperature);
+	}
+
+	CHECK_EQUAL(valid, 1);
+
+	/* Next read is clean */
+	CHECK_EQUAL(Measure(&elapsed), EXT_TEMP_DONE);
+	CHECK(Was_measured(251) == TRUE);
+	CHECK(Was_measured(101) == TRUE);
+}
+
+static void Parasite_powered(const void *arg)
+{
+	uint32_t elapsed = 0;
+
+	Setup();
+
+	Add_sensor(0, SIM_DS18B20_FAMILY, 0x000001, 0x0191);
+	Add_sensor(1, SIM_DS18B20_FAMILY, 0x000002, (int16_t)0xFF5E);
+
+	devices[1].parasite = TRUE;
+
+	CHECK(Init_ext_temp_sens(EXT_TEMP_MAX_RESOLUTION) == TRUE);
+
+	/* Strong pull-up held for the whole conversion, otherwise 85*C */
+	CHECK_EQUAL(Measure(&elapsed), EXT_TEMP_DONE);
+	CHECK(Was_measured(251) == TRUE);
+	CHECK(Was_measured(-101) == TRUE);
+	CHECK(Was_measured(850) == FALSE);
+
+	/* Can not be polled, nominal time is waited */
+	CHECK(Get_ext_temp_conversion_time() >= (SCHEDULER_US_TO_COUNTS(93750) << (EXT_TEMP_MAX_RESOLUTION - EXT_TEMP_MIN_RESOLUTION)));
+}
+
+int main(void)
+{
+	Test_isolated("search", Search, NULL);
+	Test_isolated("search corrupted ROM", Search_corrupted_ROM, NULL);
+	Test_isolated("empty bus", Empty_bus, NULL);
+	Test_isolated("one conversion window", One_conversion_window, NULL);
+	Test_isolated("sensor lost configuration", Sensor_lost_configuration, NULL);
+	Test_isolated("corrupted scratchpad", Corrupted_scratchpad, NULL);
+	Test_isolated("parasite powered", Parasite_powered, NULL);
+
+	return Test_summary((EXT_TEMP_OVERDRIVE_ENABLED == TRUE) ? "test_onewire_od" : "test_onewire");
+}
@@ -0,0 +1,482 @@
+/*
+ * test_rtc_drv.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* RTC driver against a simulated DS3231, bus traffic of the register shadow */
+
+#include "test_common.h"
+
+#include "../Clock/common_defs.h"
+#include "../Clock/i2c_drv.h"
+#include "../Clock/rtc_drv.h"
+#include "../Clock/scheduler.h"
+
+#include "sim_ds3231.h"
+
+/* Before the shadow: status read, control, status and aging one by one, */
+/* both alarms and time each in own burst, always 3 + 1 or 2 + len bytes */
+#define SEPARATE_INIT_TRANSACTIONS		7
+#define SEPARATE_INIT_BYTES				(4 + 3 + 3 + 3 + 6 + 5 + 9)
+
+/* Time and temperature were read together, each with own transaction */
+#define SEPARATE_READ_TRANSACTIONS		2
+#define SEPARATE_READ_BYTES				(10 + 5)
+
+/* Control register, as driver sets it */
+#define CONTROL_VALUE					((RTC_SQW_ENABLED == TRUE) ? 0x00 : 0x04)
+
+/* Main loop: other work between passes */
+#define LOOP_IDLE_US					20
+
+/* Host cycles, 16MHz core */
+#define CYCLES_PER_US					16
+
+static void Setup(void)
+{
+	Sim_I2C_init();
+	Sim_DS3231_init();
+
+	Init_I2C();
+}
+
+/* Main loop passes, until queued RTC transfers are done */
+static void Run_RTC_requests(volatile struct rtc_data_struct *rtc_data)
+{
+	do
+	{
+		Host_run_us(LOOP_IDLE_US);
+
+		Manage_I2C();
+		Manage_RTC(rtc_data);
+	}
+	while(Is_RTC_idle() == FALSE);
+}
+
+static void Check_bus_stats(void)
+{
+	struct rtc_bus_stats_struct stats;
+
+	/* Driver counts the same traffic the DS3231 saw */
+	Get_RTC_bus_stats(&stats);
+
+	CHECK_EQUAL(stats.read_transactions + stats.write_transactions, sim_ds3231.transactions);
+	CHECK_EQUAL(stats.bytes, sim_ds3231.bytes);
+}
+
+static void Init_after_power_loss(const void *arg)
+{
+	static const uint8_t expected[SIM_DS3231_NUM_OF_REGS - 2] =
+	{
+		0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x25,	/* 00:00:00 1.1.2025 */
+		0x00, 0x00, 0x00, 0x01,						/* Alarm 1 */
+		0x00, 0x00, 0x01,							/* Alarm 2 */
+		CONTROL_VALUE, 0x00, 0x00					/* 1Hz SQW or INT, flags cleared, no aging offset */
+	};
+
+	Setup();
+
+	CHECK(Init_RTC() == TRUE);
+
+	for(uint8_t i = 0; i < sizeof(expected); i++)
+	{
+		CHECK_EQUAL(sim_ds3231_regs[i], expected[i]);
+	}
+
+	/* Status read, then time and configuration in one burst */
+	CHECK_EQUAL(sim_ds3231.transactions, 2);
+	CHECK_EQUAL(sim_ds3231.bytes, (3 + 1) + (2 + sizeof(expected)));
+
+	CHECK(sim_ds3231.transactions < SEPARATE_INIT_TRANSACTIONS);
+	CHECK(sim_ds3231.bytes < SEPARATE_INIT_BYTES);
+
+	Check_bus_stats();
+
+	printf("  init: %u transactions, %u bytes, were %u and %u\n",
+			sim_ds3231.transactions, sim_ds3231.bytes, SEPARATE_INIT_TRANSACTIONS, SEPARATE_INIT_BYTES);
+}
+
+static void Init_with_time_kept(const void *arg)
+{
+	Setup();
+
+	/* Battery kept time, set by older firmware without square wave */
+	sim_ds3231_regs[0x00] = 0x56;
+	sim_ds3231_regs[0x01] = 0x34;
+	sim_ds3231_regs[0x02] = 0x12;
+	sim_ds3231_regs[SIM_DS3231_STATUS] = 0x00;
+	sim_ds3231_regs[SIM_DS3231_CONTROL] = 0x04;
+
+	CHECK(Init_RTC() == TRUE);
+
+	/* Time is kept */
+	CHECK_EQUAL(sim_ds3231_regs[0x00], 0x56);
+	CHECK_EQUAL(sim_ds3231_regs[0x01], 0x34);
+	CHECK_EQUAL(sim_ds3231_regs[0x02], 0x12);
+	CHECK_EQUAL(sim_ds3231_regs[SIM_DS3231_CONTROL], CONTROL_VALUE);
+
+#if RTC_SQW_ENABLED == TRUE
+	/* Only control register is written, to enable square wave */
+	CHECK_EQUAL(sim_ds3231.transactions, 2);
+	CHECK_EQUAL(sim_ds3231.bytes, (3 + 1) + (2 + 1));
+#else
+	/* Status read only */
+	CHECK_EQUAL(sim_ds3231.transactions, 1);
+	CHECK_EQUAL(sim_ds3231.bytes, 3 + 1);
+#endif
+
+	Check_bus_stats();
+}
+
+static void RTC_absent(const void *arg)
+{
+	Sim_I2C_init();
+	Init_I2C();
+
+	CHECK(Init_RTC() == FALSE);
+}
+
+static void Time_read(const void *arg)
+{
+	struct rtc_data_struct rtc_data = {0};
+
+	Setup();
+
+	CHECK(Init_RTC() == TRUE);
+
+	sim_ds3231_regs[0x00] = 0x07;
+	sim_ds3231_regs[0x01] = 0x59;
+	sim_ds3231_regs[0x02] = 0x23;
+	sim_ds3231_regs[0x04] = 0x31;
+	sim_ds3231_regs[0x05] = 0x12;
+	sim_ds3231_regs[0x06] = 0x26;
+
+	uint32_t transactions = sim_ds3231.transactions;
+	uint32_t bytes = sim_ds3231.bytes;
+
+	CHECK(Get_RTC_data(&rtc_data) == TRUE);
+
+	CHECK_EQUAL(rtc_data.second, 0x07);
+	CHECK_EQUAL(rtc_data.minute, 0x59);
+	CHECK_EQUAL(rtc_data.hour, 0x23);
+	CHECK_EQUAL(rtc_data.date, 0x31);
+	CHECK_EQUAL(rtc_data.month, 0x12);
+	CHECK_EQUAL(rtc_data.year, 0x26);
+
+	/* Exactly the time window, temperature comes from cache */
+	CHECK_EQUAL(sim_ds3231.transactions - transactions, 1);
+	CHECK_EQUAL(sim_ds3231.bytes - bytes, 3 + 7);
+
+	CHECK((sim_ds3231.transactions - transactions) < SEPARATE_READ_TRANSACTIONS);
+	CHECK((sim_ds3231.bytes - bytes) < SEPARATE_READ_BYTES);
+
+	Check_bus_stats();
+}
+
+static void Background_read(const void *arg)
+{
+	struct rtc_data_struct rtc_data = {0};
+	uint32_t read_time = 0;
+	uint8_t status;
+
+	Setup();
+
+	CHECK(Init_RTC() == TRUE);
+
+	sim_ds3231_regs[0x00] = 0x42;
+	sim_ds3231_regs[0x01] = 0x17;
+
+	uint32_t submit_time = Get_scheduler_time();
+
+	CHECK(Start_RTC_data_read() == TRUE);
+
+	/* One read at a time */
+	CHECK(Start_RTC_data_read() == FALSE);
+
+	do
+	{
+		Manage_I2C();
+
+		status = Get_RTC_data_read(&rtc_data, &read_time);
+	}
+	while((status == I2C_REQ_QUEUED) || (status == I2C_REQ_BUSY));
+
+	CHECK_EQUAL(status, I2C_REQ_DONE);
+	CHECK_EQUAL(rtc_data.second, 0x42);
+	CHECK_EQUAL(rtc_data.minute, 0x17);
+
+	/* Started right away, bus was free */
+	CHECK_RANGE(read_time - submit_time, 0, 1);
+
+	/* Result taken, next read may start */
+	CHECK_EQUAL(Get_RTC_data_read(&rtc_data, &read_time), I2C_REQ_IDLE);
+	CHECK(Start_RTC_data_read() == TRUE);
+
+	Check_bus_stats();
+}
+
+static void Temperature(const void *arg)
+{
+	struct rtc_data_struct rtc_data = {0};
+
+	Setup();
+
+	CHECK(Init_RTC() == TRUE);
+
+	CHECK_EQUAL(Get_RTC_temp_age(), 0xFFFFFFFF);
+
+	/* -10.25*C */
+	Sim_DS3231_set_temperature(-41);
+
+	uint32_t transactions = sim_ds3231.transactions;
+
+	/* Queued, nothing on the bus yet */
+	CHECK(Start_RTC_temp_conversion() == TRUE);
+	CHECK(Start_RTC_temp_conversion() == FALSE);
+	CHECK_EQUAL(sim_ds3231.transactions - transactions, 0);
+
+	/* Status read, control write */
+	Run_RTC_requests(&rtc_data);
+	CHECK_EQUAL(sim_ds3231.transactions - transactions, 2);
+
+	/* Busy, status read only */
+	CHECK(Start_RTC_temp_conversion() == TRUE);
+	Run_RTC_requests(&rtc_data);
+	CHECK_EQUAL(sim_ds3231.transactions - transactions, 3);
+
+	Host_run_us((SIM_DS3231_CONVERSION_MS + 5) * 1000);
+
+	CHECK_EQUAL(sim_ds3231_conversions, 1);
+
+	/* Only CONV bit was set for the conversion */
+	CHECK_EQUAL(sim_ds3231_regs[SIM_DS3231_CONTROL], CONTROL_VALUE);
+
+	uint32_t bytes = sim_ds3231.bytes;
+
+	CHECK(Start_RTC_temp_read() == TRUE);
+	CHECK(Start_RTC_temp_read() == FALSE);
+	Run_RTC_requests(&rtc_data);
+
+	/* Both temperature registers, quarter degrees rounded to tenths */
+	CHECK_EQUAL(sim_ds3231.bytes - bytes, 3 + 2);
+	CHECK_EQUAL(rtc_data.temperature, -103);
+	CHECK_EQUAL(Get_RTC_temp_age(), 0);
+
+	/* Cached for time reads */
+	CHECK(Get_RTC_data(&rtc_data) == TRUE);
+	CHECK_EQUAL(rtc_data.temperature, -103);
+
+	/* 25.25*C */
+	Sim_DS3231_set_temperature(101);
+
+	CHECK(Start_RTC_temp_conversion() == TRUE);
+	Run_RTC_requests(&rtc_data);
+
+	Host_run_us((SIM_DS3231_CONVERSION_MS + 5) * 1000);
+
+	CHECK(Start_RTC_temp_read() == TRUE);
+	Run_RTC_requests(&rtc_data);
+	CHECK_EQUAL(rtc_data.temperature, 253);
+
+	Check_bus_stats();
+}
+
+static void Time_set(const void *arg)
+{
+	struct rtc_data_struct rtc_data = {0};
+	struct rtc_data_struct new_time = {0x26, 0x10, 0x17, 0x21, 0x45, 0x30, 0};
+	uint32_t read_time = 0;
+	uint8_t status;
+
+	Setup();
+
+	CHECK(Init_RTC() == TRUE);
+
+	uint32_t transactions = sim_ds3231.transactions;
+	uint32_t bytes = sim_ds3231.bytes;
+
+	/* Queued, main loop is not held */
+	CHECK(Set_RTC_time(&new_time) == TRUE);
+	CHECK_EQUAL(sim_ds3231.transactions - transactions, 0);
+	CHECK(Is_RTC_idle() == FALSE);
+
+	/* Time read would overtake the write */
+	CHECK(Start_RTC_data_read() == FALSE);
+
+	/* Time and configuration in one burst */
+	Run_RTC_requests(&rtc_data);
+
+	CHECK_EQUAL(sim_ds3231.transactions - transactions, 1);
+	CHECK_EQUAL(sim_ds3231.bytes - bytes, 2 + (SIM_DS3231_NUM_OF_REGS - 2));
+
+	CHECK_EQUAL(sim_ds3231_regs[0x00], 0x30);
+	CHECK_EQUAL(sim_ds3231_regs[0x01], 0x45);
+	CHECK_EQUAL(sim_ds3231_regs[0x02], 0x21);
+	CHECK_EQUAL(sim_ds3231_regs[0x04], 0x17);
+	CHECK_EQUAL(sim_ds3231_regs[0x05], 0x10);
+	CHECK_EQUAL(sim_ds3231_regs[0x06], 0x26);
+	CHECK_EQUAL(sim_ds3231_regs[SIM_DS3231_CONTROL], CONTROL_VALUE);
+
+	/* Read back what was written */
+	CHECK(Start_RTC_data_read() == TRUE);
+
+	do
+	{
+		Manage_I2C();
+
+		status = Get_RTC_data_read(&rtc_data, &read_time);
+	}
+	while((status == I2C_REQ_QUEUED) || (status == I2C_REQ_BUSY));
+
+	CHECK_EQUAL(status, I2C_REQ_DONE);
+	CHECK_EQUAL(rtc_data.second, 0x30);
+	CHECK_EQUAL(rtc_data.hour, 0x21);
+	CHECK_EQUAL(rtc_data.year, 0x26);
+
+	Check_bus_stats();
+}
+
+static void Failed_write_retried(const void *arg)
+{
+	struct rtc_data_struct rtc_data = {0};
+	struct rtc_data_struct new_time = {0x26, 0x10, 0x17, 0x21, 0x45, 0x30, 0};
+
+	Setup();
+
+	CHECK(Init_RTC() == TRUE);
+
+	/* Write fails, as if bus failed mid-transfer */
+	sim_ds3231_nack_data = TRUE;
+
+	CHECK(Set_RTC_time(&new_time) == TRUE);
+	Run_RTC_requests(&rtc_data);
+
+	CHECK_EQUAL(sim_ds3231_regs[0x02], 0x00);
+
+	/* Given up until next flush, time reads go on */
+	CHECK(Is_RTC_idle() == TRUE);
+	CHECK(Start_RTC_data_read() == TRUE);
+
+	sim_ds3231_nack_data = FALSE;
+
+	uint32_t bytes = sim_ds3231.bytes;
+
+	/* Next write carries the failed registers along */
+	CHECK(Start_RTC_temp_conversion() == TRUE);
+	Run_RTC_requests(&rtc_data);
+
+	CHECK_EQUAL(sim_ds3231_regs[0x00], 0x30);
+	CHECK_EQUAL(sim_ds3231_regs[0x02], 0x21);
+	CHECK_EQUAL(sim_ds3231_regs[0x06], 0x26);
+
+	/* Time read, status read, then time, configuration and CONV in one burst */
+	CHECK_EQUAL(sim_ds3231.bytes - bytes, (3 + 7) + (3 + 1) + (2 + (SIM_DS3231_NUM_OF_REGS - 2)));
+
+	Host_run_us((SIM_DS3231_CONVERSION_MS + 5) * 1000);
+
+	CHECK_EQUAL(sim_ds3231_conversions, 1);
+
+	bytes = sim_ds3231.bytes;
+
+	CHECK(Start_RTC_temp_read() == TRUE);
+	Run_RTC_requests(&rtc_data);
+
+	CHECK_EQUAL(sim_ds3231.bytes - bytes, 3 + 2);
+}
+
+/* One main loop pass, as Run() does it, longest wait for the bus in us; code itself runs in no time on host */
+static uint32_t Loop_latency(uint8_t async, uint8_t task)
+{
+	struct rtc_data_struct rtc_data = {0x26, 0x10, 0x17, 0x21, 0x45, 0x30, 0};
+	uint64_t longest = 0;
+
+	switch(task)
+	{
+		case 0:
+			CHECK(Set_RTC_time(&rtc_data) == TRUE);
+			break;
+
+		case 1:
+			CHECK(Start_RTC_temp_conversion() == TRUE);
+			break;
+
+		default:
+			CHECK(Start_RTC_temp_read() == TRUE);
+			break;
+	}
+
+	do
+	{
+		Host_run_us(LOOP_IDLE_US);
+
+		uint64_t start = Host_get_cycles();
+
+		Manage_I2C();
+		Manage_RTC(&rtc_data);
+
+		/* Without the engine, pass waits for the transfer */
+		if(async == FALSE)
+		{
+			while(Is_RTC_idle() == FALSE)
+			{
+				Manage_I2C();
+				Manage_RTC(&rtc_data);
+			}
+		}
+
+		if((Host_get_cycles() - start) > longest)
+		{
+			longest = Host_get_cycles() - start;
+		}
+	}
+	while(Is_RTC_idle() == FALSE);
+
+	return (uint32_t)(longest / CYCLES_PER_US);
+}
+
+static void Main_loop_latency(const void *arg)
+{
+	static const char *tasks[] = {"time set", "temperature conversion", "temperature read"};
+	uint32_t blocking[3];
+	uint32_t background[3];
+
+	Setup();
+
+	CHECK(Init_RTC() == TRUE);
+
+	for(uint8_t task = 0; task < 3; task++)
+	{
+		blocking[task] = Loop_latency(FALSE, task);
+
+		/* Conversion has to end, else status read finds it busy and skips the write */
+		Host_run_us((SIM_DS3231_CONVERSION_MS + 5) * 1000);
+
+		background[task] = Loop_latency(TRUE, task);
+
+		Host_run_us((SIM_DS3231_CONVERSION_MS + 5) * 1000);
+
+		/* Pass only submits or takes result, bus time is not spent in it */
+		CHECK(background[task] < blocking[task]);
+
+		printf("  %s: run_loop_time up to %u us, was %u us without the engine\n", tasks[task], background[task], blocking[task]);
+	}
+
+	Check_bus_stats();
+}
+
+int main(void)
+{
+	Test_isolated("init after power loss", Init_after_power_loss, NULL);
+	Test_isolated("init with time kept", Init_with_time_kept, NULL);
+	Test_isolated("RTC absent", RTC_absent, NULL);
+	Test_isolated("time read", Time_read, NULL);
+	Test_isolated("background read", Background_read, NULL);
+	Test_isolated("temperature", Temperature, NULL);
+	Test_isolated("time set", Time_set, NULL);
+	Test_isolated("failed write retried", Failed_write_retried, NULL);
+	Test_isolated("main loop latency", Main_loop_latency, NULL);
+
+	return Test_summary((RTC_SQW_ENABLED == TRUE) ? "test_rtc_drv_sqw" : "test_rtc_drv");
+}
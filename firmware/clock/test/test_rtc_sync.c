@@ -0,0 +1,291 @@
+/*
+ * test_rtc_sync.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* Drift replay of RTC sync: a DS3231 drifting against TIM14, read the way Manage_RTC_read does */
+
+#include <math.h>
+
+#include "test_common.h"
+
+#include "../Clock/common_defs.h"
+#include "../Clock/rtc_sync.h"
+#include "../Clock/scheduler.h"
+
+/* Main loop pass, bus wait before the read starts and read duration, in TIM14 counts */
+#define LOOP_PERIOD				10
+#define READ_START_JITTER		30
+#define READ_DURATION			80
+
+/* Time to lock and learn RTC second, then tracking is checked */
+#define WARMUP_SECONDS			60
+
+/* Display may differ from RTC only around the rollover, far below one 32Hz frame */
+#define MAX_MISMATCH			1000	//counts
+
+/* Time unlocked after warmup, only relocking at resyncs */
+#define MAX_UNLOCKED_SHARE		0.1
+
+struct replay_struct
+{
+	const char *name;
+	double ppm_start;		/* RTC rate against TIM14 */
+	double ppm_end;			/* Linear change over the run, e.g. HSI warming up */
+	uint32_t seconds;
+	uint8_t sqw;
+	uint32_t sqw_lost_at;	/* Second when square wave stops, 0 if never */
+	double second_tolerance;	/* Learned RTC second, counts */
+};
+
+static double rtc_phase;	/* RTC seconds since start, fraction is position in the second */
+static double rtc_ppm;
+static uint64_t rtc_phase_cycles = 0;
+
+static uint32_t random_state = 12345;
+
+static uint32_t Random(uint32_t range)
+{
+	random_state = random_state * 1103515245 + 12345;
+
+	return (random_state >> 16) % range;
+}
+
+static uint8_t To_BCD(uint32_t value)
+{
+	return (uint8_t)(((value / 10) << 4) | (value % 10));
+}
+
+static uint32_t Now(void)
+{
+	return (uint32_t)(Host_get_cycles() / HOST_CYCLES_PER_COUNT);
+}
+
+/* RTC follows simulated time, also what register accesses took */
+static void Update_RTC(void)
+{
+	uint64_t cycles = Host_get_cycles();
+
+	rtc_phase += ((cycles - rtc_phase_cycles) * (1.0 + (rtc_ppm * 1e-6))) / HOST_CORE_CLOCK;
+	rtc_phase_cycles = cycles;
+}
+
+static uint32_t RTC_seconds(void)
+{
+	Update_RTC();
+
+	return (uint32_t)floor(rtc_phase);
+}
+
+/* Advance TIM14 and RTC, stop at the next rollover */
+static uint8_t Advance(uint32_t counts)
+{
+	Update_RTC();
+
+	double rate = (1.0 + (rtc_ppm * 1e-6)) / SCHEDULER_TIMER_FREQUENCY;
+	double to_rollover = (floor(rtc_phase) + 1.0 - rtc_phase) / rate;
+	uint8_t rollover = FALSE;
+
+	if(to_rollover <= counts)
+	{
+		counts = (uint32_t)ceil(to_rollover);
+		rollover = TRUE;
+	}
+
+	Host_run_cycles((uint64_t)counts * HOST_CYCLES_PER_COUNT);
+	Update_RTC();
+
+	return rollover;
+}
+
+static void Replay(const void *arg)
+{
+	const struct replay_struct *replay = arg;
+	struct rtc_sync_stats_struct stats;
+	struct rtc_sync_stats_struct warm_stats;
+
+	/* Time kept in RAM, as absolute seconds */
+	uint32_t ram_seconds;
+
+	uint8_t read_pending = FALSE;
+	uint32_t read_start = 0;
+	uint32_t read_value = 0;
+
+	uint32_t reads = 0;
+	uint32_t warm_reads = 0;
+	uint8_t warm = FALSE;
+
+	/* Polling starts over, when square wave is lost */
+	uint32_t warmup_end = replay->sqw_lost_at + WARMUP_SECONDS;
+
+	uint32_t mismatch_start = 0;
+	uint8_t mismatch = FALSE;
+	uint32_t mismatch_max = 0;
+	uint32_t mismatches = 0;
+
+	uint32_t loops = 0;
+	uint32_t unlocked_loops = 0;
+
+	rtc_phase = 0.37;
+	rtc_ppm = replay->ppm_start;
+	rtc_phase_cycles = Host_get_cycles();
+
+	/* Clock starts with time from RTC */
+	ram_seconds = RTC_seconds();
+
+	Init_RTC_sync();
+
+	while(RTC_seconds() < replay->seconds)
+	{
+		uint32_t second = RTC_seconds();
+
+		rtc_ppm = replay->ppm_start + ((replay->ppm_end - replay->ppm_start) * second) / replay->seconds;
+
+		if((Advance(LOOP_PERIOD) == TRUE) && (replay->sqw == TRUE) &&
+				((replay->sqw_lost_at == 0) || (RTC_seconds() < replay->sqw_lost_at)))
+		{
+			/* Falling edge of SQW */
+			host_exti_pending |= LL_EXTI_LINE_4;
+
+			Host_enter_irq();
+			RTC_SQW_IRQ_handler();
+			Host_exit_irq();
+		}
+
+		/* Manage_RTC_read */
+		uint8_t elapsed_seconds = Take_RTC_elapsed_seconds();
+
+		if(elapsed_seconds > 0)
+		{
+			ram_seconds += elapsed_seconds;
+
+			RTC_sync_displayed();
+		}
+
+		if((read_pending == FALSE) && (Is_RTC_read_due() == TRUE))
+		{
+			/* Waits for bus, DS3231 latches time at the start of the transfer */
+			Advance(Random(READ_START_JITTER));
+
+			read_pending = TRUE;
+			read_start = Now();
+			read_value = RTC_seconds();
+
+			reads++;
+		}
+
+		if((read_pending == TRUE) && ((Now() - read_start) >= READ_DURATION))
+		{
+			read_pending = FALSE;
+
+			/* RTC may be at most one second ahead of time kept in RAM */
+			uint8_t time_matches = ((read_value == ram_seconds) || (read_value == (ram_seconds + 1))) ? TRUE : FALSE;
+
+			ram_seconds = read_value;
+
+			if(RTC_sync_update(To_BCD(read_value % 60), read_start, time_matches) == TRUE)
+			{
+				RTC_sync_displayed();
+			}
+		}
+
+		Manage_RTC_sync_latency();
+
+		if((warm == FALSE) && (RTC_seconds() >= warmup_end))
+		{
+			warm = TRUE;
+			warm_reads = reads;
+
+			Get_RTC_sync_stats(&warm_stats);
+		}
+
+		/* Shown time against RTC, after lock */
+		if(warm == TRUE)
+		{
+			loops++;
+
+			if(Is_RTC_sync_locked() == FALSE)
+			{
+				unlocked_loops++;
+			}
+
+			if(ram_seconds != RTC_seconds())
+			{
+				if(mismatch == FALSE)
+				{
+					mismatch = TRUE;
+					mismatch_start = Now();
+					mismatches++;
+				}
+
+				if((Now() - mismatch_start) > mismatch_max)
+				{
+					mismatch_max = Now() - mismatch_start;
+				}
+			}
+			else
+			{
+				mismatch = FALSE;
+			}
+		}
+	}
+
+	Get_RTC_sync_stats(&stats);
+
+	double tracked_seconds = replay->seconds - warmup_end;
+	double reads_per_second = (reads - warm_reads) / tracked_seconds;
+	double expected_second = SCHEDULER_TIMER_FREQUENCY / (1.0 + (rtc_ppm * 1e-6));
+
+	double unlocked_share = (double)unlocked_loops / loops;
+
+	printf("  %s: %u reads, %.3f reads/s after lock, RTC second %u (%.1f), %u resyncs, max error %u, "
+			"mismatch max %u counts in %u episodes, unlocked %.1f%%, latency max %u\n",
+			replay->name, reads, reads_per_second, stats.rtc_second, expected_second, stats.resyncs,
+			stats.max_error, mismatch_max, mismatches, unlocked_share * 100.0, stats.latency_max);
+
+	/* Display follows RTC, only briefly off around rollovers */
+	CHECK_RANGE(mismatch_max, 0, MAX_MISMATCH);
+	CHECK(unlocked_share < MAX_UNLOCKED_SHARE);
+
+	/* Nothing lost once locked */
+	CHECK_EQUAL(stats.lost_locks, warm_stats.lost_locks);
+	CHECK_EQUAL(stats.discrepancies, warm_stats.discrepancies);
+
+	/* Far below 4 reads a second of plain polling */
+	CHECK(reads_per_second < 0.1);
+
+	if((replay->sqw == FALSE) || (replay->sqw_lost_at != 0))
+	{
+		/* Learned RTC second, lags behind a drifting HSI */
+		CHECK_RANGE(stats.rtc_second, expected_second - replay->second_tolerance, expected_second + replay->second_tolerance);
+		CHECK(stats.resyncs > 0);
+	}
+}
+
+static const struct replay_struct replays[] =
+{
+	{"polling, 0ppm",				0.0,	0.0,	600,	FALSE,	0,		3.0},
+	{"polling, +20ppm",				20.0,	20.0,	600,	FALSE,	0,		3.0},
+	{"polling, -150ppm",			-150.0,	-150.0,	600,	FALSE,	0,		3.0},
+	{"polling, +8000ppm HSI",		8000.0,	8000.0,	600,	FALSE,	0,		3.0},
+	{"polling, -8000ppm HSI",		-8000.0,-8000.0,600,	FALSE,	0,		3.0},
+	{"polling, HSI warming up",		-300.0,	300.0,	1200,	FALSE,	0,		15.0},
+	{"square wave, +50ppm",			50.0,	50.0,	600,	TRUE,	0,		0.0},
+	{"square wave lost",			50.0,	50.0,	600,	TRUE,	200,	3.0}
+};
+
+int main(void)
+{
+	for(uint32_t i = 0; i < (sizeof(replays) / sizeof(replays[0])); i++)
+	{
+		/* Square wave replays run in the build with it enabled */
+		if(replays[i].sqw == RTC_SQW_ENABLED)
+		{
+			Test_isolated(replays[i].name, Replay, &replays[i]);
+		}
+	}
+
+	return Test_summary((RTC_SQW_ENABLED == TRUE) ? "test_rtc_sync_sqw" : "test_rtc_sync");
+}
@@ -0,0 +1,176 @@
+/*
+ * test_temp.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: trwgQ26xxx
+ */
+
+/* Fixed-point temperatures to tenths of *C, every code of the DS18B20 range against exact rounding */
+
+#include "test_common.h"
+
+#include <math.h>
+
+#include "../Clock/common_defs.h"
+#include "../Clock/common_fcns.h"
+#include "../Clock/i2c_drv.h"
+#include "../Clock/onewire_bridge_drv.h"
+#include "../Clock/ext_temp_sens_drv.h"
+#include "../Clock/scheduler.h"
+
+#include "sim_ds2482.h"
+
+/* DS18B20 datasheet range, -55 to 125*C in 1/16 *C */
+#define DS18B20_CODE_MIN			((int16_t)0xFC90)
+#define DS18B20_CODE_MAX			((int16_t)0x07D0)
+#define DS18B20_FRAC_BITS			4
+
+/* DS3231 register range, -128 to 127.75*C in 1/4 *C */
+#define DS3231_CODE_MIN				-512
+#define DS3231_CODE_MAX				511
+#define DS3231_FRAC_BITS			2
+
+#define NUM_OF_SENSORS				EXT_TEMP_MAX_SENSORS
+
+/* Idle time skipped per main loop pass, well below ready poll period */
+#define LOOP_IDLE_US				100
+
+static struct sim_onewire_device_struct devices[NUM_OF_SENSORS];
+
+static int16_t Reference_tenths(int32_t code, uint8_t frac_bits)
+{
+	/* Exact in double, lround takes halves away from zero */
+	return (int16_t)lround((code * 10.0) / (1 << frac_bits));
+}
+
+static void DS18B20_codes(const void *arg)
+{
+	uint32_t mismatches = 0;
+
+	for(int32_t code = DS18B20_CODE_MIN; code <= DS18B20_CODE_MAX; code++)
+	{
+		if(FIXED_TO_TENTHS((int16_t)code, DS18B20_FRAC_BITS) != Reference_tenths(code, DS18B20_FRAC_BITS))
+		{
+			printf("  0x%04X: %d, expected %d\n", (uint16_t)code, FIXED_TO_TENTHS((int16_t)code, DS18B20_FRAC_BITS),
+					Reference_tenths(code, DS18B20_FRAC_BITS));
+			mismatches++;
+		}
+	}
+
+	CHECK_EQUAL(mismatches, 0);
+
+	/* Ends of the range */
+	CHECK_EQUAL(FIXED_TO_TENTHS(DS18B20_CODE_MIN, DS18B20_FRAC_BITS), -550);
+	CHECK_EQUAL(FIXED_TO_TENTHS(DS18B20_CODE_MAX, DS18B20_FRAC_BITS), 1250);
+}
+
+static void DS3231_codes(const void *arg)
+{
+	uint32_t mismatches = 0;
+
+	for(int32_t code = DS3231_CODE_MIN; code <= DS3231_CODE_MAX; code++)
+	{
+		if(FIXED_TO_TENTHS((int16_t)code, DS3231_FRAC_BITS) != Reference_tenths(code, DS3231_FRAC_BITS))
+		{
+			printf("  %d/4: %d, expected %d\n", code, FIXED_TO_TENTHS((int16_t)code, DS3231_FRAC_BITS),
+					Reference_tenths(code, DS3231_FRAC_BITS));
+			mismatches++;
+		}
+	}
+
+	CHECK_EQUAL(mismatches, 0);
+}
+
+static uint8_t Measure(void)
+{
+	uint8_t status;
+
+	if(Ext_temp_start_measurement() == FALSE)
+	{
+		return EXT_TEMP_FAILED;
+	}
+
+	do
+	{
+		status = Ext_temp_step();
+
+		Manage_I2C();
+
+		Host_run_us(LOOP_IDLE_US);
+	}
+	while(status == EXT_TEMP_BUSY);
+
+	return status;
+}
+
+static void DS18B20_codes_on_bus(const void *arg)
+{
+	uint8_t sensor_of_device[NUM_OF_SENSORS];
+	uint32_t mismatches = 0;
+	int16_t temperature;
+
+	Sim_I2C_init();
+	Sim_DS2482_init();
+
+	Init_I2C();
+
+	CHECK(Init_OneWire_bridge() == TRUE);
+
+	for(uint8_t i = 0; i < NUM_OF_SENSORS; i++)
+	{
+		devices[i].temperature = (int16_t)(i << DS18B20_FRAC_BITS);
+
+		Sim_OneWire_add_device(&devices[i], SIM_DS18B20_FAMILY, 0x000100 + i);
+	}
+
+	CHECK(Init_ext_temp_sens(EXT_TEMP_MAX_RESOLUTION) == TRUE);
+	CHECK_EQUAL(Get_ext_temp_sensor_count(), NUM_OF_SENSORS);
+
+	/* Sensors are numbered in search order, whole degrees tell which is which */
+	CHECK_EQUAL(Measure(), EXT_TEMP_DONE);
+
+	for(uint8_t i = 0; i < NUM_OF_SENSORS; i++)
+	{
+		CHECK(Ext_temp_read_temperature(i, &temperature) == TRUE);
+		CHECK_RANGE(temperature / 10, 0, NUM_OF_SENSORS - 1);
+
+		sensor_of_device[temperature / 10] = i;
+	}
+
+	/* Every code once, through scratchpad, CRC and resolution handling of the driver */
+	for(int32_t code = DS18B20_CODE_MIN; code <= DS18B20_CODE_MAX; code += NUM_OF_SENSORS)
+	{
+		for(uint8_t i = 0; i < NUM_OF_SENSORS; i++)
+		{
+			devices[i].temperature = (int16_t)((code + i <= DS18B20_CODE_MAX) ? (code + i) : DS18B20_CODE_MAX);
+		}
+
+		if(Measure() != EXT_TEMP_DONE)
+		{
+			mismatches++;
+			continue;
+		}
+
+		for(uint8_t i = 0; i < NUM_OF_SENSORS; i++)
+		{
+			if((Ext_temp_read_temperature(sensor_of_device[i], &temperature) == FALSE) ||
+			   (temperature != Reference_tenths(devices[i].temperature, DS18B20_FRAC_BITS)))
+			{
+				printf("  0x%04X: %d, expected %d\n", (uint16_t)devices[i].temperature, temperature,
+						Reference_tenths(devices[i].temperature, DS18B20_FRAC_BITS));
+				mismatches++;
+			}
+		}
+	}
+
+	CHECK_EQUAL(mismatches, 0);
+}
+
+int main(void)
+{
+	Test_isolated("DS18B20 codes", DS18B20_codes, NULL);
+	Test_isolated("DS3231 codes", DS3231_codes, NULL);
+	Test_isolated("DS18B20 codes on bus", DS18B20_codes_on_bus, NULL);
+
+	return Test_summary("test_temp");
+}